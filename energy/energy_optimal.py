@@ -0,0 +1,80 @@
+import os
+import re
+import glob
+from collections import defaultdict
+import numpy as np
+import matplotlib.pyplot as plt
+
+# Энергооптимальное число потоков по результатам run_threads.sh:
+# для каждой программы и размера сравниваются медианы времени и энергии
+
+BASE_DIR = os.path.dirname(os.path.abspath(__file__))
+RESULTS_DIR = os.path.join(BASE_DIR, "results")
+
+FILE_RE = re.compile(r"(?P<container>.+)_threads_(?P<threads>\d+)_size_(?P<size>\d+)\.txt$")
+
+
+def parse_runs(filepath):
+    """Возвращает списки времени, энергии и Дж/ГФЛОП по всем запускам в файле."""
+    times, energy, per_gflop = [], [], []
+    status = None
+    with open(filepath, 'r', encoding='utf-8') as f:
+        for line in f:
+            key, _, value = line.strip().partition('=')
+            if key == 'RESULT_SECONDS':
+                times.append(float(value))
+            elif key == 'DIAG_ENERGY_J':
+                energy.append(float(value))
+            elif key == 'DIAG_ENERGY_J_PER_GFLOP':
+                per_gflop.append(float(value))
+            elif key == 'DIAG_ENERGY_STATUS':
+                status = value
+    return times, energy, per_gflop, status
+
+
+data = defaultdict(dict)   # (container, size) -> threads -> (time, energy, J/GFLOP)
+for filepath in glob.glob(os.path.join(RESULTS_DIR, "*_threads_*_size_*.txt")):
+    match = FILE_RE.match(os.path.basename(filepath))
+    if not match:
+        continue
+    times, energy, per_gflop, status = parse_runs(filepath)
+    if not times:
+        continue
+    if not energy:
+        print(f"{os.path.basename(filepath)}: энергия недоступна ({status})")
+        continue
+    key = (match['container'], int(match['size']))
+    data[key][int(match['threads'])] = (np.median(times), np.median(energy), np.median(per_gflop))
+
+if not data:
+    raise SystemExit(f"Нет результатов с энергией в {RESULTS_DIR}")
+
+for (container, size), by_threads in sorted(data.items()):
+    fastest = min(by_threads, key=lambda t: by_threads[t][0])
+    greenest = min(by_threads, key=lambda t: by_threads[t][1])
+    print(f"\n{container}, n={size}")
+    print(f"{'потоки':>8} {'время, с':>12} {'энергия, Дж':>14} {'Дж/ГФЛОП':>10}")
+    for t in sorted(by_threads):
+        seconds, joules, j_per_gflop = by_threads[t]
+        mark = (" <- быстрее всего" if t == fastest else "") + (" <- меньше энергии" if t == greenest else "")
+        print(f"{t:>8} {seconds:>12.4f} {joules:>14.2f} {j_per_gflop:>10.4f}{mark}")
+
+# График: энергия от числа потоков для наибольшего размера каждой программы
+largest = {}
+for container, size in data:
+    largest[container] = max(size, largest.get(container, 0))
+
+plt.figure(figsize=(12, 8))
+for container, size in sorted(largest.items()):
+    by_threads = data[(container, size)]
+    threads = sorted(by_threads)
+    plt.plot(threads, [by_threads[t][1] for t in threads], marker='o', label=f"{container}, n={size}")
+plt.xscale('log', base=2)
+plt.xlabel('Число потоков')
+plt.ylabel('Энергия, Дж (package + dram)')
+plt.title('Энергия обращения в зависимости от числа потоков')
+plt.grid(True, which='both', linestyle='--', alpha=0.5)
+plt.legend()
+plt.tight_layout()
+plt.savefig(os.path.join(BASE_DIR, 'energy_threads.png'), dpi=150)
+plt.show()
@@ -0,0 +1,55 @@
+#!/bin/bash
+
+# Масштабирование по потокам с замером энергии (RAPL).
+# Docker по умолчанию закрывает /sys/devices/virtual/powercap (туда ведут ссылки
+# /sys/class/powercap), поэтому контейнеры запускаются с
+# --security-opt systempaths=unconfined: маскировка снимается, sysfs остаётся
+# только для чтения. energy_uj на новых ядрах читается только root, поэтому
+# контейнеры запускаются от root. Если счётчики всё же недоступны, программы
+# выводят DIAG_ENERGY_STATUS=unavailable:...
+
+# Список контейнеров
+containers=(
+	"lapack_chol"
+	"lapack_lu"
+	"lapack_mul"
+	"lapack_svd"
+	"mkl_chol"
+	"mkl_lu"
+	"mkl_mul"
+	"mkl_svd"
+)
+
+# Число потоков
+threads=(1 2 4 8 16)
+
+# Размеры матриц
+sizes=(5000 10000)
+
+# Количество запусков для каждой конфигурации
+runs=5
+
+mkdir -p results
+
+for container in "${containers[@]}"; do
+    for size in "${sizes[@]}"; do
+        for t in "${threads[@]}"; do
+            output_file="results/${container}_threads_${t}_size_${size}.txt"
+
+            for ((i=1; i<=runs; i++)); do
+                echo "Запуск контейнера $container ($t потоков) с размером матрицы $size, запуск номер $i..."
+
+                container_id=$(docker run -d --rm \
+                    --security-opt systempaths=unconfined \
+                    -e OPENBLAS_NUM_THREADS="$t" -e MKL_NUM_THREADS="$t" -e OMP_NUM_THREADS="$t" \
+                    "$container" "$size")
+
+                # Ожидаем завершения контейнера и записываем его вывод в файл
+                docker logs -f "$container_id" >> "$output_file"
+
+                # Ждем завершения контейнера
+                docker wait "$container_id"
+            done
+        done
+    done
+done
@@ -0,0 +1,21 @@
+#!/bin/bash
+# Build the Docker container
+
+# Function to build Docker container with error handling
+build_container() {
+    local container_name=$1
+    local dockerfile=$2
+
+    echo "Building Docker container: $container_name using $dockerfile..."
+    if ! docker build -t "$container_name" -f "$dockerfile" .; then
+        echo "Error: Building $container_name with $dockerfile failed."
+        exit 1
+    fi
+}
+
+# Соседи для режима помех; контейнеры программ собираются их build.sh
+echo "Building co-runner Docker container..."
+
+build_container "corunner" "Dockerfile.corunner"
+
+echo "All containers built successfully!"
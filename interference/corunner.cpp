@@ -0,0 +1,287 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <map>
+#include <random>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdlib>
+#include <csignal>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+// Соседи для режима помех: потоки с заданной нагрузкой закрепляются за
+// зарезервированными CPU и работают до SIGTERM/SIGINT (docker stop) или
+// --seconds. Нагрузки:
+// - stream – STREAM triad, занимает пропускную способность памяти;
+// - chase – случайный обход указателей по буферу больше L3, вытесняет общий кэш;
+// - fma – FMA-ядро в регистрах, занимает только вычислительные блоки.
+// Вывод – ключи CORUNNER_*: сколько нагрузки соседи реально создали
+
+#if defined(__AVX512F__)
+constexpr int lanes = 8;
+#elif defined(__AVX__)
+constexpr int lanes = 4;
+#else
+constexpr int lanes = 2;
+#endif
+typedef double vdouble __attribute__((vector_size(lanes * sizeof(double))));
+
+// Необязательные параметры вида --key=value
+std::map<std::string, std::string> parse_options(int argc, char* argv[], int first) {
+    std::map<std::string, std::string> options;
+    for (int i = first; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+            throw std::invalid_argument("Unknown argument: " + arg);
+        options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+    }
+    return options;
+}
+
+std::string option(const std::map<std::string, std::string>& options,
+                   const std::string& key, const std::string& fallback) {
+    auto it = options.find(key);
+    return it == options.end() ? fallback : it->second;
+}
+
+// Список CPU вида 0-3,8,10-11
+std::vector<int> parse_cpu_list(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty() || !isdigit((unsigned char)range[0]))
+            throw std::invalid_argument("Bad CPU list: " + list);
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+        for (int c = first; c <= last; ++c)
+            cpus.push_back(c);
+    }
+    return cpus;
+}
+
+// Размер L3 cpu0 из sysfs; 32 МБ, если не найден
+size_t l3_size() {
+    for (int index = 0; index < 8; ++index) {
+        std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+        std::ifstream level_file(dir + "level"), size_file(dir + "size");
+        int level;
+        std::string size;
+        if (!(level_file >> level) || !(size_file >> size) || level != 3)
+            continue;
+        size_t value = std::stoul(size);
+        char unit = size.back();
+        if (unit == 'K')
+            value <<= 10;
+        else if (unit == 'M')
+            value <<= 20;
+        return value;
+    }
+    return 32u << 20;
+}
+
+double now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::atomic<bool> stop{false};
+std::atomic<int> ready{0};
+std::atomic<double> sink{0.0};
+
+void on_signal(int) {
+    stop = true;
+}
+
+// Единицы работы потока: байты (stream), переходы (chase), FLOP (fma)
+struct Worker {
+    std::string kind;
+    int cpu;
+    std::atomic<double> work{0.0};
+    std::thread thread;
+};
+
+void pin(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+        std::cerr << "Cannot pin to CPU " << cpu << std::endl;
+}
+
+// STREAM triad a = b + s*c, 24 байта на элемент; массивы свои у каждого потока
+void stream_loop(Worker& w, size_t elements) {
+    std::unique_ptr<double[]> a(new double[elements]), b(new double[elements]), c(new double[elements]);
+    for (size_t i = 0; i < elements; ++i) {
+        a[i] = 0.0;
+        b[i] = 1.0;
+        c[i] = 2.0;
+    }
+    ++ready;
+    const double scalar = 3.0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        double* __restrict pa = a.get();
+        const double* __restrict pb = b.get();
+        const double* __restrict pc = c.get();
+        for (size_t i = 0; i < elements; ++i)
+            pa[i] = pb[i] + scalar * pc[i];
+        w.work = w.work + 3.0 * sizeof(double) * elements;
+    }
+    sink = sink + a[elements / 2];
+}
+
+// Обход одного цикла случайной перестановки (Саттоло): каждый переход – новая
+// строка кэша, и предвыборка его не угадывает
+struct alignas(64) Node {
+    size_t next;
+    char pad[64 - sizeof(size_t)];
+};
+
+void chase_loop(Worker& w, size_t nodes) {
+    std::vector<Node> buffer(nodes);
+    std::vector<size_t> order(nodes);
+    for (size_t i = 0; i < nodes; ++i)
+        order[i] = i;
+    std::mt19937_64 gen(w.cpu + 1);
+    for (size_t i = nodes - 1; i > 0; --i)
+        std::swap(order[i], order[std::uniform_int_distribution<size_t>(0, i - 1)(gen)]);
+    for (size_t i = 0; i < nodes; ++i)
+        buffer[order[i]].next = order[(i + 1) % nodes];
+    ++ready;
+
+    constexpr long steps = 1 << 16;
+    size_t p = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        for (long s = 0; s < steps; ++s)
+            p = buffer[p].next;
+        w.work = w.work + steps;
+    }
+    sink = sink + p;
+}
+
+// FMA-ядро из roofline: 12 независимых аккумуляторов, acc = acc * m + a
+void fma_loop(Worker& w) {
+    constexpr int accumulators = 12;
+    constexpr long iterations = 1 << 20;
+    vdouble acc[accumulators];
+    vdouble m, a;
+    for (int l = 0; l < lanes; ++l) {
+        m[l] = 0.999999;
+        a[l] = 0.000001;
+    }
+    for (int k = 0; k < accumulators; ++k)
+        for (int l = 0; l < lanes; ++l)
+            acc[k][l] = 1.0 + k * 1e-3 + l * 1e-4;
+    ++ready;
+
+    while (!stop.load(std::memory_order_relaxed)) {
+        for (long i = 0; i < iterations; ++i) {
+#pragma GCC unroll 12
+            for (int k = 0; k < accumulators; ++k)
+                acc[k] = acc[k] * m + a;
+            __asm__ volatile("" : "+x"(acc[0]), "+x"(acc[1]), "+x"(acc[2]), "+x"(acc[3]));
+        }
+        w.work = w.work + 2.0 * accumulators * lanes * iterations;
+    }
+    double s = 0.0;
+    for (int k = 0; k < accumulators; ++k)
+        for (int l = 0; l < lanes; ++l)
+            s += acc[k][l];
+    sink = sink + s;
+}
+
+int main(int argc, char* argv[]) {
+    std::map<std::string, std::string> options;
+    std::vector<std::unique_ptr<Worker>> workers;
+    try {
+        options = parse_options(argc, argv, 1);
+        for (const char* kind : {"stream", "chase", "fma"})
+            if (options.count(kind))
+                for (int cpu : parse_cpu_list(options[kind])) {
+                    workers.emplace_back(new Worker);
+                    workers.back()->kind = kind;
+                    workers.back()->cpu = cpu;
+                }
+        if (workers.empty())
+            throw std::invalid_argument("No co-runners: give at least one of --stream, --chase, --fma");
+    } catch (const std::invalid_argument& e) {
+        std::cerr << "Usage: " << argv[0] << " [--stream=CPUS] [--chase=CPUS] [--fma=CPUS]"
+                  << " [--stream-mb=M] [--chase-mb=M] [--seconds=0]" << std::endl;
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    // Массивы STREAM и буферы обхода вместе – по умолчанию 4x и 2x L3, чтобы
+    // работать с памятью, а не с кэшем; делятся поровну между потоками вида
+    size_t l3 = l3_size();
+    std::map<std::string, int> count;
+    for (auto& w : workers)
+        ++count[w->kind];
+    size_t stream_bytes = options.count("stream-mb") ? std::stoul(options["stream-mb"]) << 20 : 4 * l3;
+    size_t chase_bytes = options.count("chase-mb") ? std::stoul(options["chase-mb"]) << 20 : 2 * l3;
+    double seconds = std::stod(option(options, "seconds", "0"));
+
+    std::signal(SIGTERM, on_signal);
+    std::signal(SIGINT, on_signal);
+
+    for (auto& w : workers) {
+        Worker* p = w.get();
+        size_t share = (p->kind == "stream" ? stream_bytes : chase_bytes) / count[p->kind];
+        p->thread = std::thread([p, share] {
+            pin(p->cpu);
+            if (p->kind == "stream")
+                stream_loop(*p, std::max<size_t>(share / (3 * sizeof(double)), 1024));
+            else if (p->kind == "chase")
+                chase_loop(*p, std::max<size_t>(share / sizeof(Node), 1024));
+            else
+                fma_loop(*p);
+        });
+    }
+
+    // Время нагрузки считается с момента, когда все потоки заполнили буферы
+    while (ready.load() != (int)workers.size())
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    std::cout << "CORUNNER_READY=" << workers.size() << std::endl;
+    double start = now();
+    while (!stop.load() && (seconds <= 0.0 || now() - start < seconds))
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    stop = true;
+    double elapsed = now() - start;
+    for (auto& w : workers)
+        w->thread.join();
+
+    std::map<std::string, double> totals;
+    std::map<std::string, std::string> cpus;
+    for (auto& w : workers) {
+        totals[w->kind] += w->work.load();
+        cpus[w->kind] += (cpus[w->kind].empty() ? "" : ",") + std::to_string(w->cpu);
+    }
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "CORUNNER_SECONDS=" << elapsed << std::endl;
+    std::cout << "CORUNNER_L3_KB=" << (l3 >> 10) << std::endl;
+    for (const auto& [kind, list] : cpus)
+        std::cout << "CORUNNER_CPUS_" << (kind == "stream" ? "STREAM" : kind == "chase" ? "CHASE" : "FMA")
+                  << "=" << list << std::endl;
+    if (totals.count("stream"))
+        std::cout << "CORUNNER_STREAM_GBS=" << totals["stream"] / elapsed / 1e9 << std::endl;
+    // Средняя задержка одного перехода на поток
+    if (totals.count("chase"))
+        std::cout << "CORUNNER_CHASE_NS=" << elapsed * 1e9 * std::count_if(workers.begin(), workers.end(),
+                  [](const std::unique_ptr<Worker>& w) { return w->kind == "chase"; }) / totals["chase"] << std::endl;
+    if (totals.count("fma"))
+        std::cout << "CORUNNER_FMA_GFLOPS=" << totals["fma"] / elapsed / 1e9 << std::endl;
+    std::cout << std::scientific << std::setprecision(3);
+    std::cout << "DIAG_CHECKSUM=" << sink.load() << std::endl;
+
+    return 0;
+}
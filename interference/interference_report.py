@@ -0,0 +1,128 @@
+import os
+import re
+import csv
+import glob
+import socket
+import numpy as np
+import matplotlib.pyplot as plt
+
+# Замедление программ рядом с соседями: медиана сценария / медиана isolated
+# на тех же CPU для каждого контейнера и размера. Библиотека устойчивее, если
+# её среднее (геометрическое) замедление по размерам меньше
+
+BASE_DIR = os.path.dirname(os.path.abspath(__file__))
+RESULTS_DIR = os.path.join(BASE_DIR, "results")
+
+FILE_RE = re.compile(r"(?P<container>.+)_(?P<scenario>isolated|stream|chase|fma|mix)_size_(?P<size>\d+)\.txt$")
+SCENARIOS = ['stream', 'chase', 'fma', 'mix']
+
+
+def parse_times(filepath, discard_first=True):
+    """Времена RESULT_SECONDS; первый запуск отбрасывается, как в остальных отчётах."""
+    times = []
+    with open(filepath, 'r', encoding='utf-8') as f:
+        for line in f:
+            key, _, value = line.strip().partition('=')
+            if key == 'RESULT_SECONDS':
+                times.append(float(value))
+    if discard_first and len(times) > 1:
+        times = times[1:]
+    return times
+
+
+def parse_corunner(filepath):
+    """Нагрузка, созданная соседями: ключи CORUNNER_*_GBS/_NS/_GFLOPS."""
+    load = {}
+    if not os.path.exists(filepath):
+        return load
+    with open(filepath, 'r', encoding='utf-8') as f:
+        for line in f:
+            key, _, value = line.strip().partition('=')
+            if key in ('CORUNNER_STREAM_GBS', 'CORUNNER_CHASE_NS', 'CORUNNER_FMA_GFLOPS'):
+                load.setdefault(key[len('CORUNNER_'):].lower(), []).append(float(value))
+    return {k: float(np.median(v)) for k, v in load.items()}
+
+
+medians = {}
+for filepath in glob.glob(os.path.join(RESULTS_DIR, "*_size_*.txt")):
+    name = os.path.basename(filepath)
+    match = FILE_RE.match(name)
+    if not match or name.startswith('corunner_'):
+        continue
+    times = parse_times(filepath)
+    if times:
+        medians[(match['container'], int(match['size']), match['scenario'])] = float(np.median(times))
+
+rows = []
+for (container, size, scenario), seconds in sorted(medians.items()):
+    base = medians.get((container, size, 'isolated'))
+    if scenario == 'isolated' or base is None:
+        continue
+    load = parse_corunner(os.path.join(RESULTS_DIR, f"corunner_{container}_{scenario}_size_{size}.txt"))
+    rows.append({
+        'container': container,
+        'backend': container.split('_')[0],
+        'op': '_'.join(container.split('_')[1:]),
+        'size': size,
+        'scenario': scenario,
+        'isolated_seconds': base,
+        'seconds': seconds,
+        'slowdown': seconds / base,
+        'corunner_stream_gbs': load.get('stream_gbs', ''),
+        'corunner_chase_ns': load.get('chase_ns', ''),
+        'corunner_fma_gflops': load.get('fma_gflops', ''),
+    })
+
+if not rows:
+    raise SystemExit(f"Нет пар сценарий/isolated в {RESULTS_DIR}: запустите interference/run.sh")
+
+print(f"{'контейнер':<14} {'n':>6} {'сценарий':>9} {'isolated, с':>12} {'с соседями, с':>14} {'замедление':>11}")
+for r in rows:
+    print(f"{r['container']:<14} {r['size']:>6} {r['scenario']:>9} {r['isolated_seconds']:>12.4f} "
+          f"{r['seconds']:>14.4f} {r['slowdown']:>10.2f}x")
+
+# Сводка по операциям: геометрическое среднее замедления по размерам
+print(f"\n{'операция':<10} {'сценарий':>9} " + " ".join(f"{b:>8}" for b in ('lapack', 'mkl')) + "  устойчивее")
+for op in sorted({r['op'] for r in rows}):
+    for scenario in SCENARIOS:
+        mean = {}
+        for backend in ('lapack', 'mkl'):
+            values = [r['slowdown'] for r in rows
+                      if r['op'] == op and r['scenario'] == scenario and r['backend'] == backend]
+            if values:
+                mean[backend] = float(np.exp(np.mean(np.log(values))))
+        if not mean:
+            continue
+        best = '-'
+        if len(mean) == 2:
+            # Разница меньше 2% – в пределах шума между запусками
+            best = 'равны' if abs(mean['lapack'] - mean['mkl']) < 0.02 * min(mean.values()) else min(mean, key=mean.get)
+        print(f"{op:<10} {scenario:>9} " + " ".join(
+            f"{mean[b]:>7.2f}x" if b in mean else f"{'-':>8}" for b in ('lapack', 'mkl')) + f"  {best}")
+
+host = socket.gethostname()
+csv_path = os.path.join(RESULTS_DIR, f"interference_{host}.csv")
+with open(csv_path, 'w', newline='', encoding='utf-8') as f:
+    writer = csv.DictWriter(f, fieldnames=list(rows[0]))
+    writer.writeheader()
+    writer.writerows(rows)
+print(f"\nТаблица: {csv_path}")
+
+# График: замедление по сценариям для каждого контейнера на наибольшем размере
+largest = max(r['size'] for r in rows)
+containers = sorted({r['container'] for r in rows if r['size'] == largest})
+width = 0.8 / len(SCENARIOS)
+plt.figure(figsize=(12, 6))
+for i, scenario in enumerate(SCENARIOS):
+    values = [next((r['slowdown'] for r in rows if r['container'] == c and r['size'] == largest
+                    and r['scenario'] == scenario), np.nan) for c in containers]
+    plt.bar(np.arange(len(containers)) + i * width, values, width, label=scenario)
+plt.axhline(1.0, color='black', linewidth=0.8)
+plt.xticks(np.arange(len(containers)) + width * (len(SCENARIOS) - 1) / 2, containers)
+plt.ylabel('Замедление относительно isolated')
+plt.title(f'Помехи от соседей, n = {largest}')
+plt.grid(True, axis='y', linestyle='--', alpha=0.5)
+plt.legend()
+plt.tight_layout()
+plt.savefig(os.path.join(RESULTS_DIR, f"interference_{host}.png"), dpi=150)
+plt.show()
@@ -0,0 +1,92 @@
+#!/bin/bash
+
+# Режим помех: программа работает на CPU bench_cpus, соседи (corunner) – на
+# зарезервированных reserved_cpus. Сценарий isolated – те же bench_cpus без
+# соседей, поэтому замедление в interference_report.py вызвано только помехами,
+# а не меньшим числом ядер. По умолчанию резервируются последние 2 CPU; на
+# машинах с SMT задайте целые физические ядра через BENCH_CPUS и RESERVED_CPUS
+total=$(nproc)
+reserve=${RESERVE:-2}
+bench_cpus=${BENCH_CPUS:-0-$((total - reserve - 1))}
+reserved_cpus=${RESERVED_CPUS:-$((total - reserve))-$((total - 1))}
+
+# Контейнеры программ (собираются их build.sh)
+containers=(
+	"lapack_chol"
+	"mkl_chol"
+	"lapack_lu"
+	"mkl_lu"
+	"lapack_mul"
+	"mkl_mul"
+)
+
+# Размеры матриц
+sizes=(2500 5000 10000)
+
+# Количество запусков для каждого контейнера, размера и сценария
+runs=5
+
+# isolated – без соседей; stream, chase, fma – один вид нагрузки на всех
+# зарезервированных CPU; mix – три вида по очереди
+scenarios=(${SCENARIOS:-isolated stream chase fma mix})
+
+# 0-2,5 -> 0 1 2 5
+expand_cpus() {
+    local IFS=,
+    for range in $1; do
+        seq "${range%-*}" "${range#*-}"
+    done
+}
+
+# Параметры corunner для сценария
+corunner_args() {
+    local scenario=$1
+    if [ "$scenario" != "mix" ]; then
+        echo "--${scenario}=${reserved_cpus}"
+        return
+    fi
+    local kinds=(stream chase fma) lists=("" "" "") i=0
+    for cpu in $(expand_cpus "$reserved_cpus"); do
+        lists[$((i % 3))]+="${lists[$((i % 3))]:+,}$cpu"
+        i=$((i + 1))
+    done
+    for k in 0 1 2; do
+        [ -n "${lists[$k]}" ] && echo -n "--${kinds[$k]}=${lists[$k]} "
+    done
+    echo
+}
+
+mkdir -p results
+echo "CPU программ: $bench_cpus, CPU соседей: $reserved_cpus"
+
+for container in "${containers[@]}"; do
+    for size in "${sizes[@]}"; do
+        for scenario in "${scenarios[@]}"; do
+            output_file="results/${container}_${scenario}_size_${size}.txt"
+            corunner_file="results/corunner_${container}_${scenario}_size_${size}.txt"
+
+            corunner_id=""
+            if [ "$scenario" != "isolated" ]; then
+                corunner_id=$(docker run -d --cpuset-cpus="$reserved_cpus" corunner $(corunner_args "$scenario"))
+                # Ждём, пока соседи заполнят буферы
+                until docker logs "$corunner_id" 2>/dev/null | grep -q "CORUNNER_READY"; do
+                    sleep 0.2
+                done
+            fi
+
+            for ((i=1; i<=runs; i++)); do
+                echo "Запуск контейнера $container (сценарий $scenario) с размером матрицы $size, запуск номер $i..."
+                docker run --rm --cpuset-cpus="$bench_cpus" "$container" "$size" >> "$output_file"
+            done
+
+            # Соседи останавливаются по SIGTERM и печатают созданную нагрузку
+            if [ -n "$corunner_id" ]; then
+                docker stop "$corunner_id" > /dev/null
+                docker logs "$corunner_id" >> "$corunner_file"
+                docker rm "$corunner_id" > /dev/null
+            fi
+
+            echo "Вывод контейнера $container (сценарий $scenario) с размером матрицы $size добавлен в $output_file"
+        done
+    done
+done
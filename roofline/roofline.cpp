@@ -0,0 +1,287 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <map>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdlib>
+#include <unistd.h>
+// Профиль машины для модели roofline: пиковая производительность FMA
+// (одно ядро и все ядра), пропускная способность памяти в духе STREAM (triad)
+// и чтение из L1/L2/L3. Вывод – ключи MACHINE_*, которые roofline_report.py
+// сопоставляет с результатами программ
+
+#if defined(__AVX512F__)
+constexpr int lanes = 8;
+#define ROOFLINE_ISA "avx512"
+#elif defined(__AVX__)
+constexpr int lanes = 4;
+#define ROOFLINE_ISA "avx2"
+#else
+constexpr int lanes = 2;
+#define ROOFLINE_ISA "sse2"
+#endif
+typedef double vdouble __attribute__((vector_size(lanes * sizeof(double))));
+
+// Необязательные параметры вида --key=value
+std::map<std::string, std::string> parse_options(int argc, char* argv[], int first) {
+    std::map<std::string, std::string> options;
+    for (int i = first; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+            throw std::invalid_argument("Unknown argument: " + arg);
+        options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+    }
+    return options;
+}
+
+std::string option(const std::map<std::string, std::string>& options,
+                   const std::string& key, const std::string& fallback) {
+    auto it = options.find(key);
+    return it == options.end() ? fallback : it->second;
+}
+
+double now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Результат ядра уходит сюда, чтобы компилятор не выбросил вычисления
+std::atomic<double> sink{0.0};
+
+// Запуск fn(thread_index) в threads потоках с общим стартом; время самого медленного
+template<class F>
+double run_parallel(int threads, F&& fn) {
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<double> elapsed(threads);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t] {
+            ++ready;
+            while (!go.load())
+                ;
+            double start = now();
+            fn(t);
+            elapsed[t] = now() - start;
+        });
+    }
+    while (ready.load() != threads)
+        ;
+    go = true;
+    for (std::thread& th : pool)
+        th.join();
+    return *std::max_element(elapsed.begin(), elapsed.end());
+}
+
+// FMA-ядро: 12 независимых аккумуляторов покрывают задержку FMA на двух портах.
+// acc = acc * m + a сходится к 1 и не уходит в денормализованные числа
+double fma_kernel(long iterations) {
+    constexpr int accumulators = 12;
+    vdouble acc[accumulators];
+    vdouble m, a;
+    for (int l = 0; l < lanes; ++l) {
+        m[l] = 0.999999;
+        a[l] = 0.000001;
+    }
+    for (int k = 0; k < accumulators; ++k)
+        for (int l = 0; l < lanes; ++l)
+            acc[k][l] = 1.0 + k * 1e-3 + l * 1e-4;
+
+    for (long i = 0; i < iterations; ++i) {
+#pragma GCC unroll 12
+        for (int k = 0; k < accumulators; ++k)
+            acc[k] = acc[k] * m + a;
+        // Барьер для оптимизатора: не даёт свернуть цикл в замкнутую формулу
+        __asm__ volatile("" : "+x"(acc[0]), "+x"(acc[1]), "+x"(acc[2]), "+x"(acc[3]));
+    }
+
+    double s = 0.0;
+    for (int k = 0; k < accumulators; ++k)
+        for (int l = 0; l < lanes; ++l)
+            s += acc[k][l];
+    return s;
+}
+
+double fma_flops(long iterations) {
+    return 2.0 * 12 * lanes * iterations;
+}
+
+// Пиковые GFLOP/s: лучший из repeats замеров
+double peak_gflops(int threads, long iterations, int repeats) {
+    double best = 0.0;
+    for (int r = 0; r < repeats; ++r) {
+        double seconds = run_parallel(threads, [&](int) { sink = sink + fma_kernel(iterations); });
+        best = std::max(best, threads * fma_flops(iterations) / seconds / 1e9);
+    }
+    return best;
+}
+
+// STREAM triad a = b + s*c; по соглашению STREAM считается 24 байта на элемент.
+// Массивы инициализируются в своих потоках (first touch), чтобы страницы легли
+// на узлы NUMA тех ядер, что их читают
+double stream_gbs(int threads, size_t elements, int repeats) {
+    std::unique_ptr<double[]> a(new double[elements]), b(new double[elements]), c(new double[elements]);
+    auto range = [&](int t, size_t& begin, size_t& end) {
+        begin = elements * t / threads;
+        end = elements * (t + 1) / threads;
+    };
+    run_parallel(threads, [&](int t) {
+        size_t begin, end;
+        range(t, begin, end);
+        for (size_t i = begin; i < end; ++i) {
+            a[i] = 0.0;
+            b[i] = 1.0;
+            c[i] = 2.0;
+        }
+    });
+
+    double best = 0.0;
+    const double scalar = 3.0;
+    for (int r = 0; r < repeats; ++r) {
+        double seconds = run_parallel(threads, [&](int t) {
+            size_t begin, end;
+            range(t, begin, end);
+            double* __restrict pa = a.get();
+            const double* __restrict pb = b.get();
+            const double* __restrict pc = c.get();
+            for (size_t i = begin; i < end; ++i)
+                pa[i] = pb[i] + scalar * pc[i];
+        });
+        best = std::max(best, 3.0 * sizeof(double) * elements / seconds / 1e9);
+    }
+    sink = sink + a[elements / 2];
+    return best;
+}
+
+// Чтение буфера заданного размера одним ядром: при размере меньше уровня кэша
+// данные после первого прохода читаются из него
+double read_gbs(size_t bytes, int repeats) {
+    size_t vectors = std::max<size_t>(bytes / sizeof(vdouble), 4) & ~size_t(3);
+    std::vector<vdouble> buffer(vectors);
+    for (size_t i = 0; i < vectors; ++i)
+        for (int l = 0; l < lanes; ++l)
+            buffer[i][l] = 1.0 / (i + l + 1);
+
+    // Не менее 2 ГБ прочитанных данных на замер
+    long passes = std::max<long>(1, (long)(2e9 / (vectors * sizeof(vdouble))));
+    double best = 0.0;
+    for (int r = 0; r < repeats; ++r) {
+        vdouble s0 = {}, s1 = {}, s2 = {}, s3 = {};
+        double start = now();
+        for (long p = 0; p < passes; ++p) {
+            for (size_t i = 0; i < vectors; i += 4) {
+                s0 += buffer[i];
+                s1 += buffer[i + 1];
+                s2 += buffer[i + 2];
+                s3 += buffer[i + 3];
+            }
+            __asm__ volatile("" : "+x"(s0), "+x"(s1), "+x"(s2), "+x"(s3));
+        }
+        double seconds = now() - start;
+        vdouble s = s0 + s1 + s2 + s3;
+        for (int l = 0; l < lanes; ++l)
+            sink = sink + s[l];
+        best = std::max(best, (double)passes * vectors * sizeof(vdouble) / seconds / 1e9);
+    }
+    return best;
+}
+
+// Размеры кэшей данных cpu0 из sysfs; 0 – уровень не найден
+std::map<int, size_t> cache_sizes() {
+    std::map<int, size_t> sizes;
+    for (int index = 0; index < 8; ++index) {
+        std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+        std::ifstream level_file(dir + "level"), type_file(dir + "type"), size_file(dir + "size");
+        int level;
+        std::string type, size;
+        if (!(level_file >> level) || !(type_file >> type) || !(size_file >> size))
+            continue;
+        if (type == "Instruction")
+            continue;
+        size_t value = std::stoul(size);
+        char unit = size.back();
+        if (unit == 'K')
+            value <<= 10;
+        else if (unit == 'M')
+            value <<= 20;
+        sizes[level] = value;
+    }
+    return sizes;
+}
+
+std::string cpu_model() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.rfind("model name", 0) == 0) {
+            size_t colon = line.find(':');
+            return colon == std::string::npos ? line : line.substr(colon + 2);
+        }
+    }
+    return "unknown";
+}
+
+int main(int argc, char* argv[]) {
+    std::map<std::string, std::string> options;
+    try {
+        options = parse_options(argc, argv, 1);
+    } catch (const std::invalid_argument& e) {
+        std::cerr << "Usage: " << argv[0] << " [--host=name] [--threads=N] [--stream-mb=M] [--repeats=5]" << std::endl;
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    char hostname[256] = "unknown";
+    gethostname(hostname, sizeof(hostname) - 1);
+    std::string host = option(options, "host", hostname);
+    int cores = std::stoi(option(options, "threads", std::to_string(std::max(1u, std::thread::hardware_concurrency()))));
+    int repeats = std::max(1, std::stoi(option(options, "repeats", "5")));
+
+    std::map<int, size_t> caches = cache_sizes();
+    size_t l1 = caches.count(1) ? caches[1] : (32u << 10);
+    size_t l2 = caches.count(2) ? caches[2] : (1u << 20);
+    size_t l3 = caches.count(3) ? caches[3] : (32u << 20);
+
+    // Массивы STREAM в 4 раза больше L3 и не меньше 128 МБ каждый
+    size_t stream_bytes = std::max<size_t>(4 * l3, 128u << 20);
+    if (options.count("stream-mb"))
+        stream_bytes = std::stoul(options["stream-mb"]) << 20;
+    size_t stream_elements = stream_bytes / sizeof(double);
+
+    long fma_iterations = 50000000;
+    double peak_core = peak_gflops(1, fma_iterations, repeats);
+    double peak_all = peak_gflops(cores, fma_iterations, repeats);
+    double stream_core = stream_gbs(1, stream_elements, repeats);
+    double stream_all = stream_gbs(cores, stream_elements, repeats);
+    // Половина уровня кэша: буфер гарантированно помещается вместе с прочими данными
+    double l1_gbs = read_gbs(l1 / 2, repeats);
+    double l2_gbs = read_gbs(l2 / 2, repeats);
+    double l3_gbs = read_gbs(l3 / 2, repeats);
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "MACHINE_HOST=" << host << std::endl;
+    std::cout << "MACHINE_CPU=" << cpu_model() << std::endl;
+    std::cout << "MACHINE_CORES=" << cores << std::endl;
+    std::cout << "MACHINE_ISA=" << ROOFLINE_ISA << ":" << lanes << std::endl;
+    std::cout << "MACHINE_CACHE=L1:" << (l1 >> 10) << "K,L2:" << (l2 >> 10) << "K,L3:" << (l3 >> 10) << "K" << std::endl;
+    std::cout << "MACHINE_PEAK_GFLOPS_CORE=" << peak_core << std::endl;
+    std::cout << "MACHINE_PEAK_GFLOPS=" << peak_all << std::endl;
+    std::cout << "MACHINE_STREAM_GBS_CORE=" << stream_core << std::endl;
+    std::cout << "MACHINE_STREAM_GBS=" << stream_all << std::endl;
+    std::cout << "MACHINE_L1_GBS=" << l1_gbs << std::endl;
+    std::cout << "MACHINE_L2_GBS=" << l2_gbs << std::endl;
+    std::cout << "MACHINE_L3_GBS=" << l3_gbs << std::endl;
+    std::cout << "MACHINE_STREAM_MB=" << (stream_bytes >> 20) << std::endl;
+    std::cout << std::scientific << std::setprecision(3);
+    std::cout << "DIAG_CHECKSUM=" << sink.load() << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,221 @@
+import os
+import re
+import sys
+import csv
+import glob
+import socket
+import numpy as np
+import matplotlib.pyplot as plt
+
+# Результаты программ относительно границы roofline машины:
+# граница = min(пик FLOP/s, арифметическая интенсивность * пропускная способность памяти).
+# Интенсивность считается по обязательному трафику: чтение входных матриц и
+# запись результата по одному разу (8 байт на элемент).
+# Профиль машины берётся для хоста, на котором запущен отчёт (или --host=имя):
+# результаты в runks/build получены там же, где лежат
+
+BASE_DIR = os.path.dirname(os.path.abspath(__file__))
+REPO_DIR = os.path.dirname(BASE_DIR)
+RESULTS_DIR = os.path.join(BASE_DIR, "results")
+
+FILE_RE = re.compile(r"(?P<container>.+)_size_(?P<size>\d+)\.txt$")
+
+# Токен в имени контейнера -> (название, номинальные FLOP, обязательные байты).
+# Формулы верны только для основного метода операции, см. method_of
+OPS = {
+    'chol': ('обращение Холецким', lambda n: n ** 3,          lambda n: 2 * 8 * n * n),
+    'lu':   ('обращение через LU', lambda n: 2 * n ** 3,      lambda n: 2 * 8 * n * n),
+    'svd':  ('обращение через SVD', lambda n: 23 * n ** 3,    lambda n: 2 * 8 * n * n),
+    'mul':  ('умножение',          lambda n: 2 * n ** 3,      lambda n: 3 * 8 * n * n),
+}
+
+
+def load_machine(filepath):
+    """Ключи MACHINE_* из вывода roofline."""
+    machine = {}
+    with open(filepath, 'r', encoding='utf-8') as f:
+        for line in f:
+            key, _, value = line.strip().partition('=')
+            if key.startswith('MACHINE_'):
+                machine[key[len('MACHINE_'):].lower()] = value
+    for key in ('peak_gflops_core', 'peak_gflops', 'stream_gbs_core', 'stream_gbs'):
+        machine[key] = float(machine[key])
+    machine['cores'] = int(machine['cores'])
+    return machine
+
+
+# Другие методы тех же операций: в имени файла или по подпрограммам и ключам
+# DIAG_. Их номинальное число FLOP другое, поэтому такие файлы пропускаются
+VARIANT_TOKENS = {'selected', 'newton', 'recursive', 'sytrf', 'aasen', 'sweep', 'rank', 'jobs'}
+VARIANT_ROUTINES = {
+    'chol': {'dgemm', 'dsymm', 'dtrsm', 'dtrtri', 'dgesdd'},
+    'lu':   {'dgemm', 'dgesdd', 'dsytrf', 'dsytrf_aa', 'dsytri2', 'dsytrs_aa'},
+}
+VARIANT_KEYS = {'DIAG_NS', 'DIAG_SELECT', 'DIAG_INERTIA'}
+
+
+def parse_runs(filepath, discard_first=True):
+    """Времена запусков, число потоков, подпрограммы, ключи DIAG_ и форма dgemm;
+    понимает ключи RESULT_SECONDS/DIAG_THREADS и старый формат «Time to ...: X s»
+    с «Using N threads»."""
+    times, threads = [], None
+    info = {'routines': set(), 'keys': set(), 'gemm': None}
+    with open(filepath, 'r', encoding='utf-8') as f:
+        for line in f:
+            line = line.strip()
+            key, _, value = line.partition('=')
+            if key.startswith('DIAG_'):
+                info['keys'].add(key)
+            if key == 'RESULT_SECONDS':
+                times.append(float(value))
+            elif key == 'DIAG_ROUTINES':
+                info['routines'].update(r for r in value.split(',') if r)
+            elif key == 'DIAG_GEMM':
+                dims = dict(item.split(':', 1) for item in value.split(',') if ':' in item)
+                info['gemm'] = (int(dims['m']), int(dims['n']), int(dims['k']))
+            elif key == 'DIAG_THREADS':
+                match = re.search(r':(\d+)$', value)
+                threads = int(match.group(1)) if match else threads
+            elif line.startswith('Time to'):
+                match = re.search(r':\s*([\d.]+)\s*s', line)
+                if match:
+                    times.append(float(match.group(1)))
+            else:
+                match = re.search(r'Using (\d+) threads', line)
+                if match:
+                    threads = int(match.group(1))
+    if discard_first and len(times) > 1:
+        times = times[1:]
+    return times, threads, info
+
+
+def find_op(container):
+    for token in container.split('_'):
+        if token in OPS:
+            return token
+    return None
+
+
+def method_of(container, op, info):
+    """None для основного метода операции, иначе причина пропуска."""
+    tokens = set(container.split('_')) & VARIANT_TOKENS
+    if tokens:
+        return 'вариант ' + ','.join(sorted(tokens))
+    routines = info['routines'] & VARIANT_ROUTINES.get(op, set())
+    if routines:
+        return 'подпрограммы ' + ','.join(sorted(routines))
+    keys = info['keys'] & VARIANT_KEYS
+    if keys:
+        return 'ключи ' + ','.join(sorted(keys))
+    return None
+
+
+def flops_and_bytes(op, n, info):
+    """Номинальные FLOP и обязательные байты; умножение – по форме из DIAG_GEMM."""
+    if op == 'mul' and info['gemm']:
+        m, n_, k = info['gemm']
+        return 2.0 * m * n_ * k, 8.0 * (m * k + k * n_ + m * n_)
+    _, flops_of, bytes_of = OPS[op]
+    return flops_of(n), bytes_of(n)
+
+
+args = sys.argv[1:]
+host = next((a.split('=', 1)[1] for a in args if a.startswith('--host=')), socket.gethostname())
+profiles = [a for a in args if not a.startswith('--')]
+if not profiles:
+    profile = os.path.join(RESULTS_DIR, f"machine_{host}.txt")
+    if not os.path.exists(profile):
+        known = sorted(os.path.basename(p)[len('machine_'):-len('.txt')]
+                       for p in glob.glob(os.path.join(RESULTS_DIR, "machine_*.txt")))
+        raise SystemExit(f"Нет профиля машины {host} в {RESULTS_DIR}: запустите там roofline/run.sh"
+                         + (f" или укажите --host= (есть: {', '.join(known)})" if known else ""))
+    profiles = [profile]
+machine = load_machine(profiles[0])
+print(f"Машина {machine['host']}: {machine['cpu']}, {machine['cores']} ядер, {machine['isa']}")
+print(f"  пик {machine['peak_gflops']:.1f} ГФЛОП/с ({machine['peak_gflops_core']:.1f} на ядро), "
+      f"STREAM {machine['stream_gbs']:.1f} ГБ/с ({machine['stream_gbs_core']:.1f} на ядро), "
+      f"L1/L2/L3 {machine['l1_gbs']}/{machine['l2_gbs']}/{machine['l3_gbs']} ГБ/с")
+
+rows, skipped = [], []
+for filepath in sorted(glob.glob(os.path.join(REPO_DIR, "runks", "build", "**", "*_size_*.txt"), recursive=True)):
+    match = FILE_RE.match(os.path.basename(filepath))
+    if not match:
+        continue
+    container, n = match['container'], int(match['size'])
+    op = find_op(container)
+    if op is None:
+        continue
+    times, threads, info = parse_runs(filepath)
+    if not times:
+        continue
+    reason = method_of(container, op, info)
+    if reason:
+        skipped.append((container, n, reason))
+        continue
+    threads = min(threads or machine['cores'], machine['cores'])
+
+    flops, traffic = flops_and_bytes(op, n, info)
+    seconds = float(np.median(times))
+    gflops = flops / seconds / 1e9
+    intensity = flops / traffic
+    # Пик растёт с числом потоков, но не выше замера на всех ядрах
+    peak = min(machine['peak_gflops'], machine['peak_gflops_core'] * threads)
+    bandwidth = machine['stream_gbs_core'] if threads == 1 else machine['stream_gbs']
+    bound = min(peak, intensity * bandwidth)
+    rows.append({
+        'host': machine['host'],
+        'container': container,
+        'op': op,
+        'n': n,
+        'threads': threads,
+        'median_seconds': seconds,
+        'gflops': gflops,
+        'intensity': intensity,
+        'bound_gflops': bound,
+        'bound': 'compute' if bound == peak else 'memory',
+        'fraction': gflops / bound,
+    })
+
+if skipped:
+    print(f"\nПропущено файлов с другим методом: {len(skipped)}")
+    for container, n, reason in sorted(skipped):
+        print(f"  {container} n={n}: {reason}")
+
+if not rows:
+    raise SystemExit("Нет результатов программ с известной операцией")
+
+print(f"\n{'контейнер':<24} {'n':>6} {'потоки':>6} {'время, с':>10} {'ГФЛОП/с':>9} "
+      f"{'ФЛОП/байт':>10} {'граница':>9} {'доля':>6}")
+for r in sorted(rows, key=lambda r: (r['container'], r['n'])):
+    print(f"{r['container']:<24} {r['n']:>6} {r['threads']:>6} {r['median_seconds']:>10.4f} {r['gflops']:>9.2f} "
+          f"{r['intensity']:>10.1f} {r['bound_gflops']:>9.2f} {r['fraction']:>6.1%}")
+
+# Таблица сохраняется вместе с профилем машины, чтобы сравнивать разные хосты
+os.makedirs(RESULTS_DIR, exist_ok=True)
+csv_path = os.path.join(RESULTS_DIR, f"roofline_{machine['host']}.csv")
+with open(csv_path, 'w', newline='', encoding='utf-8') as f:
+    machine_columns = ['cpu', 'cores', 'isa', 'peak_gflops', 'stream_gbs', 'l1_gbs', 'l2_gbs', 'l3_gbs']
+    writer = csv.DictWriter(f, fieldnames=list(rows[0]) + ['machine_' + c for c in machine_columns])
+    writer.writeheader()
+    for r in rows:
+        writer.writerow({**r, **{'machine_' + c: machine[c] for c in machine_columns}})
+print(f"\nТаблица: {csv_path}")
+
+# График roofline: крыша машины и точки программ для всех ядер
+intensity = np.logspace(-2, 4, 200)
+plt.figure(figsize=(12, 8))
+plt.plot(intensity, np.minimum(machine['peak_gflops'], intensity * machine['stream_gbs']),
+         color='black', label=f"roofline {machine['host']}")
+for op in sorted({r['op'] for r in rows}):
+    points = [r for r in rows if r['op'] == op]
+    plt.scatter([r['intensity'] for r in points], [r['gflops'] for r in points], label=OPS[op][0])
+plt.xscale('log')
+plt.yscale('log')
+plt.xlabel('Арифметическая интенсивность, ФЛОП/байт')
+plt.ylabel('ГФЛОП/с')
+plt.title('Результаты относительно границы roofline')
+plt.grid(True, which='both', linestyle='--', alpha=0.5)
+plt.legend()
+plt.tight_layout()
+plt.savefig(os.path.join(RESULTS_DIR, f"roofline_{machine['host']}.png"), dpi=150)
+plt.show()
@@ -0,0 +1,20 @@
+#!/bin/bash
+
+# Профиль машины для roofline_report.py: пик FMA, STREAM и пропускная
+# способность кэшей. Имя хоста передаётся в контейнер, чтобы профили разных
+# машин не перезаписывали друг друга
+host=$(hostname)
+
+mkdir -p results
+output_file="results/machine_${host}.txt"
+
+echo "Замер профиля машины $host..."
+container_id=$(docker run -d --rm roofline --host="$host")
+
+# Ожидаем завершения контейнера и записываем его вывод в файл
+docker logs -f "$container_id" > "$output_file"
+
+# Ждем завершения контейнера
+docker wait "$container_id"
+
+echo "Профиль машины записан в $output_file"
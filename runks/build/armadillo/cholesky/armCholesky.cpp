@@ -0,0 +1,253 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <random>
+#include <chrono>
+#include <map>
+#include <stdexcept>
+#include <sys/resource.h>
+#include <armadillo>
+#if defined(WITH_MKL)
+#include <mkl_service.h>
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <sched.h>
+#else
+#include <cblas.h>
+#endif
+// Обращение SPD-матрицы в Armadillo поверх OpenBLAS или MKL (WITH_MKL):
+// inv_sympd, chol + обращение треугольного множителя, solve с solve_opts::fast
+std::vector<std::string> called_routines;
+
+// Та же матрица, что и в программах LAPACK/MKL: симметричная, поэтому
+// порядок хранения (по столбцам в Armadillo) не меняет её содержимого
+arma::mat create_positive_definite_matrix(int n, int seed) {
+    arma::mat matrix(n, n);
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<> dis(0.0, 1.0);
+
+    double* data = matrix.memptr();
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < n; ++j)
+            data[(size_t)i * n + j] = dis(gen);
+
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < i; ++j) {
+            double avg = (data[(size_t)i * n + j] + data[(size_t)j * n + i]) / 2.0;
+            data[(size_t)i * n + j] = data[(size_t)j * n + i] = avg;
+        }
+    }
+    for (int i = 0; i < n; ++i)
+        data[(size_t)i * n + i] += n;
+
+    return matrix;
+}
+
+// Необязательные параметры вида --key=value
+std::map<std::string, std::string> parse_options(int argc, char* argv[], int first) {
+    std::map<std::string, std::string> options;
+    for (int i = first; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+            throw std::invalid_argument("Unknown argument: " + arg);
+        options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+    }
+    return options;
+}
+
+std::string option(const std::map<std::string, std::string>& options,
+                   const std::string& key, const std::string& fallback) {
+    auto it = options.find(key);
+    return it == options.end() ? fallback : it->second;
+}
+
+std::string backend_threads() {
+    std::ostringstream oss;
+#if defined(WITH_MKL)
+    oss << "armadillo-mkl/libmkl_rt:" << mkl_get_max_threads();
+#else
+    oss << "armadillo/libopenblas:" << openblas_get_num_threads();
+#endif
+    return oss.str();
+}
+
+#if defined(WITH_MKL)
+// Слой потоков mkl_rt задаётся до первого вызова MKL: MKL_THREADING_LAYER
+// (intel, gnu, tbb, sequential), по умолчанию intel. Возвращается
+// запрошенный слой и тот, что действует, как в программах MKL
+std::string threading_layer() {
+    std::string requested = "intel";
+    if (const char* env = std::getenv("MKL_THREADING_LAYER")) {
+        requested = env;
+        std::transform(requested.begin(), requested.end(), requested.begin(),
+                       [](unsigned char c) { return (char)std::tolower(c); });
+    }
+    static const std::pair<const char*, int> layers[] = {
+        {"intel", MKL_THREADING_INTEL}, {"gnu", MKL_THREADING_GNU},
+        {"tbb", MKL_THREADING_TBB}, {"sequential", MKL_THREADING_SEQUENTIAL}};
+    std::string actual = "unknown";
+    for (const auto& layer : layers)
+        if (requested == layer.first) {
+            int code = mkl_set_threading_layer(layer.second);
+            for (const auto& other : layers)
+                if (other.second == code)
+                    actual = other.first;
+        }
+    return requested + "->" + actual;
+}
+
+// Рантаймы OpenMP/TBB в процессе, число потоков, CPU и уровней вложенности
+// в формате DIAG_THREADING программ MKL; снимается после замера
+std::string threading_summary() {
+    std::string runtimes, line;
+    std::ifstream maps("/proc/self/maps");
+    static const std::pair<const char*, const char*> libraries[] = {
+        {"/libiomp5", "iomp5"}, {"/libgomp", "gomp"}, {"/libomp.", "omp"}, {"/libtbb.", "tbb"}};
+    std::vector<std::string> found;
+    while (std::getline(maps, line))
+        for (const auto& library : libraries)
+            if (line.find(library.first) != std::string::npos &&
+                std::find(found.begin(), found.end(), library.second) == found.end())
+                found.push_back(library.second);
+    for (const std::string& r : found)
+        runtimes += (runtimes.empty() ? "" : "+") + r;
+
+    int threads = 0;
+    std::ifstream status("/proc/self/status");
+    while (std::getline(status, line))
+        if (line.rfind("Threads:", 0) == 0)
+            threads = std::atoi(line.c_str() + 8);
+    cpu_set_t allowed;
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+    int levels = 1;
+    using LevelsFn = int (*)();
+    if (auto max_levels = (LevelsFn)dlsym(RTLD_DEFAULT, "omp_get_max_active_levels"))
+        levels = max_levels();
+    return "runtimes:" + (runtimes.empty() ? std::string("none") : runtimes) + ",threads:" + std::to_string(threads) +
+           ",cpus:" + std::to_string(CPU_COUNT(&allowed)) + ",levels:" + std::to_string(levels);
+}
+#endif
+
+// Невязка ||A (X v) - v|| / (||A||_F ||X||_F ||v||) на случайном векторе v
+double probe_residual(const arma::mat& A, const arma::mat& X) {
+    int n = (int)A.n_rows;
+    std::mt19937 gen(n + 2);
+    std::uniform_real_distribution<> dis(-1.0, 1.0);
+    arma::vec v(n);
+    for (int i = 0; i < n; ++i)
+        v[i] = dis(gen);
+
+    arma::vec r = A * (X * v) - v;
+    return arma::norm(r) / (arma::norm(A, "fro") * arma::norm(X, "fro") * arma::norm(v));
+}
+
+// Обращение выбранным способом; false – матрица не SPD или ошибка LAPACK
+bool invert(const arma::mat& A, arma::mat& A_inv, const std::string& method) {
+    if (method == "inv_sympd") {
+        // dpotrf + dpotri и отражение треугольника внутри Armadillo
+        called_routines.push_back("inv_sympd");
+        return arma::inv_sympd(A_inv, A);
+    }
+
+    if (method == "trimat") {
+        called_routines.push_back("chol");
+        arma::mat L;
+        if (!arma::chol(L, A, "lower"))
+            return false;
+
+        // trimatl сообщает Armadillo о треугольности: dtrtri вместо общего обращения
+        called_routines.push_back("inv(trimatl)");
+        arma::mat L_inv;
+        if (!arma::inv(L_inv, arma::trimatl(L)))
+            return false;
+
+        // A^{-1} = L^{-T} L^{-1}. Треугольного произведения (dlauum) в Armadillo
+        // нет; шаблон X.t() * X одного объекта распознаётся и идёт в dsyrk
+        called_routines.push_back("syrk");
+        A_inv = L_inv.t() * L_inv;
+        return true;
+    }
+
+    // Решение с единичной правой частью без уточнения и оценки обусловленности;
+    // симметричную положительно определённую матрицу Armadillo решает через Холецкого
+    called_routines.push_back("solve(fast)");
+    return arma::solve(A_inv, A, arma::eye<arma::mat>(A.n_rows, A.n_cols), arma::solve_opts::fast);
+}
+
+int main(int argc, char* argv[]) {
+#if defined(WITH_MKL)
+    std::string layer = threading_layer();
+#endif
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <matrix_size> [--method=inv_sympd|trimat|solve]" << std::endl;
+        return 1;
+    }
+
+    int n = std::stoi(argv[1]);
+    if (n <= 0) {
+        std::cerr << "Matrix size must be positive" << std::endl;
+        return 1;
+    }
+
+    std::map<std::string, std::string> options;
+    try {
+        options = parse_options(argc, argv, 2);
+    } catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::string method = option(options, "method", "inv_sympd");
+    if (method != "inv_sympd" && method != "trimat" && method != "solve") {
+        std::cerr << "Unknown --method: " << method << std::endl;
+        return 1;
+    }
+
+    arma::mat A = create_positive_definite_matrix(n, n);
+    arma::mat A_inv(n, n);  // результат выделен до таймера
+
+    auto start = std::chrono::steady_clock::now();
+    bool ok = invert(A, A_inv, method);
+    auto end = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = end - start;
+
+    if (!ok) {
+        std::cerr << "Error in matrix inversion (" << method << ")" << std::endl;
+        return 1;
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    long rss_kb = usage.ru_maxrss;
+
+    double checksum = 0.0;
+    for (arma::uword i = 0; i < A.n_elem; ++i)
+        checksum += A.memptr()[i];
+    double residual = probe_residual(A, A_inv);
+
+    std::ostringstream routines_oss;
+    for (size_t i = 0; i < called_routines.size(); ++i) {
+        if (i) routines_oss << ',';
+        routines_oss << called_routines[i];
+    }
+
+    std::cout << std::fixed << std::setprecision(9);
+    std::cout << "RESULT_SECONDS=" << elapsed.count() << std::endl;
+    std::cout << "DIAG_THREADS=" << backend_threads() << std::endl;
+#if defined(WITH_MKL)
+    std::cout << "DIAG_THREADING=" << layer << "," << threading_summary() << std::endl;
+#endif
+    std::cout << "DIAG_PEAK_RSS_KB=" << rss_kb << std::endl;
+    std::cout << "DIAG_ROUTINES=" << routines_oss.str() << std::endl;
+    std::cout << std::scientific << std::setprecision(6);
+    std::cout << "DIAG_RESIDUAL=" << residual << std::endl;
+    std::cout << std::fixed;
+    std::cout << "DIAG_CHECKSUM=" << checksum << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,22 @@
+#!/bin/bash
+# Build the Docker container
+
+# Function to build Docker container with error handling
+build_container() {
+    local container_name=$1
+    local dockerfile=$2
+
+    echo "Building Docker container: $container_name using $dockerfile..."
+    if ! docker build -t "$container_name" -f "$dockerfile" .; then
+        echo "Error: Building $container_name with $dockerfile failed."
+        exit 1
+    fi
+}
+
+# Armadillo поверх OpenBLAS и поверх MKL
+echo "Building Armadillo Docker containers..."
+
+build_container "arma_svd" "Dockerfile.armsvd"
+build_container "arma_mkl_svd" "Dockerfile.armsvd_mkl"
+
+echo "All containers built successfully!"
@@ -0,0 +1,23 @@
+#!/bin/bash
+# Build the Docker container
+
+# Function to build Docker container with error handling
+build_container() {
+    local container_name=$1
+    local dockerfile=$2
+
+    echo "Building Docker container: $container_name using $dockerfile..."
+    if ! docker build -t "$container_name" -f "$dockerfile" .; then
+        echo "Error: Building $container_name with $dockerfile failed."
+        exit 1
+    fi
+}
+
+# Eigen: чистый, с OpenBLAS и с MKL
+echo "Building Eigen Docker containers..."
+
+build_container "eigen_lu" "Dockerfile.eilu"
+build_container "eigen_blas_lu" "Dockerfile.eilu_blas"
+build_container "eigen_mkl_lu" "Dockerfile.eilu_mkl"
+
+echo "All containers built successfully!"
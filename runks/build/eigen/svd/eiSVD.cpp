@@ -0,0 +1,199 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include <limits>
+#include <sys/resource.h>
+#include <Eigen/Dense>
+#if defined(EIGEN_USE_MKL_ALL)
+#include <mkl.h>
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <sched.h>
+#elif defined(EIGEN_USE_BLAS)
+#include <cblas.h>
+#endif
+// Обращение через SVD в Eigen (BDCSVD, разделяй и властвуй) с отсечением малых сингулярных чисел.
+// Три сборки – как у eiCholesky.cpp
+std::vector<std::string> called_routines;
+
+// Та же матрица, что и в программах LAPACK/MKL: симметричная, поэтому
+// порядок хранения (по столбцам в Eigen) не меняет её содержимого
+Eigen::MatrixXd create_positive_definite_matrix(int n, int seed) {
+    Eigen::MatrixXd matrix(n, n);
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<> dis(0.0, 1.0);
+
+    double* data = matrix.data();
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < n; ++j)
+            data[(size_t)i * n + j] = dis(gen);
+
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < i; ++j) {
+            double avg = (data[(size_t)i * n + j] + data[(size_t)j * n + i]) / 2.0;
+            data[(size_t)i * n + j] = data[(size_t)j * n + i] = avg;
+        }
+    }
+    for (int i = 0; i < n; ++i)
+        data[(size_t)i * n + i] += n;
+
+    return matrix;
+}
+
+// Библиотека, которая реально выполняет ядра, и число её потоков
+std::string backend_threads() {
+    std::ostringstream oss;
+#if defined(EIGEN_USE_MKL_ALL)
+    oss << "eigen-mkl/libmkl_rt:" << mkl_get_max_threads();
+#elif defined(EIGEN_USE_BLAS)
+    oss << "eigen-blas/libopenblas:" << openblas_get_num_threads();
+#else
+    oss << "eigen/openmp:" << Eigen::nbThreads();
+#endif
+    return oss.str();
+}
+
+#if defined(EIGEN_USE_MKL_ALL)
+// Слой потоков mkl_rt задаётся до первого вызова MKL: MKL_THREADING_LAYER
+// (intel, gnu, tbb, sequential), по умолчанию intel. Возвращается
+// запрошенный слой и тот, что действует, как в программах MKL
+std::string threading_layer() {
+    std::string requested = "intel";
+    if (const char* env = std::getenv("MKL_THREADING_LAYER")) {
+        requested = env;
+        std::transform(requested.begin(), requested.end(), requested.begin(),
+                       [](unsigned char c) { return (char)std::tolower(c); });
+    }
+    static const std::pair<const char*, int> layers[] = {
+        {"intel", MKL_THREADING_INTEL}, {"gnu", MKL_THREADING_GNU},
+        {"tbb", MKL_THREADING_TBB}, {"sequential", MKL_THREADING_SEQUENTIAL}};
+    std::string actual = "unknown";
+    for (const auto& layer : layers)
+        if (requested == layer.first) {
+            int code = mkl_set_threading_layer(layer.second);
+            for (const auto& other : layers)
+                if (other.second == code)
+                    actual = other.first;
+        }
+    return requested + "->" + actual;
+}
+
+// Рантаймы OpenMP/TBB в процессе, число потоков, CPU и уровней вложенности
+// в формате DIAG_THREADING программ MKL; снимается после замера
+std::string threading_summary() {
+    std::string runtimes, line;
+    std::ifstream maps("/proc/self/maps");
+    static const std::pair<const char*, const char*> libraries[] = {
+        {"/libiomp5", "iomp5"}, {"/libgomp", "gomp"}, {"/libomp.", "omp"}, {"/libtbb.", "tbb"}};
+    std::vector<std::string> found;
+    while (std::getline(maps, line))
+        for (const auto& library : libraries)
+            if (line.find(library.first) != std::string::npos &&
+                std::find(found.begin(), found.end(), library.second) == found.end())
+                found.push_back(library.second);
+    for (const std::string& r : found)
+        runtimes += (runtimes.empty() ? "" : "+") + r;
+
+    int threads = 0;
+    std::ifstream status("/proc/self/status");
+    while (std::getline(status, line))
+        if (line.rfind("Threads:", 0) == 0)
+            threads = std::atoi(line.c_str() + 8);
+    cpu_set_t allowed;
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+    int levels = 1;
+    using LevelsFn = int (*)();
+    if (auto max_levels = (LevelsFn)dlsym(RTLD_DEFAULT, "omp_get_max_active_levels"))
+        levels = max_levels();
+    return "runtimes:" + (runtimes.empty() ? std::string("none") : runtimes) + ",threads:" + std::to_string(threads) +
+           ",cpus:" + std::to_string(CPU_COUNT(&allowed)) + ",levels:" + std::to_string(levels);
+}
+#endif
+
+// Невязка ||A (X v) - v|| / (||A||_F ||X||_F ||v||) на случайном векторе v
+double probe_residual(const Eigen::MatrixXd& A, const Eigen::MatrixXd& X) {
+    int n = (int)A.rows();
+    std::mt19937 gen(n + 2);
+    std::uniform_real_distribution<> dis(-1.0, 1.0);
+    Eigen::VectorXd v(n);
+    for (int i = 0; i < n; ++i)
+        v[i] = dis(gen);
+
+    Eigen::VectorXd r = A * (X * v) - v;
+    return r.norm() / (A.norm() * X.norm() * v.norm());
+}
+
+int main(int argc, char* argv[]) {
+#if defined(EIGEN_USE_MKL_ALL)
+    std::string layer = threading_layer();
+#endif
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <matrix_size>" << std::endl;
+        return 1;
+    }
+
+    int n = std::atoi(argv[1]);
+    if (n <= 0) {
+        std::cerr << "Matrix size must be positive" << std::endl;
+        return 1;
+    }
+
+    Eigen::MatrixXd A = create_positive_definite_matrix(n, n);
+    Eigen::MatrixXd A_inv(n, n);  // результат выделен до таймера
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Разложение с полными U и V
+    called_routines.push_back("BDCSVD");
+    Eigen::BDCSVD<Eigen::MatrixXd> svd(A, Eigen::ComputeFullU | Eigen::ComputeFullV);
+
+    // Инвертирование сингулярных чисел с отсечением, как в программах LAPACK/MKL
+    Eigen::VectorXd s_inv = svd.singularValues();
+    double threshold = s_inv.maxCoeff() * n * std::numeric_limits<double>::epsilon();
+    for (int i = 0; i < n; ++i)
+        s_inv[i] = (s_inv[i] > threshold) ? 1.0 / s_inv[i] : 0.0;
+
+    // Сборка A_inv = V * S^{-1} * U^T
+    called_routines.push_back("gemm");
+    A_inv.noalias() = svd.matrixV() * s_inv.asDiagonal() * svd.matrixU().transpose();
+
+    auto end = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = end - start;
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    long rss_kb = usage.ru_maxrss;
+
+    double checksum = 0.0;
+    for (Eigen::Index i = 0; i < A.size(); ++i)
+        checksum += A.data()[i];
+    double residual = probe_residual(A, A_inv);
+
+    std::ostringstream routines_oss;
+    for (size_t i = 0; i < called_routines.size(); ++i) {
+        if (i) routines_oss << ',';
+        routines_oss << called_routines[i];
+    }
+
+    std::cout << std::fixed << std::setprecision(9);
+    std::cout << "RESULT_SECONDS=" << elapsed.count() << std::endl;
+    std::cout << "DIAG_THREADS=" << backend_threads() << std::endl;
+#if defined(EIGEN_USE_MKL_ALL)
+    std::cout << "DIAG_THREADING=" << layer << "," << threading_summary() << std::endl;
+#endif
+    std::cout << "DIAG_PEAK_RSS_KB=" << rss_kb << std::endl;
+    std::cout << "DIAG_ROUTINES=" << routines_oss.str() << std::endl;
+    std::cout << std::scientific << std::setprecision(6);
+    std::cout << "DIAG_RESIDUAL=" << residual << std::endl;
+    std::cout << std::fixed;
+    std::cout << "DIAG_CHECKSUM=" << checksum << std::endl;
+
+    return 0;
+}
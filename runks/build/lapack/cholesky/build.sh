@@ -19,6 +19,8 @@ build_container() {
 echo "Building Lapack-OpenBlas Docker containers..."
 
 build_container "lapack_chol" "Dockerfile.lachol"
+# 64-битные индексы для n > 46340
+build_container "lapack_chol_ilp64" "Dockerfile.lachol_ilp64"
 
 
 cd ../
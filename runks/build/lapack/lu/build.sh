@@ -19,6 +19,8 @@ build_container() {
 echo "Building Lapack-OpenBlas Docker containers..."
 
 build_container "lapack_lu" "Dockerfile.lapackLU"
+# 64-битные индексы для n > 46340
+build_container "lapack_lu_ilp64" "Dockerfile.lapackLU_ilp64"
 
 
 cd ../
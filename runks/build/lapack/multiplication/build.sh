@@ -19,6 +19,8 @@ build_container() {
 echo "Building Lapack-OpenBlas Docker containers..."
 
 build_container "lapack_mul" "Dockerfile.lamul"
+# 64-битные индексы для n > 46340
+build_container "lapack_mul_ilp64" "Dockerfile.lamul_ilp64"
 
 
 cd ../
@@ -1,70 +1,1175 @@
 #include <iostream>
 #include <iomanip>
 #include <vector>
+#include <array>
 #include <string>
 #include <sstream>
 #include <random>
 #include <chrono>
 #include <cblas.h>
 #include <sys/resource.h>
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <cerrno>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <dirent.h>
+#include <atomic>
+#include <malloc.h>
+#include <unistd.h>
+#include <charconv>
+#include <memory>
+#include <cstdint>
+#include <exception>
+#include <stdexcept>
+#include <map>
+#include <cmath>
+#include <limits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <sched.h>
 
 // Список вызванных подпрограмм BLAS/LAPACK
 std::vector<std::string> called_routines;
 
+// Энергия через Linux powercap (Intel RAPL): домены package и dram.
+// Счётчики energy_uj растут до max_energy_range_uj и обнуляются, поэтому
+// фоновый поток опрашивает их раз в секунду, чтобы не пропустить переполнение.
+// Энергия между вызовами phase() приписывается названной подпрограмме
+class RaplMeter {
+public:
+    void start() {
+        open();
+        if (!available())
+            return;
+        sample();
+        for (Domain& d : domains)
+            d.joules = 0.0;
+        running = true;
+        poller = std::thread([this] {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!wake.wait_for(lock, std::chrono::seconds(1), [this] { return !running; }))
+                sample();
+        });
+    }
+
+    void phase(const std::string& name) {
+        if (!available())
+            return;
+        std::lock_guard<std::mutex> lock(mutex);
+        double now = sample();
+        if (!current.empty()) {
+            auto it = std::find_if(phases.begin(), phases.end(),
+                                   [this](const std::pair<std::string, double>& p) { return p.first == current; });
+            if (it == phases.end())
+                it = phases.insert(phases.end(), std::make_pair(current, 0.0));
+            it->second += now - phase_start;
+        }
+        current = name;
+        phase_start = now;
+    }
+
+    void stop() {
+        if (!available())
+            return;
+        phase("");
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+        }
+        wake.notify_all();
+        poller.join();
+    }
+
+    bool available() const { return status == "ok"; }
+
+    // gflop – номинальное число операций замеряемого участка
+    void report(double gflop) const {
+        std::cout << "DIAG_ENERGY_STATUS=" << status << std::endl;
+        if (!available())
+            return;
+        double total = 0.0;
+        std::ostringstream domains_oss, phases_oss;
+        domains_oss << std::fixed << std::setprecision(6);
+        phases_oss << std::fixed << std::setprecision(6);
+        for (size_t i = 0; i < domains.size(); ++i) {
+            total += domains[i].joules;
+            domains_oss << (i ? "," : "") << domains[i].label << ':' << domains[i].joules;
+        }
+        for (size_t i = 0; i < phases.size(); ++i)
+            phases_oss << (i ? "," : "") << phases[i].first << ':' << phases[i].second;
+        std::cout << "DIAG_ENERGY_J=" << total << std::endl;
+        std::cout << "DIAG_ENERGY_J_PER_GFLOP=" << total / gflop << std::endl;
+        std::cout << "DIAG_ENERGY_DOMAINS=" << domains_oss.str() << std::endl;
+        std::cout << "DIAG_ENERGY_ROUTINES=" << phases_oss.str() << std::endl;
+    }
+
+private:
+    struct Domain {
+        std::string label;
+        std::string path;
+        double max_uj;
+        double last_uj;
+        double joules;
+    };
+
+    // Домены верхнего уровня intel-rapl:N (package-N) и их поддомены dram
+    void open() {
+        const std::string root = "/sys/class/powercap/";
+        DIR* dir = opendir(root.c_str());
+        if (!dir) {
+            status = "unavailable:" + root + ": " + std::strerror(errno);
+            return;
+        }
+        std::vector<std::string> zones;
+        while (dirent* entry = readdir(dir)) {
+            std::string zone = entry->d_name;
+            if (zone.rfind("intel-rapl:", 0) == 0)
+                zones.push_back(zone);
+        }
+        closedir(dir);
+        std::sort(zones.begin(), zones.end());
+
+        for (const std::string& zone : zones) {
+            std::string path = root + zone + "/";
+            std::string name;
+            std::ifstream(path + "name") >> name;
+            std::string package = zone.substr(11, zone.find(':', 11) - 11);
+            if (name == "dram")
+                name += "-" + package;
+            else if (name.rfind("package", 0) != 0)
+                continue;
+
+            Domain d;
+            d.label = name;
+            d.path = path + "energy_uj";
+            d.max_uj = 0.0;
+            std::ifstream(path + "max_energy_range_uj") >> d.max_uj;
+            d.joules = 0.0;
+            errno = 0;
+            std::ifstream counter(d.path);
+            if (!(counter >> d.last_uj)) {
+                status = "unavailable:" + d.path + ": " + (errno ? std::strerror(errno) : "unreadable");
+                domains.clear();
+                return;
+            }
+            domains.push_back(d);
+        }
+        status = domains.empty() ? "unavailable:no intel-rapl package/dram domains" : "ok";
+    }
+
+    // Вызывается под mutex (или до запуска потока); возвращает джоули с начала замера
+    double sample() {
+        double total = 0.0;
+        for (Domain& d : domains) {
+            double uj = d.last_uj;
+            std::ifstream(d.path) >> uj;
+            double delta = uj - d.last_uj;
+            if (delta < 0.0)
+                delta += d.max_uj;
+            d.joules += delta * 1e-6;
+            d.last_uj = uj;
+            total += d.joules;
+        }
+        return total;
+    }
+
+    std::string status = "unavailable:not started";
+    std::vector<Domain> domains;
+    std::vector<std::pair<std::string, double>> phases;
+    std::string current;
+    double phase_start = 0.0;
+    bool running = false;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::thread poller;
+};
+
+RaplMeter rapl;
+
+// Учёт выделений памяти: malloc/free и их родственники из программы перекрывают
+// версии glibc для всего процесса, включая OpenBLAS/MKL и временные буферы
+// LAPACKE, и передают вызов в __libc_*. Размер берётся из malloc_usable_size
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void* __libc_valloc(size_t size);
+void* __libc_pvalloc(size_t size);
+void __libc_free(void* ptr);
+}
+
+namespace heap {
+std::atomic<long long> live{0};       // байт выделено сейчас
+std::atomic<long long> peak{0};       // максимум live с начала фазы
+std::atomic<long long> allocated{0};  // байт выделено с начала программы
+std::atomic<long long> calls{0};
+
+inline void on_alloc(void* ptr) {
+    if (!ptr)
+        return;
+    long long size = malloc_usable_size(ptr);
+    allocated += size;
+    ++calls;
+    long long now = live += size;
+    long long prev = peak.load(std::memory_order_relaxed);
+    while (now > prev && !peak.compare_exchange_weak(prev, now, std::memory_order_relaxed))
+        ;
+}
+
+inline void on_free(void* ptr) {
+    if (ptr)
+        live -= (long long)malloc_usable_size(ptr);
+}
+}  // namespace heap
+
+extern "C" {
+void* malloc(size_t size) noexcept {
+    void* ptr = __libc_malloc(size);
+    heap::on_alloc(ptr);
+    return ptr;
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+    void* ptr = __libc_calloc(count, size);
+    heap::on_alloc(ptr);
+    return ptr;
+}
+
+void* realloc(void* ptr, size_t size) noexcept {
+    long long old_size = ptr ? (long long)malloc_usable_size(ptr) : 0;
+    void* result = __libc_realloc(ptr, size);
+    if (result || size == 0) {
+        heap::live -= old_size;
+        heap::on_alloc(result);
+    }
+    return result;
+}
+
+void free(void* ptr) noexcept {
+    heap::on_free(ptr);
+    __libc_free(ptr);
+}
+
+void* memalign(size_t alignment, size_t size) noexcept {
+    void* ptr = __libc_memalign(alignment, size);
+    heap::on_alloc(ptr);
+    return ptr;
+}
+
+// Выравнивание – степень двойки; memalign молча округлил бы остальные,
+// а aligned_alloc и posix_memalign должны вернуть EINVAL, как в glibc
+static bool power_of_two(size_t alignment) {
+    return alignment != 0 && (alignment & (alignment - 1)) == 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept {
+    if (!power_of_two(alignment)) {
+        errno = EINVAL;
+        return nullptr;
+    }
+    return memalign(alignment, size);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) noexcept {
+    if (!power_of_two(alignment) || alignment % sizeof(void*) != 0)
+        return EINVAL;
+    void* ptr = memalign(alignment, size);
+    if (!ptr)
+        return ENOMEM;
+    *out = ptr;
+    return 0;
+}
+
+void* valloc(size_t size) noexcept {
+    void* ptr = __libc_valloc(size);
+    heap::on_alloc(ptr);
+    return ptr;
+}
+
+void* pvalloc(size_t size) noexcept {
+    void* ptr = __libc_pvalloc(size);
+    heap::on_alloc(ptr);
+    return ptr;
+}
+}
+
+// Память по фазам: на каждой границе phase() снимаются малые/большие отказы
+// страниц (getrusage), резидентный размер (/proc/self/statm) и счётчики выделений.
+// Фаза до первой отметки – startup (загрузка библиотек и разбор аргументов)
+class MemoryMeter {
+public:
+    MemoryMeter() {
+        mark = snapshot();
+    }
+
+    void phase(const std::string& name) {
+        Snapshot now = snapshot();
+        auto it = std::find_if(phases.begin(), phases.end(),
+                               [this](const Phase& p) { return p.name == current; });
+        if (it == phases.end()) {
+            it = phases.insert(phases.end(), Phase());
+            it->name = current;
+        }
+        it->alloc_bytes += now.allocated - mark.allocated;
+        it->heap_peak = std::max(it->heap_peak, heap::peak.load());
+        it->rss_delta += now.rss - mark.rss;
+        it->minflt += now.minflt - mark.minflt;
+        it->majflt += now.majflt - mark.majflt;
+        heap_peak_total = std::max(heap_peak_total, heap::peak.load());
+        heap::peak = heap::live.load();
+        current = name;
+        mark = now;
+    }
+
+    // Закрывает текущую фазу; поля фазы: выделено, пик кучи и прирост RSS в КБ, отказы страниц
+    void report() {
+        phase(current);
+        std::ostringstream oss;
+        for (size_t i = 0; i < phases.size(); ++i) {
+            const Phase& p = phases[i];
+            oss << (i ? "," : "") << p.name
+                << ":alloc_kb=" << p.alloc_bytes / 1024
+                << ":heap_peak_kb=" << p.heap_peak / 1024
+                << ":rss_delta_kb=" << p.rss_delta / 1024
+                << ":minflt=" << p.minflt
+                << ":majflt=" << p.majflt;
+        }
+        std::cout << "DIAG_MEM_PHASES=" << oss.str() << std::endl;
+        std::cout << "DIAG_MEM_HEAP_PEAK_KB=" << heap_peak_total / 1024 << std::endl;
+        std::cout << "DIAG_MEM_ALLOCS=" << heap::calls.load() << std::endl;
+    }
+
+private:
+    struct Snapshot {
+        long long allocated;
+        long long rss;
+        long minflt;
+        long majflt;
+    };
+
+    struct Phase {
+        std::string name;
+        long long alloc_bytes = 0;
+        long long heap_peak = 0;
+        long long rss_delta = 0;
+        long minflt = 0;
+        long majflt = 0;
+    };
+
+    static Snapshot snapshot() {
+        Snapshot s;
+        s.allocated = heap::allocated.load();
+        long pages = 0, resident = 0;
+        std::ifstream("/proc/self/statm") >> pages >> resident;
+        s.rss = (long long)resident * sysconf(_SC_PAGESIZE);
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        s.minflt = usage.ru_minflt;
+        s.majflt = usage.ru_majflt;
+        return s;
+    }
+
+    std::vector<Phase> phases;
+    std::string current = "startup";
+    Snapshot mark;
+    long long heap_peak_total = 0;
+};
+
+MemoryMeter memory;
+
+// Необязательные параметры вида --key=value
+std::map<std::string, std::string> parse_options(int argc, char* argv[], int first) {
+    std::map<std::string, std::string> options;
+    for (int i = first; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+            throw std::invalid_argument("Unknown argument: " + arg);
+        options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+    }
+    return options;
+}
+
+std::string option(const std::map<std::string, std::string>& options,
+                   const std::string& key, const std::string& fallback) {
+    auto it = options.find(key);
+    return it == options.end() ? fallback : it->second;
+}
+
+// Матрица из файла --input=путь вместо синтетической. Форматы:
+// - .npy: float64/float32/int64/int32, C- или Fortran-порядок;
+// - Matrix Market: array и coordinate, real/integer/pattern,
+//   general/symmetric/skew-symmetric;
+// - сырой двоичный: double в строчном порядке, квадратная матрица или --input-shape=RxC.
+// Файл отображается mmap. float64 в C-порядке и сырой формат используются на месте
+// без копирования, остальное за один проход приводится к плотному строчному
+// формату, с которым работают программы. Текст Matrix Market разбирается
+// параллельно по кускам файла
+class InputMatrix {
+public:
+    int rows = 0, cols = 0;
+    std::string format = "synthetic";
+    bool mapped = false;        // данные лежат в отображении файла
+    double load_seconds = 0.0;
+
+    InputMatrix() = default;
+    InputMatrix(std::vector<double>&& values, int r, int c)
+        : rows(r), cols(c), storage(std::move(values)), view(storage.data()) {}
+    InputMatrix(std::shared_ptr<void> file, const double* data, int r, int c)
+        : rows(r), cols(c), mapped(true), mapping(std::move(file)), view(data) {}
+    InputMatrix(InputMatrix&&) = default;
+    InputMatrix& operator=(InputMatrix&&) = default;
+
+    const double* data() const { return view; }
+    const double* begin() const { return view; }
+    const double* end() const { return view + size(); }
+    size_t size() const { return (size_t)rows * cols; }
+
+    void report() const {
+        std::cout << "DIAG_INPUT=" << format << ":" << rows << "x" << cols << ":"
+                  << (mapped ? "mapped" : "converted") << ":" << load_seconds << std::endl;
+    }
+
+private:
+    std::vector<double> storage;
+    std::shared_ptr<void> mapping;  // munmap при уничтожении
+    const double* view = nullptr;
+};
+
+struct MappedFile {
+    const char* bytes = nullptr;
+    size_t length = 0;
+    std::shared_ptr<void> owner;
+};
+
+MappedFile map_file(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::invalid_argument("Cannot open " + path + ": " + std::strerror(errno));
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        throw std::invalid_argument("Empty or unreadable input: " + path);
+    }
+    size_t length = st.st_size;
+    void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        throw std::invalid_argument("Cannot mmap " + path + ": " + std::strerror(errno));
+    madvise(p, length, MADV_SEQUENTIAL);
+    MappedFile file;
+    file.bytes = static_cast<const char*>(p);
+    file.length = length;
+    file.owner = std::shared_ptr<void>(p, [length](void* q) { munmap(q, length); });
+    return file;
+}
+
+// fn(part, begin, end) для parts частей диапазона [0, count) в отдельных потоках;
+// исключение из любого потока пробрасывается вызывающему
+template<class F>
+void parallel_parts(size_t count, int parts, F&& fn) {
+    parts = (int)std::max<size_t>(1, std::min<size_t>(parts, count));
+    std::vector<std::exception_ptr> errors(parts);
+    std::vector<std::thread> pool;
+    for (int p = 0; p < parts; ++p)
+        pool.emplace_back([&, p] {
+            try {
+                fn(p, count * p / parts, count * (p + 1) / parts);
+            } catch (...) {
+                errors[p] = std::current_exception();
+            }
+        });
+    for (std::thread& t : pool)
+        t.join();
+    for (std::exception_ptr& e : errors)
+        if (e)
+            std::rethrow_exception(e);
+}
+
+int loader_threads(size_t bytes) {
+    // Не меньше 4 МБ на поток: на маленьких файлах потоки дороже разбора
+    size_t by_size = std::max<size_t>(1, bytes >> 22);
+    return (int)std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), by_size);
+}
+
+// Элементы файла типа T (в строчном или столбцовом порядке) -> строчный double
+template<class T>
+std::vector<double> convert_dense(const char* src, int rows, int cols, bool column_major) {
+    std::vector<double> out((size_t)rows * cols);
+    parallel_parts(rows, loader_threads(out.size() * sizeof(T)), [&](int, size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i)
+            for (int j = 0; j < cols; ++j) {
+                size_t k = column_major ? (size_t)j * rows + i : i * cols + j;
+                T value;
+                std::memcpy(&value, src + k * sizeof(T), sizeof(T));
+                out[i * cols + j] = (double)value;
+            }
+    });
+    return out;
+}
+
+InputMatrix load_npy(const MappedFile& file) {
+    if (file.length < 10 || std::memcmp(file.bytes, "\x93NUMPY", 6) != 0)
+        throw std::invalid_argument("Not a .npy file");
+    int major = (unsigned char)file.bytes[6];
+    size_t header_len, header_start;
+    if (major == 1) {
+        header_len = (unsigned char)file.bytes[8] | ((unsigned char)file.bytes[9] << 8);
+        header_start = 10;
+    } else {
+        uint32_t len;
+        std::memcpy(&len, file.bytes + 8, 4);
+        header_len = len;
+        header_start = 12;
+    }
+    if (header_start + header_len > file.length)
+        throw std::invalid_argument(".npy header is truncated");
+    std::string header(file.bytes + header_start, header_len);
+
+    auto value_of = [&](const std::string& key) {
+        size_t pos = header.find("'" + key + "'");
+        if (pos == std::string::npos)
+            throw std::invalid_argument(".npy header has no " + key);
+        pos = header.find(':', pos) + 1;
+        while (pos < header.size() && header[pos] == ' ')
+            ++pos;
+        return pos;
+    };
+    size_t pos = value_of("descr");
+    std::string descr = header.substr(pos + 1, header.find('\'', pos + 1) - pos - 1);
+    bool column_major = header.compare(value_of("fortran_order"), 4, "True") == 0;
+    pos = value_of("shape");
+    std::vector<long> shape;
+    for (size_t end = header.find(')', pos); pos < end;) {
+        if (isdigit((unsigned char)header[pos])) {
+            size_t used;
+            shape.push_back(std::stol(header.substr(pos), &used));
+            pos += used;
+        } else {
+            ++pos;
+        }
+    }
+    if (shape.size() != 2)
+        throw std::invalid_argument(".npy array must be 2-dimensional");
+    int rows = (int)shape[0], cols = (int)shape[1];
+
+    if (descr.size() != 3 || descr[0] == '>')
+        throw std::invalid_argument("Unsupported .npy dtype " + descr);
+    std::string type = descr.substr(1);
+    size_t item = (size_t)(type[1] - '0');
+    size_t offset = header_start + header_len;
+    if (offset + (size_t)rows * cols * item > file.length)
+        throw std::invalid_argument(".npy data is truncated");
+    const char* data = file.bytes + offset;
+
+    InputMatrix matrix;
+    if (type == "f8" && !column_major && offset % sizeof(double) == 0)
+        matrix = InputMatrix(file.owner, reinterpret_cast<const double*>(data), rows, cols);
+    else if (type == "f8")
+        matrix = InputMatrix(convert_dense<double>(data, rows, cols, column_major), rows, cols);
+    else if (type == "f4")
+        matrix = InputMatrix(convert_dense<float>(data, rows, cols, column_major), rows, cols);
+    else if (type == "i8")
+        matrix = InputMatrix(convert_dense<int64_t>(data, rows, cols, column_major), rows, cols);
+    else if (type == "i4")
+        matrix = InputMatrix(convert_dense<int32_t>(data, rows, cols, column_major), rows, cols);
+    else
+        throw std::invalid_argument("Unsupported .npy dtype " + descr);
+    matrix.format = "npy-" + type;
+    return matrix;
+}
+
+InputMatrix load_raw(const MappedFile& file, const std::string& shape) {
+    size_t count = file.length / sizeof(double);
+    int rows, cols;
+    if (!shape.empty()) {
+        size_t x = shape.find('x');
+        rows = std::stoi(shape.substr(0, x));
+        cols = (x == std::string::npos) ? rows : std::stoi(shape.substr(x + 1));
+    } else {
+        rows = cols = (int)std::llround(std::sqrt((double)count));
+    }
+    if (file.length % sizeof(double) != 0 || (size_t)rows * cols != count)
+        throw std::invalid_argument("Raw input of " + std::to_string(file.length) +
+                                    " bytes does not match the matrix shape; use --input-shape=RxC");
+    InputMatrix matrix(file.owner, reinterpret_cast<const double*>(file.bytes), rows, cols);
+    matrix.format = "raw";
+    return matrix;
+}
+
+// Пробелы и строки-комментарии '%' перед следующим числом
+const char* skip_blank(const char* p, const char* end) {
+    while (p < end) {
+        if (*p == '%')
+            while (p < end && *p != '\n')
+                ++p;
+        else if (isspace((unsigned char)*p))
+            ++p;
+        else
+            break;
+    }
+    return p;
+}
+
+template<class T>
+const char* parse_number(const char* p, const char* end, T& value) {
+    if (p < end && *p == '+')
+        ++p;
+    std::from_chars_result r = std::from_chars(p, end, value);
+    if (r.ec != std::errc())
+        throw std::invalid_argument("Matrix Market: bad number '" + std::string(p, std::min<size_t>(end - p, 16)) + "'");
+    return r.ptr;
+}
+
+// Границы кусков текста [begin, end) по началам строк
+std::vector<const char*> split_lines(const char* begin, const char* end, int parts) {
+    std::vector<const char*> cuts{begin};
+    for (int p = 1; p < parts; ++p) {
+        const char* cut = std::max(begin + (end - begin) * p / parts, cuts.back());
+        while (cut < end && *cut != '\n')
+            ++cut;
+        cuts.push_back(cut < end ? cut + 1 : end);
+    }
+    cuts.push_back(end);
+    return cuts;
+}
+
+InputMatrix load_matrix_market(const MappedFile& file) {
+    const char* end = file.bytes + file.length;
+    const char* line_end = std::find(file.bytes, end, '\n');
+    std::istringstream banner(std::string(file.bytes, line_end));
+    std::string tag, object, layout, field, symmetry;
+    banner >> tag >> object >> layout >> field >> symmetry;
+    for (std::string* s : {&object, &layout, &field, &symmetry})
+        std::transform(s->begin(), s->end(), s->begin(), ::tolower);
+    if (object != "matrix" || (layout != "array" && layout != "coordinate") ||
+        (field != "real" && field != "integer" && field != "double" && field != "pattern") ||
+        (symmetry != "general" && symmetry != "symmetric" && symmetry != "skew-symmetric"))
+        throw std::invalid_argument("Unsupported Matrix Market header: " + std::string(file.bytes, line_end));
+    bool coordinate = (layout == "coordinate"), pattern = (field == "pattern");
+    bool general = (symmetry == "general"), skew = (symmetry == "skew-symmetric");
+
+    // Строка размеров: rows cols [nnz]
+    long rows, cols, entries;
+    const char* p = parse_number(skip_blank(line_end, end), end, rows);
+    p = parse_number(skip_blank(p, end), end, cols);
+    if (coordinate)
+        p = parse_number(skip_blank(p, end), end, entries);
+    else
+        entries = general ? rows * cols : skew ? rows * (rows - 1) / 2 : rows * (rows + 1) / 2;
+    if (!general && rows != cols)
+        throw std::invalid_argument("Symmetric Matrix Market matrix must be square");
+
+    std::vector<double> dense((size_t)rows * cols, 0.0);
+    double mirror = skew ? -1.0 : 1.0;
+    std::vector<const char*> cuts = split_lines(p, end, loader_threads(end - p));
+    int parts = (int)cuts.size() - 1;
+
+    // array: значения по столбцам (у симметричных – нижний треугольник), и
+    // позиция зависит от номера значения, поэтому сначала считаются числа в кусках
+    std::vector<size_t> first(parts + 1, 0);
+    if (!coordinate) {
+        parallel_parts(parts, parts, [&](int, size_t k, size_t) {
+            size_t count = 0;
+            for (const char* q = skip_blank(cuts[k], cuts[k + 1]); q < cuts[k + 1]; q = skip_blank(q, cuts[k + 1])) {
+                ++count;
+                while (q < cuts[k + 1] && !isspace((unsigned char)*q))
+                    ++q;
+            }
+            first[k + 1] = count;
+        });
+        for (int k = 0; k < parts; ++k)
+            first[k + 1] += first[k];
+    }
+
+    std::vector<size_t> found(parts, 0);
+    parallel_parts(parts, parts, [&](int, size_t k, size_t) {
+        const char* q = skip_blank(cuts[k], cuts[k + 1]);
+        const char* stop = cuts[k + 1];
+        if (coordinate) {
+            for (; q < stop; q = skip_blank(q, stop)) {
+                long i, j;
+                double v = 1.0;
+                q = parse_number(q, stop, i);
+                q = parse_number(skip_blank(q, stop), stop, j);
+                if (!pattern)
+                    q = parse_number(skip_blank(q, stop), stop, v);
+                if (i < 1 || i > rows || j < 1 || j > cols)
+                    throw std::invalid_argument("Matrix Market entry out of range");
+                dense[(i - 1) * cols + (j - 1)] = v;
+                if (!general && i != j)
+                    dense[(j - 1) * cols + (i - 1)] = mirror * v;
+                ++found[k];
+            }
+            return;
+        }
+        // Индекс первого значения куска -> (i, j) и дальше по порядку столбцов
+        size_t index = first[k];
+        long i = 0, j = 0;
+        if (general) {
+            j = index / rows;
+            i = index % rows;
+        } else {
+            long start = skew ? 1 : 0;
+            for (j = 0; j < cols; ++j) {
+                size_t column = rows - j - start;
+                if (index < column)
+                    break;
+                index -= column;
+            }
+            i = j + start + index;
+        }
+        for (; q < stop; q = skip_blank(q, stop)) {
+            double v;
+            q = parse_number(q, stop, v);
+            if (j >= cols)
+                throw std::invalid_argument("Matrix Market array has too many values");
+            dense[i * cols + j] = v;
+            if (!general)
+                dense[j * cols + i] = mirror * v;
+            ++found[k];
+            if (++i == rows) {
+                ++j;
+                i = general ? 0 : j + (skew ? 1 : 0);
+            }
+        }
+    });
+    size_t total = 0;
+    for (size_t f : found)
+        total += f;
+    if (total != (size_t)entries)
+        throw std::invalid_argument("Matrix Market: expected " + std::to_string(entries) +
+                                    " values, found " + std::to_string(total));
+
+    InputMatrix matrix(std::move(dense), (int)rows, (int)cols);
+    matrix.format = "mtx-" + layout + "-" + symmetry;
+    return matrix;
+}
+
+// --<key>=путь: формат по сигнатуре файла; размер квадратной матрицы
+// записывается в n (если n уже задан аргументом, он должен совпасть).
+// Без --<key> возвращается пустая матрица
+InputMatrix load_input(const std::map<std::string, std::string>& options, const std::string& key, int& n) {
+    auto it = options.find(key);
+    if (it == options.end())
+        return InputMatrix();
+    memory.phase("load-" + key);
+    auto start = std::chrono::steady_clock::now();
+    MappedFile file = map_file(it->second);
+    InputMatrix matrix;
+    if (file.length >= 6 && std::memcmp(file.bytes, "\x93NUMPY", 6) == 0)
+        matrix = load_npy(file);
+    else if (file.length >= 14 && std::memcmp(file.bytes, "%%MatrixMarket", 14) == 0)
+        matrix = load_matrix_market(file);
+    else
+        matrix = load_raw(file, option(options, key + "-shape", ""));
+    matrix.load_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (matrix.rows != matrix.cols)
+        throw std::invalid_argument("Input matrix must be square, got " + std::to_string(matrix.rows) +
+                                    "x" + std::to_string(matrix.cols));
+    if (n > 0 && n != matrix.rows)
+        throw std::invalid_argument("Matrix size " + std::to_string(n) + " does not match input " +
+                                    std::to_string(matrix.rows));
+    n = matrix.rows;
+    return matrix;
+}
+
+// Первый аргумент – размер матрицы; с --input=путь его можно опустить.
+// Возвращает индекс первой опции
+int size_argument(int argc, char* argv[], int& n) {
+    if (argc >= 2 && std::string(argv[1]).rfind("--", 0) != 0) {
+        n = std::atoi(argv[1]);
+        return 2;
+    }
+    n = 0;
+    return 1;
+}
+
 // Создание положительно определённой матрицы
 std::vector<double> create_positive_definite_matrix(int n, int seed)  {
-    std::vector<double> matrix(n * n);
+    std::vector<double> matrix((size_t)n * n);
     std::mt19937 gen(seed);
     std::uniform_real_distribution<> dis(0.0, 1.0);
 
     for (int i = 0; i < n; ++i)
         for (int j = 0; j < n; ++j)
-            matrix[i * n + j] = dis(gen);
+            matrix[(size_t)i * n + j] = dis(gen);
 
     for (int i = 0; i < n; ++i) {
         for (int j = 0; j < i; ++j) {
-            double avg = (matrix[i * n + j] + matrix[j * n + i]) / 2.0;
-            matrix[i * n + j] = matrix[j * n + i] = avg;
+            double avg = (matrix[(size_t)i * n + j] + matrix[(size_t)j * n + i]) / 2.0;
+            matrix[(size_t)i * n + j] = matrix[(size_t)j * n + i] = avg;
     }
 }
     for (int i = 0; i < n; ++i)
-        matrix[i * n + i] += n;
+        matrix[(size_t)i * n + i] += n;
+
+    return matrix;
+}
+
+// C = alpha * op(A) * op(B) + beta * C в строчном формате: op(A) – m x k, op(B) – k x n.
+// Ведущие размерности 0 – минимальные (число столбцов хранимой матрицы)
+struct GemmShape {
+    int m = 0, n = 0, k = 0;
+    bool trans_a = false, trans_b = false;
+    double alpha = 1.0, beta = 0.0;
+    int lda = 0, ldb = 0, ldc = 0;
+
+    int a_rows() const { return trans_a ? k : m; }
+    int a_cols() const { return trans_a ? m : k; }
+    int b_rows() const { return trans_b ? n : k; }
+    int b_cols() const { return trans_b ? k : n; }
+    int ld_a() const { return lda ? lda : a_cols(); }
+    int ld_b() const { return ldb ? ldb : b_cols(); }
+    int ld_c() const { return ldc ? ldc : n; }
+    double flops() const { return 2.0 * m * n * k; }
+    // Память под хранимые A, B и C
+    double bytes() const {
+        return sizeof(double) * ((double)a_rows() * ld_a() + (double)b_rows() * ld_b() + (double)m * ld_c());
+    }
+    std::string ops() const { return std::string(trans_a ? "T" : "N") + (trans_b ? "T" : "N"); }
+    // Хранимые A и B – size x size без отступов (как у --input и прежнего генератора)
+    bool square(int size) const {
+        return a_rows() == size && ld_a() == size && b_rows() == size && ld_b() == size;
+    }
+};
+
+GemmShape parse_shape(const std::map<std::string, std::string>& options, int size) {
+    GemmShape g;
+    g.m = std::stoi(option(options, "m", std::to_string(size)));
+    g.n = std::stoi(option(options, "n", std::to_string(size)));
+    g.k = std::stoi(option(options, "k", std::to_string(size)));
+    if (g.m <= 0 || g.n <= 0 || g.k <= 0)
+        throw std::invalid_argument("m, n and k must be positive");
+    for (auto [key, flag] : {std::make_pair("transa", &g.trans_a), std::make_pair("transb", &g.trans_b)}) {
+        std::string value = option(options, key, "N");
+        if (value != "N" && value != "T")
+            throw std::invalid_argument(std::string("--") + key + " must be N or T");
+        *flag = (value == "T");
+    }
+    g.alpha = std::stod(option(options, "alpha", "1"));
+    g.beta = std::stod(option(options, "beta", "0"));
+    g.lda = std::stoi(option(options, "lda", "0"));
+    g.ldb = std::stoi(option(options, "ldb", "0"));
+    g.ldc = std::stoi(option(options, "ldc", "0"));
+    if ((g.lda && g.lda < g.a_cols()) || (g.ldb && g.ldb < g.b_cols()) || (g.ldc && g.ldc < g.n))
+        throw std::invalid_argument("Leading dimension is smaller than the number of columns");
+    return g;
+}
 
+// Прямоугольная матрица rows x ld со значениями из [0, 1)
+std::vector<double> create_random_matrix(int rows, int ld, int seed) {
+    std::vector<double> matrix((size_t)rows * ld);
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<> dis(0.0, 1.0);
+    for (double& v : matrix)
+        v = dis(gen);
     return matrix;
 }
 
+void run_gemm(const GemmShape& g, const double* A, const double* B, double* C) {
+    cblas_dgemm(CblasRowMajor, g.trans_a ? CblasTrans : CblasNoTrans, g.trans_b ? CblasTrans : CblasNoTrans,
+                g.m, g.n, g.k, g.alpha, A, g.ld_a(), B, g.ld_b(), g.beta, C, g.ld_c());
+}
+
+// Проверка произведения без второго dgemm: ||alpha op(A) (op(B) v) - C v|| /
+// (|alpha| ||A||_F ||B||_F ||v||) на случайном векторе v; C до вызова нулевая
+double verify_gemm(const GemmShape& g, const double* A, const double* B, const double* C) {
+    std::mt19937 gen(g.n + 3);
+    std::uniform_real_distribution<> dis(-1.0, 1.0);
+    std::vector<double> v(g.n), Bv(g.k), r(g.m);
+    for (double& x : v)
+        x = dis(gen);
+
+    cblas_dgemv(CblasRowMajor, g.trans_b ? CblasTrans : CblasNoTrans, g.b_rows(), g.b_cols(),
+                1.0, B, g.ld_b(), v.data(), 1, 0.0, Bv.data(), 1);
+    cblas_dgemv(CblasRowMajor, CblasNoTrans, g.m, g.n, 1.0, C, g.ld_c(), v.data(), 1, 0.0, r.data(), 1);
+    cblas_dgemv(CblasRowMajor, g.trans_a ? CblasTrans : CblasNoTrans, g.a_rows(), g.a_cols(),
+                g.alpha, A, g.ld_a(), Bv.data(), 1, -1.0, r.data(), 1);
+
+    // Нормы по строкам: хранимые матрицы могут быть с отступами
+    auto frobenius = [](const double* M, int rows, int cols, int ld) {
+        double s = 0.0;
+        for (int i = 0; i < rows; ++i) {
+            double row = cblas_dnrm2(cols, M + (size_t)i * ld, 1);
+            s += row * row;
+        }
+        return std::sqrt(s);
+    };
+    double scale = std::fabs(g.alpha) * frobenius(A, g.a_rows(), g.a_cols(), g.ld_a())
+                 * frobenius(B, g.b_rows(), g.b_cols(), g.ld_b()) * cblas_dnrm2(g.n, v.data(), 1);
+    return scale > 0.0 ? cblas_dnrm2(g.m, r.data(), 1) / scale : 0.0;
+}
+
+// Лучшее время из repeats вызовов после прогревочного
+double time_gemm(const GemmShape& g, int repeats) {
+    std::vector<double> A = create_random_matrix(g.a_rows(), g.ld_a(), 1);
+    std::vector<double> B = create_random_matrix(g.b_rows(), g.ld_b(), 2);
+    std::vector<double> C((size_t)g.m * g.ld_c(), 0.0);
+    double best = 0.0;
+    for (int r = 0; r <= repeats; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        run_gemm(g, A.data(), B.data(), C.data());
+        double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (r == 1 || (r > 1 && t < best))
+            best = t;
+    }
+    return best;
+}
+
+// Сетка форм с тем же числом операций 2 s^3, что у квадратной s x s x s:
+// «тонкая» – одна размерность s / r, две другие s * sqrt(r); «длинная» – одна
+// s * r, две другие s / sqrt(r). Для каждой формы – все заданные сочетания
+// транспонирования (NN, NT, TN, TT). Операнды тонкой формы растут как s^2 r, поэтому
+// вызывающий код пропускает формы сверх бюджета памяти --sweep-mb
+std::vector<GemmShape> sweep_shapes(int s, const std::vector<int>& ratios, const std::vector<std::string>& ops) {
+    std::vector<std::array<int, 3>> dims{{s, s, s}};
+    for (int r : ratios) {
+        if (r <= 1)
+            continue;
+        int small = std::max(1, s / r), wide = (int)std::lround(s * std::sqrt((double)r));
+        int large = s * r, narrow = std::max(1, (int)std::lround(s / std::sqrt((double)r)));
+        for (int d = 0; d < 3; ++d) {
+            std::array<int, 3> thin{wide, wide, wide}, longer{narrow, narrow, narrow};
+            thin[d] = small;
+            longer[d] = large;
+            dims.push_back(thin);
+            dims.push_back(longer);
+        }
+    }
+    std::vector<GemmShape> shapes;
+    for (const std::array<int, 3>& d : dims)
+        for (const std::string& op : ops) {
+            GemmShape g;
+            g.m = d[0];
+            g.n = d[1];
+            g.k = d[2];
+            g.trans_a = (op[0] == 'T');
+            g.trans_b = (op[1] == 'T');
+            shapes.push_back(g);
+        }
+    return shapes;
+}
+
+std::vector<std::string> split_list(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ','))
+        if (!item.empty())
+            items.push_back(item);
+    return items;
+}
+
+// Вариант сборки OpenBLAS (Debian): pthread, openmp и serial ставятся рядом в
+// <libdir>/openblas-<вариант>/. Загруженную библиотеку не заменить, поэтому
+// программа перезапускает себя с LD_LIBRARY_PATH на каталог нужного варианта
+std::string openblas_variant() {
+    switch (openblas_get_parallel()) {
+    case 0:
+        return "serial";
+    case 2:
+        return "openmp";
+    default:
+        return "pthread";
+    }
+}
+
+// Файл загруженной libopenblas по /proc/self/maps (символические ссылки уже раскрыты)
+std::string openblas_library() {
+    std::ifstream maps("/proc/self/maps");
+    std::string line;
+    while (std::getline(maps, line)) {
+        size_t slash = line.find('/');
+        if (slash != std::string::npos && line.find("/libopenblas", slash) != std::string::npos)
+            return line.substr(slash);
+    }
+    return "";
+}
+
+// Возвращается, только если нужный вариант уже загружен; иначе исключение или exec
+void select_openblas_variant(const std::string& variant, char* argv[]) {
+    if (variant != "pthread" && variant != "openmp" && variant != "serial")
+        throw std::invalid_argument("Unknown --openblas: " + variant);
+    if (openblas_variant() == variant)
+        return;
+    std::string library = openblas_library();
+    if (std::getenv("OPENBLAS_VARIANT_EXEC") || library.empty())
+        throw std::invalid_argument("OpenBLAS variant is not installed: " + variant);
+
+    // .../openblas-pthread/libopenblas.so.0 -> .../openblas-<variant>
+    std::string dir = library.substr(0, library.rfind('/'));
+    dir = dir.substr(0, dir.rfind('/')) + "/openblas-" + variant;
+    const char* old = std::getenv("LD_LIBRARY_PATH");
+    std::string path = dir + (old && *old ? ":" + std::string(old) : "");
+    setenv("LD_LIBRARY_PATH", path.c_str(), 1);
+    setenv("OPENBLAS_VARIANT_EXEC", variant.c_str(), 1);
+    execv("/proc/self/exe", argv);
+    throw std::invalid_argument(std::string("execv failed: ") + std::strerror(errno));
+}
+
+// Признаки переподписки ядер: несколько рантаймов OpenMP в одном процессе,
+// разрешённые вложенные параллельные участки и потоков больше, чем CPU.
+// Пулы потоков BLAS живут до выхода, поэтому снимок после замера их застаёт
+struct Oversubscription {
+    std::vector<std::string> runtimes;  // iomp5, gomp, omp, tbb
+    int threads = 0;
+    int cpus = 0;
+    int levels = 1;
+
+    static Oversubscription detect() {
+        Oversubscription o;
+        std::ifstream maps("/proc/self/maps");
+        std::string line;
+        static const std::pair<const char*, const char*> libraries[] = {
+            {"/libiomp5", "iomp5"}, {"/libgomp", "gomp"}, {"/libomp.", "omp"}, {"/libtbb.", "tbb"}};
+        while (std::getline(maps, line))
+            for (const auto& library : libraries)
+                if (line.find(library.first) != std::string::npos &&
+                    std::find(o.runtimes.begin(), o.runtimes.end(), library.second) == o.runtimes.end())
+                    o.runtimes.push_back(library.second);
+
+        std::ifstream status("/proc/self/status");
+        while (std::getline(status, line))
+            if (line.rfind("Threads:", 0) == 0)
+                o.threads = std::atoi(line.c_str() + 8);
+
+        cpu_set_t allowed;
+        sched_getaffinity(0, sizeof(allowed), &allowed);
+        o.cpus = CPU_COUNT(&allowed);
+
+        // Функции OpenMP ищутся в уже загруженных библиотеках: программа с OpenMP не связана
+        using LevelsFn = int (*)();
+        if (auto max_levels = (LevelsFn)dlsym(RTLD_DEFAULT, "omp_get_max_active_levels"))
+            o.levels = max_levels();
+        return o;
+    }
+
+    // Главный поток плюс один служебный допустимы сверх числа CPU
+    std::string problems() const {
+        std::vector<std::string> found;
+        int openmp = (int)runtimes.size() - (int)std::count(runtimes.begin(), runtimes.end(), "tbb");
+        if (openmp > 1) {
+            std::string list;
+            for (const std::string& r : runtimes)
+                if (r != "tbb")
+                    list += (list.empty() ? "" : "+") + r;
+            found.push_back("runtimes:" + list);
+        }
+        if (levels > 1)
+            found.push_back("nested:" + std::to_string(levels));
+        if (threads > cpus + 1)
+            found.push_back("threads:" + std::to_string(threads) + ">" + std::to_string(cpus));
+        std::string joined;
+        for (const std::string& f : found)
+            joined += (joined.empty() ? "" : ";") + f;
+        return joined.empty() ? "none" : joined;
+    }
+
+    std::string summary() const {
+        std::string list;
+        for (const std::string& r : runtimes)
+            list += (list.empty() ? "" : "+") + r;
+        return "runtimes:" + (list.empty() ? std::string("none") : list) + ",threads:" + std::to_string(threads) +
+               ",cpus:" + std::to_string(cpus) + ",levels:" + std::to_string(levels);
+    }
+};
+
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <matrix_size>" << std::endl;
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <matrix_size>|--input=path [--input-shape=RxC] [--input-b=path] [--input-b-shape=RxC]"
+                  << " [--m=M] [--n=N] [--k=K] [--transa=N|T] [--transb=N|T] [--alpha=1] [--beta=0]"
+                  << " [--lda=..] [--ldb=..] [--ldc=..] [--sweep=1] [--ratios=4,16,64] [--sweep-ops=NN,NT,TN,TT] [--sweep-mb=4096] [--repeats=3]"
+                  << " [--openblas=pthread|openmp|serial]" << std::endl;
         return 1;
     }
 
-    int n = std::stoi(argv[1]);
+    int n;
+    int first = size_argument(argc, argv, n);
+
+    std::map<std::string, std::string> options;
+    InputMatrix matrixA, matrixB;
+    GemmShape shape;
+    try {
+        options = parse_options(argc, argv, first);
+        // Вариант OpenBLAS выбирается до чтения входа: при смене программа перезапускается
+        select_openblas_variant(option(options, "openblas", openblas_variant()), argv);
+        matrixA = load_input(options, "input", n);
+        matrixB = load_input(options, "input-b", n);
+        // Форма произведения; по умолчанию m = n = k = размер матрицы
+        shape = parse_shape(options, std::max(n, 1));
+        if ((matrixA.size() || matrixB.size()) && !shape.square(n))
+            throw std::invalid_argument("--input requires m = n = k = matrix size and default leading dimensions");
+    } catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    if (n <= 0) {
+        std::cerr << "Matrix size must be positive" << std::endl;
+        return 1;
+    }
 
     // Получаем текущее число потоков
     int num_threads = openblas_get_num_threads();
 
-    std::vector<double> matrixA = create_positive_definite_matrix(n, n);
-    std::vector<double> matrixB = create_positive_definite_matrix(n, n + 1);
-    std::vector<double> result(n * n, 0.0);
+    // Матрицы, не заданные файлами, генерируются
+    memory.phase("generate");
+    // Квадратные матрицы без отступов – прежним генератором, остальные – случайные
+    bool square = shape.square(n);
+    if (matrixA.size() == 0)
+        matrixA = square ? InputMatrix(create_positive_definite_matrix(n, n), n, n)
+                         : InputMatrix(create_random_matrix(shape.a_rows(), shape.ld_a(), n), shape.a_rows(), shape.ld_a());
+    if (matrixB.size() == 0)
+        matrixB = square ? InputMatrix(create_positive_definite_matrix(n, n + 1), n, n)
+                         : InputMatrix(create_random_matrix(shape.b_rows(), shape.ld_b(), n + 1), shape.b_rows(), shape.ld_b());
+    memory.phase("workspace");
+    std::vector<double> result((size_t)shape.m * shape.ld_c(), 0.0);
     called_routines.push_back("dgemm");
+    rapl.start();
     auto start = std::chrono::steady_clock::now();
+    rapl.phase("dgemm");
+    memory.phase("dgemm");
 
     // Регистрируем и выполняем умножение матриц
     
-    cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
-                n, n, n,
-                1.0, matrixA.data(), n,
-                matrixB.data(), n,
-                0.0, result.data(), n);
+    run_gemm(shape, matrixA.data(), matrixB.data(), result.data());
 
     auto end = std::chrono::steady_clock::now();
+    rapl.stop();
+    memory.phase("verify");
     std::chrono::duration<double> elapsed = end - start;
 
     // Пиковое потребление памяти (RSS) в килобайтах
     struct rusage usage;
     getrusage(RUSAGE_SELF, &usage);
     long rss_kb = usage.ru_maxrss;
+    Oversubscription oversubscription = Oversubscription::detect();
+    double residual = verify_gemm(shape, matrixA.data(), matrixB.data(), result.data());
+
+    // Развёртка форм вокруг квадратной n x n x n (после замера RSS)
+    std::vector<std::pair<GemmShape, double>> sweep;
+    std::vector<GemmShape> sweep_skipped;
+    int repeats = std::max(1, std::stoi(option(options, "repeats", "3")));
+    if (option(options, "sweep", "0") != "0") {
+        std::vector<int> ratios;
+        for (const std::string& r : split_list(option(options, "ratios", "4,16,64")))
+            ratios.push_back(std::stoi(r));
+        double budget = std::stod(option(options, "sweep-mb", "4096")) * 1024.0 * 1024.0;
+        for (const GemmShape& g : sweep_shapes(n, ratios, split_list(option(options, "sweep-ops", "NN,NT,TN,TT")))) {
+            if (g.bytes() > budget)
+                sweep_skipped.push_back(g);
+            else
+                sweep.emplace_back(g, time_gemm(g, repeats));
+        }
+    }
 
     // Контрольная сумма
     double sumA = 0.0, sumB = 0.0;
@@ -84,10 +1189,36 @@ int main(int argc, char* argv[]) {
     std::cout << "RESULT_SECONDS=" << elapsed.count() << std::endl;
 
     std::cout << "DIAG_THREADS=openblas/libopenblas:" << num_threads << std::endl;
+    std::cout << "DIAG_THREADING=" << openblas_variant() << "," << oversubscription.summary() << std::endl;
+    std::cout << "DIAG_OVERSUBSCRIPTION=" << oversubscription.problems() << std::endl;
+    std::cout << "DIAG_INDEX=" << (sizeof(blasint) == 8 ? "ilp64" : "lp64") << std::endl;
     std::cout << "DIAG_PEAK_RSS_KB=" << rss_kb << std::endl;
     std::cout << "DIAG_ROUTINES=" << routines_oss.str() << std::endl;
+    if (matrixA.format != "synthetic")
+        matrixA.report();
+    if (matrixB.format != "synthetic")
+        matrixB.report();
+
+    std::cout << std::setprecision(3);
+    std::cout << "DIAG_GEMM=m:" << shape.m << ",n:" << shape.n << ",k:" << shape.k << ",op:" << shape.ops()
+              << ",alpha:" << shape.alpha << ",beta:" << shape.beta
+              << ",ld:" << shape.ld_a() << "/" << shape.ld_b() << "/" << shape.ld_c() << std::endl;
+    std::cout << "DIAG_GFLOPS=" << shape.flops() / elapsed.count() / 1e9 << std::endl;
+    std::cout << std::scientific << std::setprecision(6) << "DIAG_RESIDUAL=" << residual << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    // Одна строка на форму развёртки: m:n:k:op:секунды:GFLOP/s
+    for (const auto& [g, seconds] : sweep)
+        std::cout << "DIAG_SHAPE=" << g.m << ":" << g.n << ":" << g.k << ":" << g.ops() << ":"
+                  << std::setprecision(6) << seconds << ":" << std::setprecision(3) << g.flops() / seconds / 1e9 << std::endl;
+    // Формы сверх --sweep-mb: m:n:k:op:МБ операндов
+    for (const GemmShape& g : sweep_skipped)
+        std::cout << "DIAG_SHAPE_SKIPPED=" << g.m << ":" << g.n << ":" << g.k << ":" << g.ops() << ":"
+                  << std::setprecision(0) << g.bytes() / (1024.0 * 1024.0) << std::setprecision(3) << std::endl;
 
     std::cout << std::setprecision(6);
+    // Номинальное число операций умножения матриц (dgemm)
+    rapl.report(shape.flops() / 1e9);
+    memory.report();
     std::cout << "DIAG_CHECKSUM=" << sumA << "," << sumB << std::endl;
 
     return 0;
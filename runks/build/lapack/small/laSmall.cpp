@@ -0,0 +1,250 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cblas.h>
+#include <lapacke.h>
+#include <sys/resource.h>
+#include <string>
+#include <sstream>
+#include <map>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+#include "spd_kernels.hpp"
+// Пакет маленьких SPD-матриц (n <= 32): шаблонные ядра spd_kernels.hpp против
+// dpotrf + dpotri для каждой матрицы
+std::vector<std::string> called_routines;
+
+void fill_positive_definite_matrix(double* matrix, int n, int seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<> dis(0.0, 1.0);
+
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < n; ++j)
+            matrix[(size_t)i * n + j] = dis(gen);
+
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < i; ++j) {
+            double avg = (matrix[(size_t)i * n + j] + matrix[(size_t)j * n + i]) / 2.0;
+            matrix[(size_t)i * n + j] = matrix[(size_t)j * n + i] = avg;
+        }
+    }
+    for (int i = 0; i < n; ++i)
+        matrix[(size_t)i * n + i] += n;
+}
+
+// Необязательные параметры вида --key=value
+std::map<std::string, std::string> parse_options(int argc, char* argv[], int first) {
+    std::map<std::string, std::string> options;
+    for (int i = first; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+            throw std::invalid_argument("Unknown argument: " + arg);
+        options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+    }
+    return options;
+}
+
+std::string option(const std::map<std::string, std::string>& options,
+                   const std::string& key, const std::string& fallback) {
+    auto it = options.find(key);
+    return it == options.end() ? fallback : it->second;
+}
+
+// Невязка ||A (X v) - v|| / (||A||_F ||X||_F ||v||) на случайном векторе v
+double probe_residual(const double* A, const double* X, int n) {
+    std::mt19937 gen(n + 2);
+    std::uniform_real_distribution<> dis(-1.0, 1.0);
+    std::vector<double> v(n), Xv(n), r(n);
+    for (double& x : v)
+        x = dis(gen);
+
+    cblas_dgemv(CblasRowMajor, CblasNoTrans, n, n, 1.0, X, n, v.data(), 1, 0.0, Xv.data(), 1);
+    r = v;
+    cblas_dgemv(CblasRowMajor, CblasNoTrans, n, n, 1.0, A, n, Xv.data(), 1, -1.0, r.data(), 1);
+
+    double norm_A = cblas_dnrm2((size_t)n * n, A, 1);
+    double norm_X = cblas_dnrm2((size_t)n * n, X, 1);
+    return cblas_dnrm2(n, r.data(), 1) / (norm_A * norm_X * cblas_dnrm2(n, v.data(), 1));
+}
+
+// Путь LAPACK: dpotrf + dpotri и отражение нижнего треугольника для каждой матрицы
+int invert_lapack(int n, const double* matrices, double* inverses, int count) {
+    int failed = 0;
+    for (int m = 0; m < count; ++m) {
+        const double* A = matrices + (size_t)m * n * n;
+        double* X = inverses + (size_t)m * n * n;
+        std::copy(A, A + (size_t)n * n, X);
+        int info = LAPACKE_dpotrf(LAPACK_ROW_MAJOR, 'L', n, X, n);
+        if (info == 0)
+            info = LAPACKE_dpotri(LAPACK_ROW_MAJOR, 'L', n, X, n);
+        if (info != 0) {
+            ++failed;
+            continue;
+        }
+        for (int i = 0; i < n; ++i)
+            for (int j = i + 1; j < n; ++j)
+                X[(size_t)i * n + j] = X[(size_t)j * n + i];
+    }
+    return failed;
+}
+
+// Лучшее из repeats времён: пакет маленьких матриц проходит за миллисекунды
+template<class F>
+double best_time(int repeats, F&& run) {
+    double best = 0.0;
+    for (int r = 0; r < repeats; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        auto end = std::chrono::steady_clock::now();
+        double t = std::chrono::duration<double>(end - start).count();
+        best = (r == 0) ? t : std::min(best, t);
+    }
+    return best;
+}
+
+double max_relative_diff(const std::vector<double>& x, const std::vector<double>& ref) {
+    double diff = 0.0, scale = 0.0;
+    for (size_t i = 0; i < x.size(); ++i) {
+        diff = std::max(diff, std::fabs(x[i] - ref[i]));
+        scale = std::max(scale, std::fabs(ref[i]));
+    }
+    return diff / scale;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <matrix_size> [--batch=16384] [--repeats=5]" << std::endl;
+        return 1;
+    }
+
+    int n = std::stoi(argv[1]);
+    if (n <= 0) {
+        std::cerr << "Matrix size must be positive" << std::endl;
+        return 1;
+    }
+
+    std::map<std::string, std::string> options;
+    try {
+        options = parse_options(argc, argv, 2);
+    } catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    int batch = std::max(1, std::stoi(option(options, "batch", "16384")));
+    int repeats = std::max(1, std::stoi(option(options, "repeats", "5")));
+    bool kernel = spd::supported(n);
+
+    // Получаем фактическое число потоков
+    int num_threads = openblas_get_num_threads();
+
+    // Матрица m пакета строится тем же генератором с зерном n + m
+    size_t elements = (size_t)batch * n * n;
+    std::vector<double> matrices(elements), lapack_inv(elements), kernel_inv(elements), each_inv(elements);
+    for (int m = 0; m < batch; ++m)
+        fill_positive_definite_matrix(matrices.data() + (size_t)m * n * n, n, n + m);
+
+    int blocks = (batch + spd::batch_width - 1) / spd::batch_width;
+    std::vector<double> packed((size_t)blocks * spd::batch_width * n * n);
+    std::vector<double> packed_inv(packed.size());
+
+    called_routines.push_back("dpotrf");
+    called_routines.push_back("dpotri");
+    int failed = 0;
+    double lapack_seconds = best_time(repeats, [&] {
+        failed = invert_lapack(n, matrices.data(), lapack_inv.data(), batch);
+    });
+
+    double kernel_seconds = lapack_seconds, each_seconds = 0.0, pack_seconds = 0.0, kernel_only_seconds = 0.0;
+    double max_diff = 0.0;
+    if (kernel) {
+        called_routines.push_back("invert_spd_batch<" + std::to_string(n) + ">");
+
+        // Упаковка и распаковка входят во время: на входе и выходе обычный формат.
+        // Блоки упаковываются по одному в буфер в кэше, сразу перед ядром
+        kernel_seconds = best_time(repeats, [&] {
+            failed += spd::invert_packed(n, matrices.data(), kernel_inv.data(), batch);
+        });
+        // Для разбора: только ядро на заранее упакованных данных и только
+        // упаковка с распаковкой всего пакета через память
+        spd::pack(n, matrices.data(), batch, packed.data());
+        kernel_only_seconds = best_time(repeats, [&] {
+            failed += spd::invert_batch(n, packed.data(), packed_inv.data(), blocks);
+        });
+        pack_seconds = best_time(repeats, [&] {
+            spd::pack(n, matrices.data(), batch, packed.data());
+            spd::unpack(n, packed_inv.data(), batch, each_inv.data());
+        });
+
+        // Развёрнутое ядро по одной матрице в строчном формате, без упаковки
+        each_seconds = best_time(repeats, [&] {
+            failed += spd::invert_each(n, matrices.data(), each_inv.data(), batch);
+        });
+
+        max_diff = std::max(max_relative_diff(kernel_inv, lapack_inv), max_relative_diff(each_inv, lapack_inv));
+    }
+
+    if (failed != 0) {
+        std::cerr << "Inversion failed for " << failed << " matrices" << std::endl;
+        return 1;
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    long rss_kb = usage.ru_maxrss;
+
+    // Основной путь – более быстрый из пакетного и развёрнутого ядра
+    bool use_each = kernel && each_seconds < kernel_seconds;
+    double best_seconds = !kernel ? lapack_seconds : use_each ? each_seconds : kernel_seconds;
+    const std::vector<double>& result = !kernel ? lapack_inv : use_each ? each_inv : kernel_inv;
+    double max_residual = 0.0;
+    for (int m = 0; m < std::min(batch, 64); ++m)
+        max_residual = std::max(max_residual,
+                                probe_residual(matrices.data() + (size_t)m * n * n, result.data() + (size_t)m * n * n, n));
+
+    double checksum = 0.0;
+    for (double v : matrices)
+        checksum += v;
+
+    std::ostringstream routines_oss;
+    for (size_t i = 0; i < called_routines.size(); ++i) {
+        if (i) routines_oss << ',';
+        routines_oss << called_routines[i];
+    }
+
+    std::cout << std::fixed << std::setprecision(9);
+    // Время на пакет выбранным путём: более быстрое ядро, если размер поддержан, иначе LAPACK
+    std::cout << "RESULT_SECONDS=" << best_seconds << std::endl;
+    std::cout << "DIAG_THREADS=openblas/libopenblas:" << num_threads << std::endl;
+    std::cout << "DIAG_PEAK_RSS_KB=" << rss_kb << std::endl;
+    std::cout << "DIAG_ROUTINES=" << routines_oss.str() << std::endl;
+    if (kernel)
+        std::cout << "DIAG_KERNEL=" << SPD_ISA << ":" << spd::batch_width << ":" << (use_each ? "unrolled" : "batch") << std::endl;
+    else
+        std::cout << "DIAG_KERNEL=fallback:lapack" << std::endl;
+    std::cout << "DIAG_MATRICES=" << batch << std::endl;
+    std::cout << std::setprecision(1);
+    std::cout << "DIAG_MATRICES_PER_SEC=";
+    if (kernel)
+        std::cout << "batch:" << batch / kernel_seconds << ",unrolled:" << batch / each_seconds << ",";
+    std::cout << "lapack:" << batch / lapack_seconds << std::endl;
+    std::cout << std::setprecision(6);
+    if (kernel) {
+        std::cout << "DIAG_SPEEDUP=" << lapack_seconds / best_seconds << std::endl;
+        std::cout << std::setprecision(9);
+        std::cout << "DIAG_KERNEL_SECONDS=" << kernel_only_seconds << std::endl;
+        std::cout << "DIAG_PACK_SECONDS=" << pack_seconds << std::endl;
+        std::cout << std::scientific << std::setprecision(6);
+        std::cout << "DIAG_MAX_DIFF=" << max_diff << std::endl;
+    }
+    std::cout << std::scientific << std::setprecision(6);
+    std::cout << "DIAG_RESIDUAL=" << max_residual << std::endl;
+    std::cout << std::fixed;
+    std::cout << "DIAG_CHECKSUM=" << checksum << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,763 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <map>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <limits>
+#include <cmath>
+#include <cstdlib>
+#include <cblas.h>
+#include <lapacke.h>
+#include <sys/resource.h>
+
+// Ленточные и разреженные SPD-системы: dpbtrf/dpbtrs и суперузловой
+// мультифронтальный Холецкий с упорядочением вложенными сечениями
+std::vector<std::string> called_routines;
+
+// Ленточная SPD-матрица в ленточном формате LAPACK: нижний треугольник,
+// хранение по столбцам, ab[(i - j) + j * (kd + 1)] = A(i, j)
+struct BandMatrix {
+    int n;
+    int kd;
+    std::vector<double> ab;
+};
+
+// Симметричная разреженная матрица в формате CSR, хранятся оба треугольника
+struct CsrMatrix {
+    int n;
+    std::vector<int> row_ptr;
+    std::vector<int> col;
+    std::vector<double> val;
+};
+
+// Случайная лента ширины kd, к диагонали добавляется число элементов строки ленты
+BandMatrix create_banded_spd_matrix(int n, int kd, int seed) {
+    BandMatrix A{n, kd, std::vector<double>((size_t)(kd + 1) * n, 0.0)};
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<> dis(0.0, 1.0);
+
+    for (int j = 0; j < n; ++j)
+        for (int i = j; i <= std::min(n - 1, j + kd); ++i)
+            A.ab[(i - j) + (size_t)j * (kd + 1)] = dis(gen);
+
+    for (int j = 0; j < n; ++j)
+        A.ab[(size_t)j * (kd + 1)] += 2 * kd + 1;
+
+    return A;
+}
+
+// Лапласиан случайного геометрического графа плюс единичная диагональ.
+// Вершины – случайные точки единичного квадрата, рёбра соединяют точки на
+// расстоянии меньше r, где r подобран под среднюю степень degree. Нумерация
+// вершин случайная, так что без упорядочения заполнение почти полное.
+CsrMatrix create_sparse_spd_matrix(int n, int degree, int seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<> dis(0.0, 1.0);
+
+    std::vector<double> x(n), y(n);
+    for (int i = 0; i < n; ++i) {
+        x[i] = dis(gen);
+        y[i] = dis(gen);
+    }
+
+    double radius = std::sqrt(degree / (M_PI * n));
+    int cells = std::max(1, int(1.0 / radius));
+    std::vector<std::vector<int>> grid(cells * cells);
+    auto cell_of = [cells](double c) { return std::min(cells - 1, int(c * cells)); };
+    for (int i = 0; i < n; ++i)
+        grid[cell_of(y[i]) * cells + cell_of(x[i])].push_back(i);
+
+    std::vector<std::vector<std::pair<int, double>>> adjacency(n);
+    for (int i = 0; i < n; ++i) {
+        int cx = cell_of(x[i]), cy = cell_of(y[i]);
+        for (int gy = std::max(0, cy - 1); gy <= std::min(cells - 1, cy + 1); ++gy)
+            for (int gx = std::max(0, cx - 1); gx <= std::min(cells - 1, cx + 1); ++gx)
+                for (int j : grid[gy * cells + gx]) {
+                    if (j <= i)
+                        continue;
+                    double dx = x[i] - x[j], dy = y[i] - y[j];
+                    if (dx * dx + dy * dy < radius * radius) {
+                        double w = dis(gen);
+                        adjacency[i].push_back({j, -w});
+                        adjacency[j].push_back({i, -w});
+                    }
+                }
+    }
+
+    CsrMatrix A{n, std::vector<int>(n + 1, 0), {}, {}};
+    for (int i = 0; i < n; ++i) {
+        double diagonal = 1.0;
+        for (const auto& entry : adjacency[i])
+            diagonal -= entry.second;
+        adjacency[i].push_back({i, diagonal});
+        std::sort(adjacency[i].begin(), adjacency[i].end());
+
+        for (const auto& entry : adjacency[i]) {
+            A.col.push_back(entry.first);
+            A.val.push_back(entry.second);
+        }
+        A.row_ptr[i + 1] = int(A.col.size());
+    }
+    return A;
+}
+
+void band_multiply(const BandMatrix& A, const double* x, double* y) {
+    int ld = A.kd + 1;
+    std::fill(y, y + A.n, 0.0);
+    for (int j = 0; j < A.n; ++j) {
+        y[j] += A.ab[(size_t)j * ld] * x[j];
+        for (int i = j + 1; i <= std::min(A.n - 1, j + A.kd); ++i) {
+            double a = A.ab[(i - j) + (size_t)j * ld];
+            y[i] += a * x[j];
+            y[j] += a * x[i];
+        }
+    }
+}
+
+void csr_multiply(const CsrMatrix& A, const double* x, double* y) {
+    for (int i = 0; i < A.n; ++i) {
+        double sum = 0.0;
+        for (int k = A.row_ptr[i]; k < A.row_ptr[i + 1]; ++k)
+            sum += A.val[k] * x[A.col[k]];
+        y[i] = sum;
+    }
+}
+
+// Плотная копия (по столбцам, нижний треугольник) для сравнения с dpotrf
+std::vector<double> band_to_dense(const BandMatrix& A) {
+    std::vector<double> dense((size_t)A.n * A.n, 0.0);
+    for (int j = 0; j < A.n; ++j)
+        for (int i = j; i <= std::min(A.n - 1, j + A.kd); ++i)
+            dense[i + (size_t)j * A.n] = A.ab[(i - j) + (size_t)j * (A.kd + 1)];
+    return dense;
+}
+
+std::vector<double> csr_to_dense(const CsrMatrix& A) {
+    std::vector<double> dense((size_t)A.n * A.n, 0.0);
+    for (int i = 0; i < A.n; ++i)
+        for (int k = A.row_ptr[i]; k < A.row_ptr[i + 1]; ++k)
+            if (A.col[k] >= i)
+                dense[A.col[k] + (size_t)i * A.n] = A.val[k];
+    return dense;
+}
+
+// Упорядочение вложенными сечениями. Разделитель – средний уровень поиска в
+// ширину от псевдопериферийной вершины; обе части упорядочиваются рекурсивно,
+// вершины разделителя получают последние номера.
+class NestedDissection {
+public:
+    NestedDissection(const CsrMatrix& A, int leaf_size)
+        : A_(A), leaf_size_(leaf_size), label_(A.n, 0), stamp_(A.n, 0) {}
+
+    std::vector<int> order() {
+        std::vector<int> all(A_.n);
+        for (int i = 0; i < A_.n; ++i)
+            all[i] = i;
+        order_.clear();
+        dissect(all);
+        return order_;
+    }
+
+private:
+    const CsrMatrix& A_;
+    int leaf_size_;
+    std::vector<int> label_;
+    std::vector<int> stamp_;
+    int current_label_ = 0;
+    int current_stamp_ = 0;
+    std::vector<int> order_;
+
+    // Уровни поиска в ширину внутри подграфа с меткой label
+    std::vector<std::vector<int>> bfs_levels(int start, int label) {
+        ++current_stamp_;
+        std::vector<std::vector<int>> levels{{start}};
+        stamp_[start] = current_stamp_;
+        while (true) {
+            std::vector<int> next;
+            for (int v : levels.back())
+                for (int k = A_.row_ptr[v]; k < A_.row_ptr[v + 1]; ++k) {
+                    int u = A_.col[k];
+                    if (label_[u] == label && stamp_[u] != current_stamp_) {
+                        stamp_[u] = current_stamp_;
+                        next.push_back(u);
+                    }
+                }
+            if (next.empty())
+                return levels;
+            levels.push_back(std::move(next));
+        }
+    }
+
+    void dissect(const std::vector<int>& vertices) {
+        if (int(vertices.size()) <= leaf_size_) {
+            order_.insert(order_.end(), vertices.begin(), vertices.end());
+            return;
+        }
+
+        int label = ++current_label_;
+        for (int v : vertices)
+            label_[v] = label;
+
+        // Две итерации поиска псевдопериферийной вершины
+        std::vector<std::vector<int>> levels = bfs_levels(vertices.front(), label);
+        for (int pass = 0; pass < 2; ++pass) {
+            std::vector<std::vector<int>> candidate = bfs_levels(levels.back().front(), label);
+            if (candidate.size() <= levels.size())
+                break;
+            levels = std::move(candidate);
+        }
+
+        size_t reached = 0;
+        for (const auto& level : levels)
+            reached += level.size();
+
+        // Несвязный подграф: компоненты упорядочиваются независимо
+        if (reached < vertices.size()) {
+            std::vector<int> component, rest;
+            for (int v : vertices)
+                (stamp_[v] == current_stamp_ ? component : rest).push_back(v);
+            dissect(component);
+            dissect(rest);
+            return;
+        }
+
+        if (levels.size() < 3) {
+            order_.insert(order_.end(), vertices.begin(), vertices.end());
+            return;
+        }
+
+        size_t middle = 1, count = levels[0].size();
+        while (middle + 2 < levels.size() && count + levels[middle].size() < vertices.size() / 2)
+            count += levels[middle++].size();
+
+        std::vector<int> first, second;
+        for (size_t l = 0; l < levels.size(); ++l) {
+            if (l < middle)
+                first.insert(first.end(), levels[l].begin(), levels[l].end());
+            else if (l > middle)
+                second.insert(second.end(), levels[l].begin(), levels[l].end());
+        }
+        std::vector<int> separator = levels[middle];
+
+        dissect(first);
+        dissect(second);
+        order_.insert(order_.end(), separator.begin(), separator.end());
+    }
+};
+
+// Суперузловой множитель L перестановленной матрицы P A P^T
+struct SupernodalFactor {
+    int n = 0;
+    std::vector<int> perm;              // perm[k] – исходный номер k-го столбца
+    std::vector<int> super_start;       // первый столбец каждого суперузла (+ n в конце)
+    std::vector<int> super_parent;      // родитель в дереве суперузлов, -1 у корней
+    std::vector<int> row_ptr;           // начало списка строк суперузла в rows
+    std::vector<int> rows;              // строки суперузла, начиная с его столбцов
+    std::vector<size_t> value_ptr;      // начало панели m x ns (по столбцам) в values
+    std::vector<double> values;
+    size_t factor_nnz = 0;              // ненулевые элементы нижнего треугольника L
+    size_t peak_work_bytes = 0;         // пик фронтальных матриц и матриц обновления
+};
+
+// Упорядочение, дерево исключения, постпорядок, счётчики столбцов и
+// фундаментальные суперузлы
+SupernodalFactor analyze(const CsrMatrix& A, int leaf_size) {
+    int n = A.n;
+    SupernodalFactor F;
+    F.n = n;
+    std::vector<int> perm = NestedDissection(A, leaf_size).order();
+
+    auto inverse_of = [n](const std::vector<int>& p) {
+        std::vector<int> inv(n);
+        for (int k = 0; k < n; ++k)
+            inv[p[k]] = k;
+        return inv;
+    };
+
+    // Дерево исключения (алгоритм Лю со сжатием путей)
+    auto etree = [&A, n](const std::vector<int>& p, const std::vector<int>& ip) {
+        std::vector<int> parent(n, -1), ancestor(n, -1);
+        for (int k = 0; k < n; ++k) {
+            int v = p[k];
+            for (int e = A.row_ptr[v]; e < A.row_ptr[v + 1]; ++e) {
+                int i = ip[A.col[e]];
+                while (i != -1 && i < k) {
+                    int next = ancestor[i];
+                    ancestor[i] = k;
+                    if (next == -1)
+                        parent[i] = k;
+                    i = next;
+                }
+            }
+        }
+        return parent;
+    };
+
+    std::vector<int> iperm = inverse_of(perm);
+    std::vector<int> parent = etree(perm, iperm);
+
+    // Постпорядок не меняет заполнения, но делает цепочки суперузлов смежными
+    std::vector<int> head(n, -1), next(n, -1), post;
+    post.reserve(n);
+    for (int j = n - 1; j >= 0; --j)
+        if (parent[j] != -1) {
+            next[j] = head[parent[j]];
+            head[parent[j]] = j;
+        }
+    std::vector<int> stack;
+    for (int root = 0; root < n; ++root) {
+        if (parent[root] != -1)
+            continue;
+        stack.push_back(root);
+        while (!stack.empty()) {
+            int v = stack.back();
+            if (head[v] != -1) {
+                int child = head[v];
+                head[v] = next[child];
+                stack.push_back(child);
+            } else {
+                post.push_back(v);
+                stack.pop_back();
+            }
+        }
+    }
+    for (int k = 0; k < n; ++k)
+        post[k] = perm[post[k]];
+    F.perm = post;
+    iperm = inverse_of(F.perm);
+    parent = etree(F.perm, iperm);
+
+    // Число ненулевых в столбцах L через поддеревья строк
+    std::vector<int> colcount(n, 1), mark(n, -1), children(n, 0);
+    for (int j = 0; j < n; ++j)
+        if (parent[j] != -1)
+            ++children[parent[j]];
+    for (int i = 0; i < n; ++i) {
+        mark[i] = i;
+        int v = F.perm[i];
+        for (int e = A.row_ptr[v]; e < A.row_ptr[v + 1]; ++e) {
+            int k = iperm[A.col[e]];
+            while (k != -1 && k < i && mark[k] != i) {
+                ++colcount[k];
+                mark[k] = i;
+                k = parent[k];
+            }
+        }
+    }
+
+    // Фундаментальные суперузлы: цепочка j-1 -> j с вложенной структурой
+    std::vector<int> super_of(n);
+    for (int j = 0; j < n; ++j) {
+        bool extend = j > 0 && parent[j - 1] == j && children[j] == 1 &&
+                      colcount[j - 1] == colcount[j] + 1;
+        if (!extend)
+            F.super_start.push_back(j);
+        super_of[j] = int(F.super_start.size()) - 1;
+    }
+    int supernodes = int(F.super_start.size());
+    F.super_start.push_back(n);
+
+    F.super_parent.assign(supernodes, -1);
+    for (int s = 0; s < supernodes; ++s) {
+        int last = F.super_start[s + 1] - 1;
+        if (parent[last] != -1)
+            F.super_parent[s] = super_of[parent[last]];
+    }
+
+    // Структура строк суперузла: его столбцы, строки A и строки детей ниже него
+    std::vector<std::vector<int>> child_list(supernodes);
+    for (int s = 0; s < supernodes; ++s)
+        if (F.super_parent[s] != -1)
+            child_list[F.super_parent[s]].push_back(s);
+
+    F.row_ptr.assign(1, 0);
+    F.value_ptr.assign(1, 0);
+    std::fill(mark.begin(), mark.end(), -1);
+    for (int s = 0; s < supernodes; ++s) {
+        int first = F.super_start[s], end = F.super_start[s + 1];
+        std::vector<int> structure;
+        for (int j = first; j < end; ++j) {
+            structure.push_back(j);
+            mark[j] = s;
+        }
+        for (int j = first; j < end; ++j) {
+            int v = F.perm[j];
+            for (int e = A.row_ptr[v]; e < A.row_ptr[v + 1]; ++e) {
+                int i = iperm[A.col[e]];
+                if (i >= end && mark[i] != s) {
+                    mark[i] = s;
+                    structure.push_back(i);
+                }
+            }
+        }
+        for (int c : child_list[s]) {
+            int width = F.super_start[c + 1] - F.super_start[c];
+            for (int r = F.row_ptr[c] + width; r < F.row_ptr[c + 1]; ++r) {
+                int i = F.rows[r];
+                if (i >= end && mark[i] != s) {
+                    mark[i] = s;
+                    structure.push_back(i);
+                }
+            }
+        }
+        std::sort(structure.begin() + (end - first), structure.end());
+
+        size_t m = structure.size(), width = end - first;
+        F.rows.insert(F.rows.end(), structure.begin(), structure.end());
+        F.row_ptr.push_back(int(F.rows.size()));
+        F.value_ptr.push_back(F.value_ptr.back() + m * width);
+        F.factor_nnz += m * width - width * (width - 1) / 2;
+    }
+    return F;
+}
+
+// Мультифронтальная численная факторизация: для каждого суперузла собирается
+// плотная фронтальная матрица, dpotrf/dtrsm дают панель L, а dsyrk – матрицу
+// обновления, которая прибавляется к фронту родителя
+int factorize(const CsrMatrix& A, SupernodalFactor& F) {
+    called_routines.push_back("dpotrf");
+    called_routines.push_back("dtrsm");
+    called_routines.push_back("dsyrk");
+
+    int n = F.n;
+    int supernodes = int(F.super_start.size()) - 1;
+    std::vector<int> iperm(n), position(n);
+    for (int k = 0; k < n; ++k)
+        iperm[F.perm[k]] = k;
+
+    F.values.assign(F.value_ptr.back(), 0.0);
+    std::vector<std::vector<double>> updates(supernodes);
+    std::vector<std::vector<int>> child_list(supernodes);
+    for (int s = 0; s < supernodes; ++s)
+        if (F.super_parent[s] != -1)
+            child_list[F.super_parent[s]].push_back(s);
+
+    size_t live_bytes = 0;
+    for (int s = 0; s < supernodes; ++s) {
+        int first = F.super_start[s];
+        int width = F.super_start[s + 1] - first;
+        int m = F.row_ptr[s + 1] - F.row_ptr[s];
+        const int* rows = F.rows.data() + F.row_ptr[s];
+        for (int r = 0; r < m; ++r)
+            position[rows[r]] = r;
+
+        std::vector<double> front(size_t(m) * m, 0.0);
+        live_bytes += front.size() * sizeof(double);
+        F.peak_work_bytes = std::max(F.peak_work_bytes, live_bytes);
+
+        for (int j = 0; j < width; ++j) {
+            int v = F.perm[first + j];
+            for (int e = A.row_ptr[v]; e < A.row_ptr[v + 1]; ++e) {
+                int i = iperm[A.col[e]];
+                if (i >= first + j)
+                    front[position[i] + size_t(j) * m] += A.val[e];
+            }
+        }
+
+        for (int c : child_list[s]) {
+            int child_width = F.super_start[c + 1] - F.super_start[c];
+            const int* child_rows = F.rows.data() + F.row_ptr[c] + child_width;
+            int mc = F.row_ptr[c + 1] - F.row_ptr[c] - child_width;
+            const std::vector<double>& U = updates[c];
+            for (int b = 0; b < mc; ++b) {
+                size_t column = size_t(position[child_rows[b]]) * m;
+                for (int a = b; a < mc; ++a)
+                    front[position[child_rows[a]] + column] += U[a + size_t(b) * mc];
+            }
+            live_bytes -= U.size() * sizeof(double);
+            std::vector<double>().swap(updates[c]);
+        }
+
+        int info = LAPACKE_dpotrf(LAPACK_COL_MAJOR, 'L', width, front.data(), m);
+        if (info != 0)
+            return first + info;
+
+        int below = m - width;
+        if (below > 0) {
+            cblas_dtrsm(CblasColMajor, CblasRight, CblasLower, CblasTrans, CblasNonUnit,
+                        below, width,
+                        1.0, front.data(), m,
+                        front.data() + width, m);
+            cblas_dsyrk(CblasColMajor, CblasLower, CblasNoTrans,
+                        below, width,
+                        -1.0, front.data() + width, m,
+                        1.0, front.data() + width + size_t(width) * m, m);
+
+            std::vector<double>& U = updates[s];
+            U.resize(size_t(below) * below);
+            for (int b = 0; b < below; ++b)
+                std::copy(front.begin() + width + size_t(width + b) * m,
+                          front.begin() + width + size_t(width + b) * m + below,
+                          U.begin() + size_t(b) * below);
+            live_bytes += U.size() * sizeof(double);
+            F.peak_work_bytes = std::max(F.peak_work_bytes, live_bytes);
+        }
+
+        std::copy(front.begin(), front.begin() + size_t(m) * width, F.values.begin() + F.value_ptr[s]);
+        live_bytes -= front.size() * sizeof(double);
+    }
+    return 0;
+}
+
+// Прямой и обратный ход по панелям суперузлов
+void solve(const SupernodalFactor& F, const double* b, double* x) {
+    called_routines.push_back("dtrsv");
+    called_routines.push_back("dgemv");
+
+    int n = F.n;
+    int supernodes = int(F.super_start.size()) - 1;
+    std::vector<double> y(n), tmp;
+    for (int k = 0; k < n; ++k)
+        y[k] = b[F.perm[k]];
+
+    for (int s = 0; s < supernodes; ++s) {
+        int first = F.super_start[s];
+        int width = F.super_start[s + 1] - first;
+        int m = F.row_ptr[s + 1] - F.row_ptr[s];
+        const int* rows = F.rows.data() + F.row_ptr[s];
+        const double* L = F.values.data() + F.value_ptr[s];
+
+        cblas_dtrsv(CblasColMajor, CblasLower, CblasNoTrans, CblasNonUnit, width, L, m, y.data() + first, 1);
+        int below = m - width;
+        if (below > 0) {
+            tmp.assign(below, 0.0);
+            cblas_dgemv(CblasColMajor, CblasNoTrans, below, width, 1.0, L + width, m,
+                        y.data() + first, 1, 0.0, tmp.data(), 1);
+            for (int r = 0; r < below; ++r)
+                y[rows[width + r]] -= tmp[r];
+        }
+    }
+
+    for (int s = supernodes - 1; s >= 0; --s) {
+        int first = F.super_start[s];
+        int width = F.super_start[s + 1] - first;
+        int m = F.row_ptr[s + 1] - F.row_ptr[s];
+        const int* rows = F.rows.data() + F.row_ptr[s];
+        const double* L = F.values.data() + F.value_ptr[s];
+
+        int below = m - width;
+        if (below > 0) {
+            tmp.resize(below);
+            for (int r = 0; r < below; ++r)
+                tmp[r] = y[rows[width + r]];
+            cblas_dgemv(CblasColMajor, CblasTrans, below, width, -1.0, L + width, m,
+                        tmp.data(), 1, 1.0, y.data() + first, 1);
+        }
+        cblas_dtrsv(CblasColMajor, CblasLower, CblasTrans, CblasNonUnit, width, L, m, y.data() + first, 1);
+    }
+
+    for (int k = 0; k < n; ++k)
+        x[F.perm[k]] = y[k];
+}
+
+// Тот же размер n через плотные dpotrf/dpotrs; возвращает время или -1 при ошибке
+double dense_solve(std::vector<double> dense, int n, const std::vector<double>& b, std::vector<double>& x) {
+    x = b;
+    auto start = std::chrono::steady_clock::now();
+    int info = LAPACKE_dpotrf(LAPACK_COL_MAJOR, 'L', n, dense.data(), n);
+    if (info == 0)
+        info = LAPACKE_dpotrs(LAPACK_COL_MAJOR, 'L', n, 1, dense.data(), n, x.data(), n);
+    auto end = std::chrono::steady_clock::now();
+    if (info != 0)
+        return -1.0;
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// Необязательные параметры вида --key=value
+std::map<std::string, std::string> parse_options(int argc, char* argv[], int first) {
+    std::map<std::string, std::string> options;
+    for (int i = first; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+            throw std::invalid_argument("Unknown argument: " + arg);
+        options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+    }
+    return options;
+}
+
+std::string option(const std::map<std::string, std::string>& options,
+                   const std::string& key, const std::string& fallback) {
+    auto it = options.find(key);
+    return it == options.end() ? fallback : it->second;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <matrix_size> [--format=sparse|banded] [--degree=8]"
+                  << " [--bandwidth=16] [--leaf=64] [--dense=1|0] [--dense-max-mb=4096]" << std::endl;
+        return 1;
+    }
+
+    int n = std::atoi(argv[1]);
+    if (n <= 0) {
+        std::cerr << "Matrix size must be positive" << std::endl;
+        return 1;
+    }
+
+    std::map<std::string, std::string> options;
+    try {
+        options = parse_options(argc, argv, 2);
+    } catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::string format = option(options, "format", "sparse");
+    if (format != "sparse" && format != "banded") {
+        std::cerr << "Unknown --format: " << format << std::endl;
+        return 1;
+    }
+    int degree = std::atoi(option(options, "degree", "8").c_str());
+    int kd = std::min(n - 1, std::atoi(option(options, "bandwidth", "16").c_str()));
+    int leaf = std::max(1, std::atoi(option(options, "leaf", "64").c_str()));
+    bool compare_dense = option(options, "dense", "1") != "0";
+    // Плотная копия занимает n^2 double: сверх --dense-max-mb (и сверх 32-битных
+    // индексов LAPACK) сравнение пропускается с отметкой DIAG_DENSE=skipped
+    double dense_mb = double(n) * n * sizeof(double) / (1024.0 * 1024.0);
+    bool dense_skipped = compare_dense &&
+        (dense_mb > std::stod(option(options, "dense-max-mb", "4096")) ||
+         (sizeof(lapack_int) < 8 && (long long)n * n > std::numeric_limits<lapack_int>::max()));
+    if (dense_skipped)
+        compare_dense = false;
+
+    int num_threads = openblas_get_num_threads();
+
+    BandMatrix band;
+    CsrMatrix sparse;
+    size_t matrix_nnz;   // нижний треугольник с диагональю
+    if (format == "banded") {
+        band = create_banded_spd_matrix(n, kd, n);
+        matrix_nnz = size_t(kd + 1) * n - size_t(kd) * (kd + 1) / 2;
+    } else {
+        sparse = create_sparse_spd_matrix(n, degree, n);
+        matrix_nnz = (sparse.col.size() + n) / 2;
+    }
+
+    // Правая часть b = A * 1, точное решение – вектор из единиц
+    std::vector<double> ones(n, 1.0), b(n), x(n), Ax(n);
+    if (format == "banded")
+        band_multiply(band, ones.data(), b.data());
+    else
+        csr_multiply(sparse, ones.data(), b.data());
+
+    size_t factor_nnz;
+    size_t factor_bytes;
+    size_t work_bytes = 0;
+    double analyze_seconds = 0.0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    if (format == "banded") {
+        std::vector<double> factor = band.ab;
+        called_routines.push_back("dpbtrf");
+        int info = LAPACKE_dpbtrf(LAPACK_COL_MAJOR, 'L', n, kd, factor.data(), kd + 1);
+        if (info != 0) {
+            std::cerr << "Banded Cholesky factorization failed with code: " << info << std::endl;
+            return 1;
+        }
+
+        x = b;
+        called_routines.push_back("dpbtrs");
+        info = LAPACKE_dpbtrs(LAPACK_COL_MAJOR, 'L', n, kd, 1, factor.data(), kd + 1, x.data(), n);
+        if (info != 0) {
+            std::cerr << "Banded Cholesky solve failed with code: " << info << std::endl;
+            return 1;
+        }
+        factor_nnz = matrix_nnz;
+        factor_bytes = factor.size() * sizeof(double);
+    } else {
+        SupernodalFactor F = analyze(sparse, leaf);
+        analyze_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        int info = factorize(sparse, F);
+        if (info != 0) {
+            std::cerr << "Sparse Cholesky factorization failed at column " << info << std::endl;
+            return 1;
+        }
+        solve(F, b.data(), x.data());
+
+        factor_nnz = F.factor_nnz;
+        factor_bytes = F.values.size() * sizeof(double) +
+                       (F.rows.size() + F.row_ptr.size() + F.perm.size()) * sizeof(int);
+        work_bytes = F.peak_work_bytes;
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = end - start;
+
+    // Относительная невязка ||b - A x|| / ||b||
+    if (format == "banded")
+        band_multiply(band, x.data(), Ax.data());
+    else
+        csr_multiply(sparse, x.data(), Ax.data());
+    double residual_sq = 0.0, b_sq = 0.0;
+    for (int i = 0; i < n; ++i) {
+        residual_sq += (b[i] - Ax[i]) * (b[i] - Ax[i]);
+        b_sq += b[i] * b[i];
+    }
+    double residual = std::sqrt(residual_sq / b_sq);
+
+    double dense_seconds = 0.0;
+    if (compare_dense) {
+        std::vector<double> x_dense;
+        dense_seconds = dense_solve(format == "banded" ? band_to_dense(band) : csr_to_dense(sparse), n, b, x_dense);
+        if (dense_seconds < 0.0) {
+            std::cerr << "Dense Cholesky factorization failed" << std::endl;
+            return 1;
+        }
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    long rss_kb = usage.ru_maxrss;
+
+    // Сумма значений разреженной матрицы всегда равна n (лапласиан плюс единичная
+    // диагональ), поэтому берётся квадратичная форма w^T A w с w_i = (i + 1) / n:
+    // она зависит от рёбер графа, а значит, и от seed
+    double checksum = 0.0;
+    if (format == "banded")
+        for (double v : band.ab) checksum += v;
+    else
+        for (int i = 0; i < n; ++i)
+            for (int k = sparse.row_ptr[i]; k < sparse.row_ptr[i + 1]; ++k)
+                checksum += sparse.val[k] * (i + 1.0) / n * (sparse.col[k] + 1.0) / n;
+
+    std::ostringstream routines_oss;
+    for (size_t i = 0; i < called_routines.size(); ++i) {
+        if (i) routines_oss << ',';
+        routines_oss << called_routines[i];
+    }
+
+    const double mb = 1024.0 * 1024.0;
+    std::cout << std::fixed << std::setprecision(9);
+    std::cout << "RESULT_SECONDS=" << elapsed.count() << std::endl;
+    std::cout << "DIAG_THREADS=openblas/libopenblas:" << num_threads << std::endl;
+    std::cout << "DIAG_PEAK_RSS_KB=" << rss_kb << std::endl;
+    std::cout << "DIAG_ROUTINES=" << routines_oss.str() << std::endl;
+    std::cout << "DIAG_FORMAT=" << format << std::endl;
+    std::cout << "DIAG_ANALYZE_SECONDS=" << analyze_seconds << std::endl;
+    if (compare_dense)
+        std::cout << "DIAG_DENSE_SECONDS=" << dense_seconds << std::endl;
+    else if (dense_skipped)
+        std::cout << "DIAG_DENSE=skipped" << std::endl;
+    std::cout << "DIAG_MATRIX_NNZ=" << matrix_nnz << std::endl;
+    std::cout << "DIAG_FACTOR_NNZ=" << factor_nnz << std::endl;
+    std::cout << "DIAG_DENSE_FACTOR_NNZ=" << size_t(n) * (n + 1) / 2 << std::endl;
+    std::cout << std::setprecision(3);
+    std::cout << "DIAG_FILL_RATIO=" << double(factor_nnz) / matrix_nnz << std::endl;
+    std::cout << "DIAG_FACTOR_MB=" << factor_bytes / mb << std::endl;
+    std::cout << "DIAG_WORK_MB=" << work_bytes / mb << std::endl;
+    std::cout << "DIAG_DENSE_MB=" << dense_mb << std::endl;
+    std::cout << std::scientific << std::setprecision(6);
+    std::cout << "DIAG_RESIDUAL=" << residual << std::endl;
+    std::cout << std::fixed;
+    std::cout << "DIAG_CHECKSUM=" << checksum << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,41 @@
+#!/bin/bash
+
+# Список контейнеров
+containers=(
+	"lapack_stream"
+)
+
+# Последовательный режим – база для сравнения с конвейером
+modes=(pipeline serial)
+
+# Размеры матриц
+sizes=(2500 5000 7500 10000)
+
+# Количество запусков для каждого контейнера и размера
+runs=10
+
+# Запуск контейнеров
+for container in "${containers[@]}"; do
+    for mode in "${modes[@]}"; do
+        for size in "${sizes[@]}"; do
+            # Создаем файл для вывода для текущего контейнера, режима и размера
+            output_file="${container}_${mode}_size_${size}.txt"
+
+            for ((i=1; i<=runs; i++)); do
+                echo "Запуск контейнера $container ($mode) с размером матрицы $size, запуск номер $i..."
+
+                container_id=$(docker run -d --rm "$container" "$size" --mode="$mode" --matrices=16)
+
+                # Ожидаем завершения контейнера и записываем его вывод в файл
+                docker logs -f "$container_id" >> "$output_file"
+
+                # Ждем завершения контейнера
+                docker wait "$container_id"
+
+                echo "Вывод контейнера $container ($mode) с размером матрицы $size, запуск номер $i добавлен в $output_file"
+            done
+        done
+    done
+done
+
+cd ../
@@ -19,6 +19,8 @@ build_container() {
 echo "Building Lapack-OpenBlas Docker containers..."
 
 build_container "lapack_svd" "Dockerfile.lasvd"
+# 64-битные индексы для n > 46340
+build_container "lapack_svd_ilp64" "Dockerfile.lasvd_ilp64"
 
 
 cd ../
@@ -7,99 +7,1415 @@
 #include <chrono>
 #include <cblas.h>
 #include <lapacke.h>
-#include <omp.h>
 #include <algorithm>
 #include <cmath>
+#include <limits>
 #include <cstdlib>
 #include <sys/resource.h>
+#include <fstream>
+#include <cstring>
+#include <cerrno>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <dirent.h>
+#include <atomic>
+#include <malloc.h>
+#include <unistd.h>
+#include <charconv>
+#include <memory>
+#include <cstdint>
+#include <exception>
+#include <stdexcept>
+#include <map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dlfcn.h>
+#include <deque>
+#include <sched.h>
+#include <pthread.h>
 
 // список для основных вызовов LAPACK/BLAS
 std::vector<std::string> called_routines;
 
+// Энергия через Linux powercap (Intel RAPL): домены package и dram.
+// Счётчики energy_uj растут до max_energy_range_uj и обнуляются, поэтому
+// фоновый поток опрашивает их раз в секунду, чтобы не пропустить переполнение.
+// Энергия между вызовами phase() приписывается названной подпрограмме
+class RaplMeter {
+public:
+    void start() {
+        open();
+        if (!available())
+            return;
+        sample();
+        for (Domain& d : domains)
+            d.joules = 0.0;
+        running = true;
+        poller = std::thread([this] {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!wake.wait_for(lock, std::chrono::seconds(1), [this] { return !running; }))
+                sample();
+        });
+    }
+
+    void phase(const std::string& name) {
+        if (!available())
+            return;
+        std::lock_guard<std::mutex> lock(mutex);
+        double now = sample();
+        if (!current.empty()) {
+            auto it = std::find_if(phases.begin(), phases.end(),
+                                   [this](const std::pair<std::string, double>& p) { return p.first == current; });
+            if (it == phases.end())
+                it = phases.insert(phases.end(), std::make_pair(current, 0.0));
+            it->second += now - phase_start;
+        }
+        current = name;
+        phase_start = now;
+    }
+
+    void stop() {
+        if (!available())
+            return;
+        phase("");
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+        }
+        wake.notify_all();
+        poller.join();
+    }
+
+    bool available() const { return status == "ok"; }
+
+    // gflop – номинальное число операций замеряемого участка
+    void report(double gflop) const {
+        std::cout << "DIAG_ENERGY_STATUS=" << status << std::endl;
+        if (!available())
+            return;
+        double total = 0.0;
+        std::ostringstream domains_oss, phases_oss;
+        domains_oss << std::fixed << std::setprecision(6);
+        phases_oss << std::fixed << std::setprecision(6);
+        for (size_t i = 0; i < domains.size(); ++i) {
+            total += domains[i].joules;
+            domains_oss << (i ? "," : "") << domains[i].label << ':' << domains[i].joules;
+        }
+        for (size_t i = 0; i < phases.size(); ++i)
+            phases_oss << (i ? "," : "") << phases[i].first << ':' << phases[i].second;
+        std::cout << "DIAG_ENERGY_J=" << total << std::endl;
+        std::cout << "DIAG_ENERGY_J_PER_GFLOP=" << total / gflop << std::endl;
+        std::cout << "DIAG_ENERGY_DOMAINS=" << domains_oss.str() << std::endl;
+        std::cout << "DIAG_ENERGY_ROUTINES=" << phases_oss.str() << std::endl;
+    }
+
+private:
+    struct Domain {
+        std::string label;
+        std::string path;
+        double max_uj;
+        double last_uj;
+        double joules;
+    };
+
+    // Домены верхнего уровня intel-rapl:N (package-N) и их поддомены dram
+    void open() {
+        const std::string root = "/sys/class/powercap/";
+        DIR* dir = opendir(root.c_str());
+        if (!dir) {
+            status = "unavailable:" + root + ": " + std::strerror(errno);
+            return;
+        }
+        std::vector<std::string> zones;
+        while (dirent* entry = readdir(dir)) {
+            std::string zone = entry->d_name;
+            if (zone.rfind("intel-rapl:", 0) == 0)
+                zones.push_back(zone);
+        }
+        closedir(dir);
+        std::sort(zones.begin(), zones.end());
+
+        for (const std::string& zone : zones) {
+            std::string path = root + zone + "/";
+            std::string name;
+            std::ifstream(path + "name") >> name;
+            std::string package = zone.substr(11, zone.find(':', 11) - 11);
+            if (name == "dram")
+                name += "-" + package;
+            else if (name.rfind("package", 0) != 0)
+                continue;
+
+            Domain d;
+            d.label = name;
+            d.path = path + "energy_uj";
+            d.max_uj = 0.0;
+            std::ifstream(path + "max_energy_range_uj") >> d.max_uj;
+            d.joules = 0.0;
+            errno = 0;
+            std::ifstream counter(d.path);
+            if (!(counter >> d.last_uj)) {
+                status = "unavailable:" + d.path + ": " + (errno ? std::strerror(errno) : "unreadable");
+                domains.clear();
+                return;
+            }
+            domains.push_back(d);
+        }
+        status = domains.empty() ? "unavailable:no intel-rapl package/dram domains" : "ok";
+    }
+
+    // Вызывается под mutex (или до запуска потока); возвращает джоули с начала замера
+    double sample() {
+        double total = 0.0;
+        for (Domain& d : domains) {
+            double uj = d.last_uj;
+            std::ifstream(d.path) >> uj;
+            double delta = uj - d.last_uj;
+            if (delta < 0.0)
+                delta += d.max_uj;
+            d.joules += delta * 1e-6;
+            d.last_uj = uj;
+            total += d.joules;
+        }
+        return total;
+    }
+
+    std::string status = "unavailable:not started";
+    std::vector<Domain> domains;
+    std::vector<std::pair<std::string, double>> phases;
+    std::string current;
+    double phase_start = 0.0;
+    bool running = false;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::thread poller;
+};
+
+RaplMeter rapl;
+
+// Учёт выделений памяти: malloc/free и их родственники из программы перекрывают
+// версии glibc для всего процесса, включая OpenBLAS/MKL и временные буферы
+// LAPACKE, и передают вызов в __libc_*. Размер берётся из malloc_usable_size
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void* __libc_valloc(size_t size);
+void* __libc_pvalloc(size_t size);
+void __libc_free(void* ptr);
+}
+
+namespace heap {
+std::atomic<long long> live{0};       // байт выделено сейчас
+std::atomic<long long> peak{0};       // максимум live с начала фазы
+std::atomic<long long> allocated{0};  // байт выделено с начала программы
+std::atomic<long long> calls{0};
+
+inline void on_alloc(void* ptr) {
+    if (!ptr)
+        return;
+    long long size = malloc_usable_size(ptr);
+    allocated += size;
+    ++calls;
+    long long now = live += size;
+    long long prev = peak.load(std::memory_order_relaxed);
+    while (now > prev && !peak.compare_exchange_weak(prev, now, std::memory_order_relaxed))
+        ;
+}
+
+inline void on_free(void* ptr) {
+    if (ptr)
+        live -= (long long)malloc_usable_size(ptr);
+}
+}  // namespace heap
+
+extern "C" {
+void* malloc(size_t size) noexcept {
+    void* ptr = __libc_malloc(size);
+    heap::on_alloc(ptr);
+    return ptr;
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+    void* ptr = __libc_calloc(count, size);
+    heap::on_alloc(ptr);
+    return ptr;
+}
+
+void* realloc(void* ptr, size_t size) noexcept {
+    long long old_size = ptr ? (long long)malloc_usable_size(ptr) : 0;
+    void* result = __libc_realloc(ptr, size);
+    if (result || size == 0) {
+        heap::live -= old_size;
+        heap::on_alloc(result);
+    }
+    return result;
+}
+
+void free(void* ptr) noexcept {
+    heap::on_free(ptr);
+    __libc_free(ptr);
+}
+
+void* memalign(size_t alignment, size_t size) noexcept {
+    void* ptr = __libc_memalign(alignment, size);
+    heap::on_alloc(ptr);
+    return ptr;
+}
+
+// Выравнивание – степень двойки; memalign молча округлил бы остальные,
+// а aligned_alloc и posix_memalign должны вернуть EINVAL, как в glibc
+static bool power_of_two(size_t alignment) {
+    return alignment != 0 && (alignment & (alignment - 1)) == 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept {
+    if (!power_of_two(alignment)) {
+        errno = EINVAL;
+        return nullptr;
+    }
+    return memalign(alignment, size);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) noexcept {
+    if (!power_of_two(alignment) || alignment % sizeof(void*) != 0)
+        return EINVAL;
+    void* ptr = memalign(alignment, size);
+    if (!ptr)
+        return ENOMEM;
+    *out = ptr;
+    return 0;
+}
+
+void* valloc(size_t size) noexcept {
+    void* ptr = __libc_valloc(size);
+    heap::on_alloc(ptr);
+    return ptr;
+}
+
+void* pvalloc(size_t size) noexcept {
+    void* ptr = __libc_pvalloc(size);
+    heap::on_alloc(ptr);
+    return ptr;
+}
+}
+
+// Трасса выполнения по потокам в формате Chrome trace (chrome://tracing,
+// ui.perfetto.dev), --trace=путь. Каждый поток пишет события в свой буфер,
+// общий замок берётся только при создании буфера. Отметки подпрограмм
+// главного потока ставит MemoryMeter::phase на тех же границах, что и
+// called_routines
+namespace trace {
+struct Event {
+    const char* name;  // строковый литерал или строка из names
+    const char* cat;
+    double ts;         // мкс от начала программы
+    double dur;
+};
+
+struct Buffer {
+    std::mutex mutex;  // свободен всегда, кроме записи файла
+    int tid = 0;
+    std::string name;
+    std::vector<Event> events;
+    long dropped = 0;
+    double spin_start = -1.0;
+    double spin_last = 0.0;
+};
+
+constexpr size_t max_events = 1 << 20;  // на поток; сверх – только счёт потерянных
+
+std::mutex mutex;
+std::atomic<int> workers{0};
+
+struct Registry {
+    std::vector<Buffer*> buffers;  // не освобождаются: потоки пула завершаются раньше записи
+    std::deque<std::string> names; // deque не переносит элементы при росте
+    std::string current;
+    double current_start = 0.0;
+    std::string source = "none";
+};
+
+// Не глобальный объект: OpenBLAS создаёт потоки в конструкторе библиотеки,
+// раньше инициализации глобальных объектов программы
+Registry& registry() {
+    static Registry* r = new Registry;
+    return *r;
+}
+
+// Параметр читается из /proc/self/cmdline, как --threading: события
+// приходят раньше разбора параметров
+const std::string& path() {
+    static const std::string value = [] {
+        std::ifstream cmdline("/proc/self/cmdline");
+        std::string arg, found;
+        while (std::getline(cmdline, arg, '\0'))
+            if (arg.rfind("--trace=", 0) == 0)
+                found = arg.substr(8);
+        return found;
+    }();
+    return value;
+}
+
+bool enabled() {
+    static const bool value = !path().empty();
+    return value;
+}
+
+double now_us() {
+    static const auto origin = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - origin).count();
+}
+
+thread_local Buffer* local_buffer = nullptr;
+
+Buffer* local(const char* name = nullptr) {
+    if (!local_buffer) {
+        Buffer* b = new Buffer;
+        b->tid = (int)gettid();
+        b->name = name ? name : (b->tid == getpid() ? "main" : "thread " + std::to_string(b->tid));
+        b->events.reserve(1 << 12);
+        std::lock_guard<std::mutex> lock(mutex);
+        registry().buffers.push_back(b);
+        local_buffer = b;
+    }
+    return local_buffer;
+}
+
+void record(Buffer* b, const char* name, const char* cat, double ts, double dur) {
+    std::lock_guard<std::mutex> lock(b->mutex);
+    if (b->events.size() < max_events)
+        b->events.push_back({name, cat, ts, dur});
+    else
+        ++b->dropped;
+}
+
+void record(const char* name, const char* cat, double ts, double dur) {
+    record(local(), name, cat, ts, dur);
+}
+
+// Граница фазы главного потока; подпрограммы из called_routines – категория routine
+void phase(const std::string& name) {
+    if (!enabled() || name == registry().current)
+        return;
+    Registry& r = registry();
+    double now = now_us();
+    if (!r.current.empty()) {
+        bool routine = std::find(called_routines.begin(), called_routines.end(), r.current) != called_routines.end();
+        r.names.push_back(r.current);
+        record(r.names.back().c_str(), routine ? "routine" : "phase", r.current_start, now - r.current_start);
+    }
+    r.current = name;
+    r.current_start = now;
+}
+
+// Серия sched_yield с промежутками не больше spin_gap – одно событие spin:
+// так рабочие OpenBLAS ждут задачу, а главный поток – окончания рабочих
+constexpr double spin_gap = 50.0;  // мкс
+
+void close_spin(Buffer* b) {
+    if (b->spin_start < 0.0)
+        return;
+    if (b->events.size() < max_events)
+        b->events.push_back({"spin", "wait", b->spin_start, b->spin_last - b->spin_start});
+    else
+        ++b->dropped;
+    b->spin_start = -1.0;
+}
+
+void spin() {
+    Buffer* b = local();
+    double now = now_us();
+    std::lock_guard<std::mutex> lock(b->mutex);
+    if (b->spin_start >= 0.0 && now - b->spin_last <= spin_gap) {
+        b->spin_last = now;
+        return;
+    }
+    close_spin(b);
+    b->spin_start = b->spin_last = now;
+}
+
+struct Start {
+    void* (*routine)(void*);
+    void* arg;
+    std::string name;
+};
+
+// Имя потока – библиотека, создавшая его: libopenblas.so.0 #1, libgomp.so.1 #2, ...
+void* thread_main(void* p) {
+    std::unique_ptr<Start> start(static_cast<Start*>(p));
+    local(start->name.c_str());
+    return start->routine(start->arg);
+}
+
+Start* wrap(void* (*routine)(void*), void* arg) {
+    Dl_info info;
+    std::string library = (dladdr((void*)routine, &info) && info.dli_fname) ? info.dli_fname : "thread";
+    library = library.substr(library.rfind('/') + 1);
+    if (library.find("openblas") != std::string::npos || library.find("gomp") != std::string::npos)
+        registry().source = "pthread";
+    return new Start{routine, arg, library + " #" + std::to_string(++workers)};
+}
+
+// Запись JSON; возвращает строку для DIAG_TRACE или пустую при ошибке записи
+std::string write() {
+    phase("");
+    std::ofstream out(path());
+    if (!out)
+        return "";
+    std::lock_guard<std::mutex> lock(mutex);
+    const Registry& r = registry();
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << getpid() << ",\"args\":{\"name\":\"" << program_invocation_short_name << "\"}}";
+    long events = 0, dropped = 0;
+    for (Buffer* b : r.buffers) {
+        std::lock_guard<std::mutex> buffer_lock(b->mutex);
+        close_spin(b);
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << getpid() << ",\"tid\":" << b->tid
+            << ",\"args\":{\"name\":\"" << b->name << "\"}}";
+        for (const Event& e : b->events)
+            out << ",\n{\"name\":\"" << e.name << "\",\"cat\":\"" << e.cat << "\",\"ph\":\"X\",\"pid\":" << getpid()
+                << ",\"tid\":" << b->tid << ",\"ts\":" << e.ts << ",\"dur\":" << e.dur << "}";
+        events += b->events.size();
+        dropped += b->dropped;
+    }
+    out << "\n]}\n";
+    if (!out)
+        return "";
+    return path() + ",source:" + r.source + ",threads:" + std::to_string(r.buffers.size()) +
+           ",events:" + std::to_string(events) + ",dropped:" + std::to_string(dropped);
+}
+}  // namespace trace
+
+// Перехваты pthread для пула OpenBLAS; без --trace – сразу вызов glibc
+extern "C" {
+int __sched_yield(void);
+
+int pthread_create(pthread_t* thread, const pthread_attr_t* attr, void* (*routine)(void*), void* arg) noexcept {
+    using Create = int (*)(pthread_t*, const pthread_attr_t*, void* (*)(void*), void*);
+    static Create real = (Create)dlsym(RTLD_NEXT, "pthread_create");
+    if (!trace::enabled())
+        return real(thread, attr, routine, arg);
+    trace::Start* start = trace::wrap(routine, arg);
+    int rc = real(thread, attr, trace::thread_main, start);
+    if (rc != 0)
+        delete start;
+    return rc;
+}
+
+// Сон потока пула без работы
+int pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex) noexcept {
+    using Wait = int (*)(pthread_cond_t*, pthread_mutex_t*);
+    static Wait real = (Wait)dlsym(RTLD_NEXT, "pthread_cond_wait");
+    if (!trace::enabled())
+        return real(cond, mutex);
+    double start = trace::now_us();
+    int rc = real(cond, mutex);
+    trace::record("sleep", "wait", start, trace::now_us() - start);
+    return rc;
+}
+
+int sched_yield(void) noexcept {
+    if (trace::enabled())
+        trace::spin();
+    return __sched_yield();
+}
+}
+
+// Память по фазам: на каждой границе phase() снимаются малые/большие отказы
+// страниц (getrusage), резидентный размер (/proc/self/statm) и счётчики выделений.
+// Фаза до первой отметки – startup (загрузка библиотек и разбор аргументов)
+class MemoryMeter {
+public:
+    MemoryMeter() {
+        mark = snapshot();
+    }
+
+    void phase(const std::string& name) {
+        trace::phase(name);
+        Snapshot now = snapshot();
+        auto it = std::find_if(phases.begin(), phases.end(),
+                               [this](const Phase& p) { return p.name == current; });
+        if (it == phases.end()) {
+            it = phases.insert(phases.end(), Phase());
+            it->name = current;
+        }
+        it->alloc_bytes += now.allocated - mark.allocated;
+        it->heap_peak = std::max(it->heap_peak, heap::peak.load());
+        it->rss_delta += now.rss - mark.rss;
+        it->minflt += now.minflt - mark.minflt;
+        it->majflt += now.majflt - mark.majflt;
+        heap_peak_total = std::max(heap_peak_total, heap::peak.load());
+        heap::peak = heap::live.load();
+        current = name;
+        mark = now;
+    }
+
+    // Закрывает текущую фазу; поля фазы: выделено, пик кучи и прирост RSS в КБ, отказы страниц
+    void report() {
+        phase(current);
+        std::ostringstream oss;
+        for (size_t i = 0; i < phases.size(); ++i) {
+            const Phase& p = phases[i];
+            oss << (i ? "," : "") << p.name
+                << ":alloc_kb=" << p.alloc_bytes / 1024
+                << ":heap_peak_kb=" << p.heap_peak / 1024
+                << ":rss_delta_kb=" << p.rss_delta / 1024
+                << ":minflt=" << p.minflt
+                << ":majflt=" << p.majflt;
+        }
+        std::cout << "DIAG_MEM_PHASES=" << oss.str() << std::endl;
+        std::cout << "DIAG_MEM_HEAP_PEAK_KB=" << heap_peak_total / 1024 << std::endl;
+        std::cout << "DIAG_MEM_ALLOCS=" << heap::calls.load() << std::endl;
+    }
+
+private:
+    struct Snapshot {
+        long long allocated;
+        long long rss;
+        long minflt;
+        long majflt;
+    };
+
+    struct Phase {
+        std::string name;
+        long long alloc_bytes = 0;
+        long long heap_peak = 0;
+        long long rss_delta = 0;
+        long minflt = 0;
+        long majflt = 0;
+    };
+
+    static Snapshot snapshot() {
+        Snapshot s;
+        s.allocated = heap::allocated.load();
+        long pages = 0, resident = 0;
+        std::ifstream("/proc/self/statm") >> pages >> resident;
+        s.rss = (long long)resident * sysconf(_SC_PAGESIZE);
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        s.minflt = usage.ru_minflt;
+        s.majflt = usage.ru_majflt;
+        return s;
+    }
+
+    std::vector<Phase> phases;
+    std::string current = "startup";
+    Snapshot mark;
+    long long heap_peak_total = 0;
+};
+
+MemoryMeter memory;
+
+// Необязательные параметры вида --key=value
+std::map<std::string, std::string> parse_options(int argc, char* argv[], int first) {
+    std::map<std::string, std::string> options;
+    for (int i = first; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+            throw std::invalid_argument("Unknown argument: " + arg);
+        options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+    }
+    return options;
+}
+
+std::string option(const std::map<std::string, std::string>& options,
+                   const std::string& key, const std::string& fallback) {
+    auto it = options.find(key);
+    return it == options.end() ? fallback : it->second;
+}
+
+// Матрица из файла --input=путь вместо синтетической. Форматы:
+// - .npy: float64/float32/int64/int32, C- или Fortran-порядок;
+// - Matrix Market: array и coordinate, real/integer/pattern,
+//   general/symmetric/skew-symmetric;
+// - сырой двоичный: double в строчном порядке, квадратная матрица или --input-shape=RxC.
+// Файл отображается mmap. float64 в C-порядке и сырой формат используются на месте
+// без копирования, остальное за один проход приводится к плотному строчному
+// формату, с которым работают программы. Текст Matrix Market разбирается
+// параллельно по кускам файла
+class InputMatrix {
+public:
+    int rows = 0, cols = 0;
+    std::string format = "synthetic";
+    bool mapped = false;        // данные лежат в отображении файла
+    double load_seconds = 0.0;
+
+    InputMatrix() = default;
+    InputMatrix(std::vector<double>&& values, int r, int c)
+        : rows(r), cols(c), storage(std::move(values)), view(storage.data()) {}
+    InputMatrix(std::shared_ptr<void> file, const double* data, int r, int c)
+        : rows(r), cols(c), mapped(true), mapping(std::move(file)), view(data) {}
+    InputMatrix(InputMatrix&&) = default;
+    InputMatrix& operator=(InputMatrix&&) = default;
+
+    const double* data() const { return view; }
+    const double* begin() const { return view; }
+    const double* end() const { return view + size(); }
+    size_t size() const { return (size_t)rows * cols; }
+
+    void report() const {
+        std::cout << "DIAG_INPUT=" << format << ":" << rows << "x" << cols << ":"
+                  << (mapped ? "mapped" : "converted") << ":" << load_seconds << std::endl;
+    }
+
+private:
+    std::vector<double> storage;
+    std::shared_ptr<void> mapping;  // munmap при уничтожении
+    const double* view = nullptr;
+};
+
+struct MappedFile {
+    const char* bytes = nullptr;
+    size_t length = 0;
+    std::shared_ptr<void> owner;
+};
+
+MappedFile map_file(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::invalid_argument("Cannot open " + path + ": " + std::strerror(errno));
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        throw std::invalid_argument("Empty or unreadable input: " + path);
+    }
+    size_t length = st.st_size;
+    void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        throw std::invalid_argument("Cannot mmap " + path + ": " + std::strerror(errno));
+    madvise(p, length, MADV_SEQUENTIAL);
+    MappedFile file;
+    file.bytes = static_cast<const char*>(p);
+    file.length = length;
+    file.owner = std::shared_ptr<void>(p, [length](void* q) { munmap(q, length); });
+    return file;
+}
+
+// fn(part, begin, end) для parts частей диапазона [0, count) в отдельных потоках;
+// исключение из любого потока пробрасывается вызывающему
+template<class F>
+void parallel_parts(size_t count, int parts, F&& fn) {
+    parts = (int)std::max<size_t>(1, std::min<size_t>(parts, count));
+    std::vector<std::exception_ptr> errors(parts);
+    std::vector<std::thread> pool;
+    for (int p = 0; p < parts; ++p)
+        pool.emplace_back([&, p] {
+            try {
+                fn(p, count * p / parts, count * (p + 1) / parts);
+            } catch (...) {
+                errors[p] = std::current_exception();
+            }
+        });
+    for (std::thread& t : pool)
+        t.join();
+    for (std::exception_ptr& e : errors)
+        if (e)
+            std::rethrow_exception(e);
+}
+
+int loader_threads(size_t bytes) {
+    // Не меньше 4 МБ на поток: на маленьких файлах потоки дороже разбора
+    size_t by_size = std::max<size_t>(1, bytes >> 22);
+    return (int)std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), by_size);
+}
+
+// Элементы файла типа T (в строчном или столбцовом порядке) -> строчный double
+template<class T>
+std::vector<double> convert_dense(const char* src, int rows, int cols, bool column_major) {
+    std::vector<double> out((size_t)rows * cols);
+    parallel_parts(rows, loader_threads(out.size() * sizeof(T)), [&](int, size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i)
+            for (int j = 0; j < cols; ++j) {
+                size_t k = column_major ? (size_t)j * rows + i : i * cols + j;
+                T value;
+                std::memcpy(&value, src + k * sizeof(T), sizeof(T));
+                out[i * cols + j] = (double)value;
+            }
+    });
+    return out;
+}
+
+InputMatrix load_npy(const MappedFile& file) {
+    if (file.length < 10 || std::memcmp(file.bytes, "\x93NUMPY", 6) != 0)
+        throw std::invalid_argument("Not a .npy file");
+    int major = (unsigned char)file.bytes[6];
+    size_t header_len, header_start;
+    if (major == 1) {
+        header_len = (unsigned char)file.bytes[8] | ((unsigned char)file.bytes[9] << 8);
+        header_start = 10;
+    } else {
+        uint32_t len;
+        std::memcpy(&len, file.bytes + 8, 4);
+        header_len = len;
+        header_start = 12;
+    }
+    if (header_start + header_len > file.length)
+        throw std::invalid_argument(".npy header is truncated");
+    std::string header(file.bytes + header_start, header_len);
+
+    auto value_of = [&](const std::string& key) {
+        size_t pos = header.find("'" + key + "'");
+        if (pos == std::string::npos)
+            throw std::invalid_argument(".npy header has no " + key);
+        pos = header.find(':', pos) + 1;
+        while (pos < header.size() && header[pos] == ' ')
+            ++pos;
+        return pos;
+    };
+    size_t pos = value_of("descr");
+    std::string descr = header.substr(pos + 1, header.find('\'', pos + 1) - pos - 1);
+    bool column_major = header.compare(value_of("fortran_order"), 4, "True") == 0;
+    pos = value_of("shape");
+    std::vector<long> shape;
+    for (size_t end = header.find(')', pos); pos < end;) {
+        if (isdigit((unsigned char)header[pos])) {
+            size_t used;
+            shape.push_back(std::stol(header.substr(pos), &used));
+            pos += used;
+        } else {
+            ++pos;
+        }
+    }
+    if (shape.size() != 2)
+        throw std::invalid_argument(".npy array must be 2-dimensional");
+    int rows = (int)shape[0], cols = (int)shape[1];
+
+    if (descr.size() != 3 || descr[0] == '>')
+        throw std::invalid_argument("Unsupported .npy dtype " + descr);
+    std::string type = descr.substr(1);
+    size_t item = (size_t)(type[1] - '0');
+    size_t offset = header_start + header_len;
+    if (offset + (size_t)rows * cols * item > file.length)
+        throw std::invalid_argument(".npy data is truncated");
+    const char* data = file.bytes + offset;
+
+    InputMatrix matrix;
+    if (type == "f8" && !column_major && offset % sizeof(double) == 0)
+        matrix = InputMatrix(file.owner, reinterpret_cast<const double*>(data), rows, cols);
+    else if (type == "f8")
+        matrix = InputMatrix(convert_dense<double>(data, rows, cols, column_major), rows, cols);
+    else if (type == "f4")
+        matrix = InputMatrix(convert_dense<float>(data, rows, cols, column_major), rows, cols);
+    else if (type == "i8")
+        matrix = InputMatrix(convert_dense<int64_t>(data, rows, cols, column_major), rows, cols);
+    else if (type == "i4")
+        matrix = InputMatrix(convert_dense<int32_t>(data, rows, cols, column_major), rows, cols);
+    else
+        throw std::invalid_argument("Unsupported .npy dtype " + descr);
+    matrix.format = "npy-" + type;
+    return matrix;
+}
+
+InputMatrix load_raw(const MappedFile& file, const std::string& shape) {
+    size_t count = file.length / sizeof(double);
+    int rows, cols;
+    if (!shape.empty()) {
+        size_t x = shape.find('x');
+        rows = std::stoi(shape.substr(0, x));
+        cols = (x == std::string::npos) ? rows : std::stoi(shape.substr(x + 1));
+    } else {
+        rows = cols = (int)std::llround(std::sqrt((double)count));
+    }
+    if (file.length % sizeof(double) != 0 || (size_t)rows * cols != count)
+        throw std::invalid_argument("Raw input of " + std::to_string(file.length) +
+                                    " bytes does not match the matrix shape; use --input-shape=RxC");
+    InputMatrix matrix(file.owner, reinterpret_cast<const double*>(file.bytes), rows, cols);
+    matrix.format = "raw";
+    return matrix;
+}
+
+// Пробелы и строки-комментарии '%' перед следующим числом
+const char* skip_blank(const char* p, const char* end) {
+    while (p < end) {
+        if (*p == '%')
+            while (p < end && *p != '\n')
+                ++p;
+        else if (isspace((unsigned char)*p))
+            ++p;
+        else
+            break;
+    }
+    return p;
+}
+
+template<class T>
+const char* parse_number(const char* p, const char* end, T& value) {
+    if (p < end && *p == '+')
+        ++p;
+    std::from_chars_result r = std::from_chars(p, end, value);
+    if (r.ec != std::errc())
+        throw std::invalid_argument("Matrix Market: bad number '" + std::string(p, std::min<size_t>(end - p, 16)) + "'");
+    return r.ptr;
+}
+
+// Границы кусков текста [begin, end) по началам строк
+std::vector<const char*> split_lines(const char* begin, const char* end, int parts) {
+    std::vector<const char*> cuts{begin};
+    for (int p = 1; p < parts; ++p) {
+        const char* cut = std::max(begin + (end - begin) * p / parts, cuts.back());
+        while (cut < end && *cut != '\n')
+            ++cut;
+        cuts.push_back(cut < end ? cut + 1 : end);
+    }
+    cuts.push_back(end);
+    return cuts;
+}
+
+InputMatrix load_matrix_market(const MappedFile& file) {
+    const char* end = file.bytes + file.length;
+    const char* line_end = std::find(file.bytes, end, '\n');
+    std::istringstream banner(std::string(file.bytes, line_end));
+    std::string tag, object, layout, field, symmetry;
+    banner >> tag >> object >> layout >> field >> symmetry;
+    for (std::string* s : {&object, &layout, &field, &symmetry})
+        std::transform(s->begin(), s->end(), s->begin(), ::tolower);
+    if (object != "matrix" || (layout != "array" && layout != "coordinate") ||
+        (field != "real" && field != "integer" && field != "double" && field != "pattern") ||
+        (symmetry != "general" && symmetry != "symmetric" && symmetry != "skew-symmetric"))
+        throw std::invalid_argument("Unsupported Matrix Market header: " + std::string(file.bytes, line_end));
+    bool coordinate = (layout == "coordinate"), pattern = (field == "pattern");
+    bool general = (symmetry == "general"), skew = (symmetry == "skew-symmetric");
+
+    // Строка размеров: rows cols [nnz]
+    long rows, cols, entries;
+    const char* p = parse_number(skip_blank(line_end, end), end, rows);
+    p = parse_number(skip_blank(p, end), end, cols);
+    if (coordinate)
+        p = parse_number(skip_blank(p, end), end, entries);
+    else
+        entries = general ? rows * cols : skew ? rows * (rows - 1) / 2 : rows * (rows + 1) / 2;
+    if (!general && rows != cols)
+        throw std::invalid_argument("Symmetric Matrix Market matrix must be square");
+
+    std::vector<double> dense((size_t)rows * cols, 0.0);
+    double mirror = skew ? -1.0 : 1.0;
+    std::vector<const char*> cuts = split_lines(p, end, loader_threads(end - p));
+    int parts = (int)cuts.size() - 1;
+
+    // array: значения по столбцам (у симметричных – нижний треугольник), и
+    // позиция зависит от номера значения, поэтому сначала считаются числа в кусках
+    std::vector<size_t> first(parts + 1, 0);
+    if (!coordinate) {
+        parallel_parts(parts, parts, [&](int, size_t k, size_t) {
+            size_t count = 0;
+            for (const char* q = skip_blank(cuts[k], cuts[k + 1]); q < cuts[k + 1]; q = skip_blank(q, cuts[k + 1])) {
+                ++count;
+                while (q < cuts[k + 1] && !isspace((unsigned char)*q))
+                    ++q;
+            }
+            first[k + 1] = count;
+        });
+        for (int k = 0; k < parts; ++k)
+            first[k + 1] += first[k];
+    }
+
+    std::vector<size_t> found(parts, 0);
+    parallel_parts(parts, parts, [&](int, size_t k, size_t) {
+        const char* q = skip_blank(cuts[k], cuts[k + 1]);
+        const char* stop = cuts[k + 1];
+        if (coordinate) {
+            for (; q < stop; q = skip_blank(q, stop)) {
+                long i, j;
+                double v = 1.0;
+                q = parse_number(q, stop, i);
+                q = parse_number(skip_blank(q, stop), stop, j);
+                if (!pattern)
+                    q = parse_number(skip_blank(q, stop), stop, v);
+                if (i < 1 || i > rows || j < 1 || j > cols)
+                    throw std::invalid_argument("Matrix Market entry out of range");
+                dense[(i - 1) * cols + (j - 1)] = v;
+                if (!general && i != j)
+                    dense[(j - 1) * cols + (i - 1)] = mirror * v;
+                ++found[k];
+            }
+            return;
+        }
+        // Индекс первого значения куска -> (i, j) и дальше по порядку столбцов
+        size_t index = first[k];
+        long i = 0, j = 0;
+        if (general) {
+            j = index / rows;
+            i = index % rows;
+        } else {
+            long start = skew ? 1 : 0;
+            for (j = 0; j < cols; ++j) {
+                size_t column = rows - j - start;
+                if (index < column)
+                    break;
+                index -= column;
+            }
+            i = j + start + index;
+        }
+        for (; q < stop; q = skip_blank(q, stop)) {
+            double v;
+            q = parse_number(q, stop, v);
+            if (j >= cols)
+                throw std::invalid_argument("Matrix Market array has too many values");
+            dense[i * cols + j] = v;
+            if (!general)
+                dense[j * cols + i] = mirror * v;
+            ++found[k];
+            if (++i == rows) {
+                ++j;
+                i = general ? 0 : j + (skew ? 1 : 0);
+            }
+        }
+    });
+    size_t total = 0;
+    for (size_t f : found)
+        total += f;
+    if (total != (size_t)entries)
+        throw std::invalid_argument("Matrix Market: expected " + std::to_string(entries) +
+                                    " values, found " + std::to_string(total));
+
+    InputMatrix matrix(std::move(dense), (int)rows, (int)cols);
+    matrix.format = "mtx-" + layout + "-" + symmetry;
+    return matrix;
+}
+
+// --<key>=путь: формат по сигнатуре файла; размер квадратной матрицы
+// записывается в n (если n уже задан аргументом, он должен совпасть).
+// Без --<key> возвращается пустая матрица
+InputMatrix load_input(const std::map<std::string, std::string>& options, const std::string& key, int& n) {
+    auto it = options.find(key);
+    if (it == options.end())
+        return InputMatrix();
+    memory.phase("load-" + key);
+    auto start = std::chrono::steady_clock::now();
+    MappedFile file = map_file(it->second);
+    InputMatrix matrix;
+    if (file.length >= 6 && std::memcmp(file.bytes, "\x93NUMPY", 6) == 0)
+        matrix = load_npy(file);
+    else if (file.length >= 14 && std::memcmp(file.bytes, "%%MatrixMarket", 14) == 0)
+        matrix = load_matrix_market(file);
+    else
+        matrix = load_raw(file, option(options, key + "-shape", ""));
+    matrix.load_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (matrix.rows != matrix.cols)
+        throw std::invalid_argument("Input matrix must be square, got " + std::to_string(matrix.rows) +
+                                    "x" + std::to_string(matrix.cols));
+    if (n > 0 && n != matrix.rows)
+        throw std::invalid_argument("Matrix size " + std::to_string(n) + " does not match input " +
+                                    std::to_string(matrix.rows));
+    n = matrix.rows;
+    return matrix;
+}
+
+// Первый аргумент – размер матрицы; с --input=путь его можно опустить.
+// Возвращает индекс первой опции
+int size_argument(int argc, char* argv[], int& n) {
+    if (argc >= 2 && std::string(argv[1]).rfind("--", 0) != 0) {
+        n = std::atoi(argv[1]);
+        return 2;
+    }
+    n = 0;
+    return 1;
+}
+
 // Создание симметричной положительно определённой матрицы
 std::vector<double> create_spd_matrix(int n, int seed) {
-    std::vector<double> A(n * n);
+    std::vector<double> A((size_t)n * n);
     std::mt19937 gen(seed);
     std::uniform_real_distribution<> dis(0.0, 1.0);
 
-    for (int i = 0; i < n * n; ++i) {
+    for (size_t i = 0; i < (size_t)n * n; ++i) {
         A[i] = dis(gen);
     }
 
     for (int i = 0; i < n; ++i) {
         for (int j = 0; j < i; ++j) {
-            double avg = (A[i*n + j] + A[j*n + i]) / 2.0;
-            A[i*n + j] = A[j*n + i] = avg;
+            double avg = (A[(size_t)i*n + j] + A[(size_t)j*n + i]) / 2.0;
+            A[(size_t)i*n + j] = A[(size_t)j*n + i] = avg;
         }
-        A[i*n + i] += n;
+        A[(size_t)i*n + i] += n;
     }
     return A;
 }
 
+// Драйверы SVD: разделяй и властвуй dgesdd, QR-итерации dgesvd, бисекция и
+// обратные итерации dgesvdx, Якоби с предобусловливанием dgejsv и односторонний
+// Якоби dgesvj. vectors: 'A' – полные U и VT, 'S' – тонкие (у квадратной матрицы
+// совпадают с полными), 'N' – только сингулярные числа.
+// A (n x n, построчно) разрушается; U и VT – n x n построчно
+int run_svd(const std::string& driver, char vectors, int n, double* A, double* S, double* U, double* VT) {
+    bool want = (vectors != 'N');
+    if (driver == "gesdd")
+        return LAPACKE_dgesdd(LAPACK_ROW_MAJOR, vectors, n, n, A, n, S, U, n, VT, n);
+    if (driver == "gesvd") {
+        std::vector<double> superb(std::max(1, n - 1));
+        return LAPACKE_dgesvd(LAPACK_ROW_MAJOR, vectors, vectors, n, n, A, n, S, U, n, VT, n, superb.data());
+    }
+    if (driver == "gesvdx") {
+        lapack_int found = 0;
+        std::vector<lapack_int> superb(12 * n);
+        char job = want ? 'V' : 'N';
+        return LAPACKE_dgesvdx(LAPACK_ROW_MAJOR, job, job, 'A', n, n, A, n, 0.0, 0.0, 0, 0,
+                               &found, S, U, n, VT, n, superb.data());
+    }
+
+    // Якоби возвращает V, а не V^T, и числа с масштабом: sigma = scale * sva
+    int info;
+    double scale;
+    if (driver == "gejsv") {
+        double stat[7];
+        lapack_int istat[3];
+        char jobu = (vectors == 'A') ? 'F' : (want ? 'U' : 'N');
+        info = LAPACKE_dgejsv(LAPACK_ROW_MAJOR, 'C', jobu, want ? 'V' : 'N', 'R', 'N', 'N',
+                              n, n, A, n, S, U, n, VT, n, stat, istat);
+        scale = stat[0] / stat[1];
+    } else {
+        double stat[6];
+        info = LAPACKE_dgesvj(LAPACK_ROW_MAJOR, 'G', want ? 'U' : 'N', want ? 'V' : 'N',
+                              n, n, A, n, S, 0, VT, n, stat);
+        scale = stat[0];
+        // Левые векторы остаются на месте A
+        if (info == 0 && want)
+            std::copy(A, A + (size_t)n * n, U);
+    }
+    if (info != 0)
+        return info;
+    for (int i = 0; i < n; ++i)
+        S[i] *= scale;
+    if (want)
+        for (int i = 0; i < n; ++i)
+            for (int j = i + 1; j < n; ++j)
+                std::swap(VT[(size_t)i * n + j], VT[(size_t)j * n + i]);
+    return 0;
+}
+
+// Этапы SVD по отдельности: бидиагонализация dgebrd, сингулярные числа
+// бидиагональной матрицы и обратное преобразование векторов. Схема "dc" повторяет
+// dgesdd (dbdsdc, затем dormbr), "qr" – dgesvd (dorgbr формирует Q и P^T, dbdsqr
+// вращает их вместе с числами). Буфер передаётся по столбцам: это SVD A^T с теми же
+// числами, зато LAPACKE не транспонирует матрицу на каждом этапе
+struct SvdPhases {
+    std::string pipeline;
+    std::vector<std::pair<std::string, double>> seconds;
+    std::vector<double> S;
+};
+
+int svd_phases(bool qr, bool vectors, int n, const double* A_in, SvdPhases& out) {
+    std::vector<double> A(A_in, A_in + (size_t)n * n);
+    std::vector<double> d(n), e(std::max(1, n - 1)), tauq(n), taup(n);
+    std::vector<double> U(vectors ? (size_t)n * n : 1), VT(vectors ? (size_t)n * n : 1);
+    out.pipeline = qr ? "qr" : "dc";
+    out.seconds.clear();
+
+    auto start = std::chrono::steady_clock::now();
+    auto lap = [&](const std::string& name) {
+        auto now = std::chrono::steady_clock::now();
+        out.seconds.emplace_back(name, std::chrono::duration<double>(now - start).count());
+        start = now;
+    };
+
+    int info = LAPACKE_dgebrd(LAPACK_COL_MAJOR, n, n, A.data(), n, d.data(), e.data(), tauq.data(), taup.data());
+    if (info != 0)
+        return info;
+    lap("gebrd");
+
+    int m = vectors ? n : 0;
+    if (qr) {
+        if (vectors) {
+            U = A;
+            VT = A;
+            info = LAPACKE_dorgbr(LAPACK_COL_MAJOR, 'Q', n, n, n, U.data(), n, tauq.data());
+            if (info == 0)
+                info = LAPACKE_dorgbr(LAPACK_COL_MAJOR, 'P', n, n, n, VT.data(), n, taup.data());
+            if (info != 0)
+                return info;
+            lap("orgbr");
+        }
+        info = LAPACKE_dbdsqr(LAPACK_COL_MAJOR, 'U', n, m, m, 0, d.data(), e.data(),
+                              VT.data(), n, U.data(), n, nullptr, 1);
+        if (info != 0)
+            return info;
+        lap("bdsqr");
+    } else {
+        info = LAPACKE_dbdsdc(LAPACK_COL_MAJOR, 'U', vectors ? 'I' : 'N', n, d.data(), e.data(),
+                              U.data(), n, VT.data(), n, nullptr, nullptr);
+        if (info != 0)
+            return info;
+        lap("bdsdc");
+        if (vectors) {
+            info = LAPACKE_dormbr(LAPACK_COL_MAJOR, 'Q', 'L', 'N', n, n, n, A.data(), n, tauq.data(), U.data(), n);
+            if (info == 0)
+                info = LAPACKE_dormbr(LAPACK_COL_MAJOR, 'P', 'R', 'T', n, n, n, A.data(), n, taup.data(), VT.data(), n);
+            if (info != 0)
+                return info;
+            lap("ormbr");
+        }
+    }
+    out.S = d;
+    return 0;
+}
+
+// Невязка ||A (X v) - v|| / (||A||_F ||X||_F ||v||) на случайном векторе v за O(n^2)
+// вместо полного произведения A X
+double probe_residual(const double* A, const double* X, int n) {
+    std::mt19937 gen(n + 2);
+    std::uniform_real_distribution<> dis(-1.0, 1.0);
+    std::vector<double> v(n), Xv(n), r(n);
+    for (double& x : v)
+        x = dis(gen);
+
+    cblas_dgemv(CblasRowMajor, CblasNoTrans, n, n, 1.0, X, n, v.data(), 1, 0.0, Xv.data(), 1);
+    r = v;
+    cblas_dgemv(CblasRowMajor, CblasNoTrans, n, n, 1.0, A, n, Xv.data(), 1, -1.0, r.data(), 1);
+
+    double norm_A = cblas_dnrm2((size_t)n * n, A, 1);
+    double norm_X = cblas_dnrm2((size_t)n * n, X, 1);
+    return cblas_dnrm2(n, r.data(), 1) / (norm_A * norm_X * cblas_dnrm2(n, v.data(), 1));
+}
+
+// Вариант сборки OpenBLAS (Debian): pthread, openmp и serial ставятся рядом в
+// <libdir>/openblas-<вариант>/. Загруженную библиотеку не заменить, поэтому
+// программа перезапускает себя с LD_LIBRARY_PATH на каталог нужного варианта
+std::string openblas_variant() {
+    switch (openblas_get_parallel()) {
+    case 0:
+        return "serial";
+    case 2:
+        return "openmp";
+    default:
+        return "pthread";
+    }
+}
+
+// Файл загруженной libopenblas по /proc/self/maps (символические ссылки уже раскрыты)
+std::string openblas_library() {
+    std::ifstream maps("/proc/self/maps");
+    std::string line;
+    while (std::getline(maps, line)) {
+        size_t slash = line.find('/');
+        if (slash != std::string::npos && line.find("/libopenblas", slash) != std::string::npos)
+            return line.substr(slash);
+    }
+    return "";
+}
+
+// Возвращается, только если нужный вариант уже загружен; иначе исключение или exec
+void select_openblas_variant(const std::string& variant, char* argv[]) {
+    if (variant != "pthread" && variant != "openmp" && variant != "serial")
+        throw std::invalid_argument("Unknown --openblas: " + variant);
+    if (openblas_variant() == variant)
+        return;
+    std::string library = openblas_library();
+    if (std::getenv("OPENBLAS_VARIANT_EXEC") || library.empty())
+        throw std::invalid_argument("OpenBLAS variant is not installed: " + variant);
+
+    // .../openblas-pthread/libopenblas.so.0 -> .../openblas-<variant>
+    std::string dir = library.substr(0, library.rfind('/'));
+    dir = dir.substr(0, dir.rfind('/')) + "/openblas-" + variant;
+    const char* old = std::getenv("LD_LIBRARY_PATH");
+    std::string path = dir + (old && *old ? ":" + std::string(old) : "");
+    setenv("LD_LIBRARY_PATH", path.c_str(), 1);
+    setenv("OPENBLAS_VARIANT_EXEC", variant.c_str(), 1);
+    execv("/proc/self/exe", argv);
+    throw std::invalid_argument(std::string("execv failed: ") + std::strerror(errno));
+}
+
+// Признаки переподписки ядер: несколько рантаймов OpenMP в одном процессе,
+// разрешённые вложенные параллельные участки и потоков больше, чем CPU.
+// Пулы потоков BLAS живут до выхода, поэтому снимок после замера их застаёт
+struct Oversubscription {
+    std::vector<std::string> runtimes;  // iomp5, gomp, omp, tbb
+    int threads = 0;
+    int cpus = 0;
+    int levels = 1;
+
+    static Oversubscription detect() {
+        Oversubscription o;
+        std::ifstream maps("/proc/self/maps");
+        std::string line;
+        static const std::pair<const char*, const char*> libraries[] = {
+            {"/libiomp5", "iomp5"}, {"/libgomp", "gomp"}, {"/libomp.", "omp"}, {"/libtbb.", "tbb"}};
+        while (std::getline(maps, line))
+            for (const auto& library : libraries)
+                if (line.find(library.first) != std::string::npos &&
+                    std::find(o.runtimes.begin(), o.runtimes.end(), library.second) == o.runtimes.end())
+                    o.runtimes.push_back(library.second);
+
+        std::ifstream status("/proc/self/status");
+        while (std::getline(status, line))
+            if (line.rfind("Threads:", 0) == 0)
+                o.threads = std::atoi(line.c_str() + 8);
+
+        cpu_set_t allowed;
+        sched_getaffinity(0, sizeof(allowed), &allowed);
+        o.cpus = CPU_COUNT(&allowed);
+
+        // Функции OpenMP ищутся в уже загруженных библиотеках: программа с OpenMP не связана
+        using LevelsFn = int (*)();
+        if (auto max_levels = (LevelsFn)dlsym(RTLD_DEFAULT, "omp_get_max_active_levels"))
+            o.levels = max_levels();
+        return o;
+    }
+
+    // Главный поток плюс один служебный допустимы сверх числа CPU
+    std::string problems() const {
+        std::vector<std::string> found;
+        int openmp = (int)runtimes.size() - (int)std::count(runtimes.begin(), runtimes.end(), "tbb");
+        if (openmp > 1) {
+            std::string list;
+            for (const std::string& r : runtimes)
+                if (r != "tbb")
+                    list += (list.empty() ? "" : "+") + r;
+            found.push_back("runtimes:" + list);
+        }
+        if (levels > 1)
+            found.push_back("nested:" + std::to_string(levels));
+        if (threads > cpus + 1)
+            found.push_back("threads:" + std::to_string(threads) + ">" + std::to_string(cpus));
+        std::string joined;
+        for (const std::string& f : found)
+            joined += (joined.empty() ? "" : ";") + f;
+        return joined.empty() ? "none" : joined;
+    }
+
+    std::string summary() const {
+        std::string list;
+        for (const std::string& r : runtimes)
+            list += (list.empty() ? "" : "+") + r;
+        return "runtimes:" + (list.empty() ? std::string("none") : list) + ",threads:" + std::to_string(threads) +
+               ",cpus:" + std::to_string(cpus) + ",levels:" + std::to_string(levels);
+    }
+};
+
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <matrix_size>" << std::endl;
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <matrix_size>|--input=path [--input-shape=RxC]"
+                  << " [--driver=gesdd|gesvd|gesvdx|gejsv|gesvj] [--vectors=full|thin|none] [--phases=1]"
+                  << " [--openblas=pthread|openmp|serial] [--trace=trace.json]" << std::endl;
         return 1;
     }
 
-    const int n = std::stoi(argv[1]);
+    int n;
+    int first = size_argument(argc, argv, n);
+
+    std::map<std::string, std::string> options;
+    InputMatrix A_orig;
+    try {
+        options = parse_options(argc, argv, first);
+        // Вариант OpenBLAS выбирается до чтения входа: при смене программа перезапускается
+        select_openblas_variant(option(options, "openblas", openblas_variant()), argv);
+        A_orig = load_input(options, "input", n);
+    } catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
     if (n <= 0) {
         std::cerr << "Matrix size must be positive" << std::endl;
         return 1;
     }
+    // С 32-битным lapack_int n*n элементов не адресуются при n > 46340: нужна сборка ILP64
+    if (sizeof(lapack_int) < 8 && (long long)n * n > std::numeric_limits<lapack_int>::max()) {
+        std::cerr << "Matrix size too large for 32-bit lapack_int: use the ILP64 build" << std::endl;
+        return 1;
+    }
+
+    std::string driver = option(options, "driver", "gesdd");
+    if (driver != "gesdd" && driver != "gesvd" && driver != "gesvdx" && driver != "gejsv" && driver != "gesvj") {
+        std::cerr << "Unknown --driver: " << driver << std::endl;
+        return 1;
+    }
+    std::string vectors_option = option(options, "vectors", "full");
+    std::map<std::string, char> jobs{{"full", 'A'}, {"thin", 'S'}, {"none", 'N'}};
+    if (!jobs.count(vectors_option)) {
+        std::cerr << "Unknown --vectors: " << vectors_option << std::endl;
+        return 1;
+    }
+    char vectors = jobs[vectors_option];
 
     int num_threads_blas = openblas_get_num_threads();
 
-    std::vector<double> A = create_spd_matrix(n, n);
-    std::vector<double> A_orig = A;  // копия для контрольной суммы
+    if (A_orig.size() == 0) {
+        memory.phase("generate");
+        A_orig = InputMatrix(create_spd_matrix(n, n), n, n);
+    }
+    memory.phase("copy");
+    std::vector<double> A(A_orig.begin(), A_orig.end());  // рабочая копия, исходная – для контрольной суммы
 
+    memory.phase("workspace");
     std::vector<double> S(n);
-    std::vector<double> U(n * n);
-    std::vector<double> VT(n * n);
-    std::vector<double> A_inv(n * n);  // результат выделен до таймера
+    std::vector<double> U((size_t)n * n);
+    std::vector<double> VT((size_t)n * n);
+    std::vector<double> A_inv((size_t)n * n);  // результат выделен до таймера
 
+    rapl.start();
     auto start = std::chrono::steady_clock::now();
 
     // SVD
-    called_routines.push_back("dgesdd");
-    int info = LAPACKE_dgesdd(LAPACK_ROW_MAJOR, 'A', n, n,
-                              A.data(), n, S.data(), U.data(), n,
-                              VT.data(), n);
+    called_routines.push_back("d" + driver);
+    rapl.phase("d" + driver);
+    memory.phase("d" + driver);
+    int info = run_svd(driver, vectors, n, A.data(), S.data(), U.data(), VT.data());
     if (info != 0) {
         std::cerr << "SVD failed: " << info << std::endl;
         return 1;
     }
+    std::vector<double> sigma(S);  // до замены обратными
 
-    // Инвертирование сингулярных чисел с отсечением
-    double max_sv = *std::max_element(S.begin(), S.end());
-    double threshold = max_sv * n * std::numeric_limits<double>::epsilon();
-    #pragma omp parallel for
-    for (int i = 0; i < n; ++i)
-        S[i] = (S[i] > threshold) ? 1.0 / S[i] : 0.0;
+    // Без векторов обратную не собрать: замер – только сингулярные числа
+    if (vectors != 'N') {
+        // Инвертирование сингулярных чисел с отсечением
+        double max_sv = *std::max_element(S.begin(), S.end());
+        double threshold = max_sv * n * std::numeric_limits<double>::epsilon();
+        for (int i = 0; i < n; ++i)
+            S[i] = (S[i] > threshold) ? 1.0 / S[i] : 0.0;
 
-    // Масштабирование строк VT
-    #pragma omp parallel for
-    for (int i = 0; i < n; ++i) {
-        for (int j = 0; j < n; ++j) {
-            VT[i * n + j] *= S[i];
-        }
-    }
+        // Масштабирование строк VT через BLAS, без своих потоков OpenMP
+        for (int i = 0; i < n; ++i)
+            cblas_dscal(n, S[i], VT.data() + (size_t)i * n, 1);
 
-    // сборка обратной матрицы
-    called_routines.push_back("dgemm");
-    cblas_dgemm(CblasRowMajor, CblasTrans, CblasTrans,
-                n, n, n,
-                1.0, VT.data(), n,
-                U.data(), n,
-                0.0, A_inv.data(), n);
+        // сборка обратной матрицы
+        called_routines.push_back("dgemm");
+        rapl.phase("dgemm");
+        memory.phase("dgemm");
+        cblas_dgemm(CblasRowMajor, CblasTrans, CblasTrans,
+                    n, n, n,
+                    1.0, VT.data(), n,
+                    U.data(), n,
+                    0.0, A_inv.data(), n);
+    }
 
     auto end = std::chrono::steady_clock::now();
+    rapl.stop();
+    memory.phase("verify");
     std::chrono::duration<double> total_duration = end - start;
 
     // Пиковое потребление памяти
     struct rusage usage;
     getrusage(RUSAGE_SELF, &usage);
     long rss_kb = usage.ru_maxrss;
+    Oversubscription oversubscription = Oversubscription::detect();
+
+    // Этапы SVD по отдельности (после замера RSS): схема dgesvd для --driver=gesvd,
+    // иначе dgesdd; у Якоби бидиагонализации нет, и этапы даны для сравнения
+    SvdPhases svd_stages;
+    double phases_diff = 0.0;
+    bool staged = (option(options, "phases", "0") == "1");
+    if (staged) {
+        memory.phase("phases");
+        info = svd_phases(driver == "gesvd", vectors != 'N', n, A_orig.data(), svd_stages);
+        if (info != 0) {
+            std::cerr << "SVD phases failed: " << info << std::endl;
+            return 1;
+        }
+        std::vector<double> sorted(sigma.begin(), sigma.end());
+        std::sort(sorted.rbegin(), sorted.rend());
+        for (int i = 0; i < n; ++i)
+            phases_diff = std::max(phases_diff, std::abs(svd_stages.S[i] - sorted[i]));
+        phases_diff /= sorted[0];
+    }
+
+    double residual = (vectors != 'N') ? probe_residual(A_orig.data(), A_inv.data(), n) : 0.0;
 
     // Контрольная сумма исходной матрицы
     double checksum = 0.0;
@@ -115,9 +1431,43 @@ int main(int argc, char* argv[]) {
     std::cout << std::fixed << std::setprecision(9);
     std::cout << "RESULT_SECONDS=" << total_duration.count() << std::endl;
     std::cout << "DIAG_THREADS=openblas/libopenblas:" << num_threads_blas << std::endl;
+    std::cout << "DIAG_THREADING=" << openblas_variant() << "," << oversubscription.summary() << std::endl;
+    std::cout << "DIAG_OVERSUBSCRIPTION=" << oversubscription.problems() << std::endl;
+    std::cout << "DIAG_INDEX=" << (sizeof(lapack_int) == 8 ? "ilp64" : "lp64") << std::endl;
     std::cout << "DIAG_PEAK_RSS_KB=" << rss_kb << std::endl;
     std::cout << "DIAG_ROUTINES=" << routines_oss.str() << std::endl;
-    std::cout << std::setprecision(6);
+    if (A_orig.format != "synthetic")
+        A_orig.report();
+    std::cout << "DIAG_SVD=" << driver << ":" << vectors_option << std::endl;
+    if (staged) {
+        std::cout << "DIAG_SVD_PHASES=pipeline:" << svd_stages.pipeline;
+        double staged_total = 0.0;
+        for (const auto& stage : svd_stages.seconds) {
+            std::cout << "," << stage.first << ":" << stage.second;
+            staged_total += stage.second;
+        }
+        std::cout << ",total:" << staged_total << std::endl;
+    }
+    std::cout << std::scientific << std::setprecision(6);
+    std::cout << "DIAG_SIGMA=max:" << *std::max_element(sigma.begin(), sigma.end())
+              << ",min:" << *std::min_element(sigma.begin(), sigma.end()) << std::endl;
+    if (vectors != 'N')
+        std::cout << "DIAG_RESIDUAL=" << residual << std::endl;
+    if (staged)
+        std::cout << "DIAG_SVD_PHASES_DIFF=" << phases_diff << std::endl;
+    std::cout << std::fixed;
+    // Номинальное число операций SVD с векторами (~21n^3) и сборки обратной dgemm (2n^3);
+    // без векторов – бидиагонализация (8n^3/3)
+    rapl.report((vectors != 'N' ? 23.0 : 8.0 / 3.0) * n * n * n / 1e9);
+    memory.report();
+    if (trace::enabled()) {
+        std::string summary = trace::write();
+        if (summary.empty()) {
+            std::cerr << "Cannot write trace: " << trace::path() << std::endl;
+            return 1;
+        }
+        std::cout << "DIAG_TRACE=" << summary << std::endl;
+    }
     std::cout << "DIAG_CHECKSUM=" << checksum << std::endl;
 
     return 0;
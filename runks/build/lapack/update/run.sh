@@ -0,0 +1,41 @@
+#!/bin/bash
+
+# Список контейнеров
+containers=(
+	"lapack_update"
+)
+
+# Ранги изменений
+ranks=(1 8 32)
+
+# Размеры матриц
+sizes=(2500 5000 7500 10000 12500 15000 17500 20000)
+
+# Количество запусков для каждого контейнера и размера
+runs=10
+
+# Запуск контейнеров
+for container in "${containers[@]}"; do
+    for rank in "${ranks[@]}"; do
+        for size in "${sizes[@]}"; do
+            # Создаем файл для вывода для текущего контейнера, ранга и размера
+            output_file="${container}_rank_${rank}_size_${size}.txt"
+
+            for ((i=1; i<=runs; i++)); do
+                echo "Запуск контейнера $container (ранг $rank) с размером матрицы $size, запуск номер $i..."
+
+                container_id=$(docker run -d --rm "$container" "$size" --rank="$rank")
+
+                # Ожидаем завершения контейнера и записываем его вывод в файл
+                docker logs -f "$container_id" >> "$output_file"
+
+                # Ждем завершения контейнера
+                docker wait "$container_id"
+
+                echo "Вывод контейнера $container (ранг $rank) с размером матрицы $size, запуск номер $i добавлен в $output_file"
+            done
+        done
+    done
+done
+
+cd ../
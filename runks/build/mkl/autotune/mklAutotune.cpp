@@ -0,0 +1,654 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <map>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <cmath>
+#include <cstdlib>
+#include <mkl.h>
+#include <sys/resource.h>
+
+// Автонастраиваемое обращение: алгоритм, число потоков и размер блока
+// выбираются по таблице, измеренной на текущей машине (режим tune).
+std::vector<std::string> called_routines;
+
+enum class Algorithm { Cholesky, LU, GaussJordan, Spectral };
+
+struct InvertConfig {
+    Algorithm algorithm;
+    int threads;
+    int block;   // 0 – алгоритм не блочный
+};
+
+const char* algorithm_name(Algorithm algorithm) {
+    switch (algorithm) {
+        case Algorithm::Cholesky:    return "potrf";
+        case Algorithm::LU:          return "getrf";
+        case Algorithm::GaussJordan: return "gauss_jordan";
+        case Algorithm::Spectral:    return "spectral";
+    }
+    return "unknown";
+}
+
+bool parse_algorithm(const std::string& name, Algorithm& algorithm) {
+    for (Algorithm a : {Algorithm::Cholesky, Algorithm::LU, Algorithm::GaussJordan, Algorithm::Spectral}) {
+        if (name == algorithm_name(a)) {
+            algorithm = a;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Алгоритмы, допустимые для свойства матрицы: Холецкий только для SPD
+std::vector<Algorithm> algorithms_for(const std::string& property) {
+    if (property == "spd")
+        return {Algorithm::Cholesky, Algorithm::LU, Algorithm::GaussJordan, Algorithm::Spectral};
+    return {Algorithm::LU, Algorithm::GaussJordan, Algorithm::Spectral};
+}
+
+std::vector<double> create_positive_definite_matrix(int n, int seed) {
+    std::vector<double> matrix((size_t)n * n);
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<> dis(0.0, 1.0);
+
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < n; ++j)
+            matrix[(size_t)i * n + j] = dis(gen);
+
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < i; ++j) {
+            double avg = (matrix[(size_t)i * n + j] + matrix[(size_t)j * n + i]) / 2.0;
+            matrix[(size_t)i * n + j] = matrix[(size_t)j * n + i] = avg;
+        }
+    }
+    for (int i = 0; i < n; ++i)
+        matrix[(size_t)i * n + i] += n;
+
+    return matrix;
+}
+
+// Несимметричная матрица со строгим диагональным преобладанием
+std::vector<double> create_general_matrix(int n, int seed) {
+    std::vector<double> matrix((size_t)n * n);
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<> dis(0.0, 1.0);
+
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < n; ++j)
+            matrix[(size_t)i * n + j] = dis(gen);
+
+    for (int i = 0; i < n; ++i)
+        matrix[(size_t)i * n + i] += n;
+
+    return matrix;
+}
+
+std::vector<double> create_matrix(const std::string& property, int n, int seed) {
+    if (property == "spd")
+        return create_positive_definite_matrix(n, seed);
+    return create_general_matrix(n, seed);
+}
+
+int cholesky_invert(double* A, int n) {
+    called_routines.push_back("dpotrf");
+    int info = LAPACKE_dpotrf(LAPACK_ROW_MAJOR, 'L', n, A, n);
+    if (info != 0)
+        return info;
+
+    called_routines.push_back("dpotri");
+    info = LAPACKE_dpotri(LAPACK_ROW_MAJOR, 'L', n, A, n);
+    if (info != 0)
+        return info;
+
+    for (int i = 0; i < n; ++i)
+        for (int j = i + 1; j < n; ++j)
+            A[(size_t)i * n + j] = A[(size_t)j * n + i];
+    return 0;
+}
+
+int lu_invert(double* A, int n) {
+    std::vector<lapack_int> ipiv(n);
+
+    called_routines.push_back("dgetrf");
+    int info = LAPACKE_dgetrf(LAPACK_ROW_MAJOR, n, n, A, n, ipiv.data());
+    if (info != 0)
+        return info;
+
+    called_routines.push_back("dgetri");
+    return LAPACKE_dgetri(LAPACK_ROW_MAJOR, n, A, n, ipiv.data());
+}
+
+// Блочный метод Гаусса-Жордана на месте, без выбора ведущего элемента
+// (генераторы дают матрицы с диагональным преобладанием).
+// На шаге k с ведущим блоком P = A_kk:
+//   A_ij -= A_ik P^{-1} A_kj,  A_kj = P^{-1} A_kj,  A_ik = -A_ik P^{-1},  A_kk = P^{-1}
+// Вся работа, кроме обращения P, сводится к dgemm ранга block.
+int gauss_jordan_invert(double* A, int n, int block) {
+    called_routines.push_back("dgetrf");
+    called_routines.push_back("dgetri");
+    called_routines.push_back("dgemm");
+
+    std::vector<double> pivot(block * block);
+    std::vector<double> row((size_t)block * n);
+    std::vector<double> col((size_t)n * block);
+    std::vector<lapack_int> ipiv(block);
+
+    for (int k = 0; k < n; k += block) {
+        int b = std::min(block, n - k);
+
+        for (int i = 0; i < b; ++i)
+            for (int j = 0; j < b; ++j)
+                pivot[i * b + j] = A[(size_t)(k + i) * n + k + j];
+
+        int info = LAPACKE_dgetrf(LAPACK_ROW_MAJOR, b, b, pivot.data(), b, ipiv.data());
+        if (info == 0)
+            info = LAPACKE_dgetri(LAPACK_ROW_MAJOR, b, pivot.data(), b, ipiv.data());
+        if (info != 0)
+            return k + std::abs(info);
+
+        // row = P^{-1} A_k*,  col = A_*k
+        cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+                    b, n, b,
+                    1.0, pivot.data(), b,
+                    A + (size_t)k * n, n,
+                    0.0, row.data(), n);
+        for (int i = 0; i < n; ++i)
+            for (int j = 0; j < b; ++j)
+                col[(size_t)i * b + j] = A[(size_t)i * n + k + j];
+
+        cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+                    n, n, b,
+                    -1.0, col.data(), b,
+                    row.data(), n,
+                    1.0, A, n);
+
+        std::copy(row.begin(), row.begin() + (size_t)b * n, A + (size_t)k * n);
+        cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+                    n, b, b,
+                    -1.0, col.data(), b,
+                    pivot.data(), b,
+                    0.0, A + k, n);
+        for (int i = 0; i < b; ++i)
+            for (int j = 0; j < b; ++j)
+                A[(size_t)(k + i) * n + k + j] = pivot[i * b + j];
+    }
+    return 0;
+}
+
+// Спектральное обращение: A = Q diag(w) Q^T для SPD и A = U S V^T в общем случае.
+// Малые собственные/сингулярные числа отсекаются, как в программах SVD.
+int spectral_invert(double* A, int n, bool symmetric) {
+    std::vector<double> w(n);
+    std::vector<double> scaled((size_t)n * n);
+
+    if (symmetric) {
+        called_routines.push_back("dsyevd");
+        int info = LAPACKE_dsyevd(LAPACK_ROW_MAJOR, 'V', 'L', n, A, n, w.data());
+        if (info != 0)
+            return info;
+
+        double max_w = *std::max_element(w.begin(), w.end());
+        double threshold = max_w * n * std::numeric_limits<double>::epsilon();
+        for (int j = 0; j < n; ++j)
+            w[j] = (w[j] > threshold) ? 1.0 / w[j] : 0.0;
+
+        for (int i = 0; i < n; ++i)
+            for (int j = 0; j < n; ++j)
+                scaled[(size_t)i * n + j] = A[(size_t)i * n + j] * w[j];
+
+        std::vector<double> Q(A, A + (size_t)n * n);
+        called_routines.push_back("dgemm");
+        cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasTrans,
+                    n, n, n,
+                    1.0, scaled.data(), n,
+                    Q.data(), n,
+                    0.0, A, n);
+        return 0;
+    }
+
+    std::vector<double> U((size_t)n * n);
+    called_routines.push_back("dgesdd");
+    int info = LAPACKE_dgesdd(LAPACK_ROW_MAJOR, 'A', n, n,
+                              A, n, w.data(), U.data(), n, scaled.data(), n);
+    if (info != 0)
+        return info;
+
+    double max_sv = *std::max_element(w.begin(), w.end());
+    double threshold = max_sv * n * std::numeric_limits<double>::epsilon();
+    for (int i = 0; i < n; ++i) {
+        double s_inv = (w[i] > threshold) ? 1.0 / w[i] : 0.0;
+        for (int j = 0; j < n; ++j)
+            scaled[(size_t)i * n + j] *= s_inv;
+    }
+
+    called_routines.push_back("dgemm");
+    cblas_dgemm(CblasRowMajor, CblasTrans, CblasTrans,
+                n, n, n,
+                1.0, scaled.data(), n,
+                U.data(), n,
+                0.0, A, n);
+    return 0;
+}
+
+// Невязка ||A (X v) - v|| / (||A||_F ||X||_F ||v||) на случайном векторе v за O(n^2)
+// вместо полного произведения A X
+double probe_residual(const double* A, const double* X, int n) {
+    std::mt19937 gen(n + 2);
+    std::uniform_real_distribution<> dis(-1.0, 1.0);
+    std::vector<double> v(n), Xv(n), r(n);
+    for (double& x : v)
+        x = dis(gen);
+
+    cblas_dgemv(CblasRowMajor, CblasNoTrans, n, n, 1.0, X, n, v.data(), 1, 0.0, Xv.data(), 1);
+    r = v;
+    cblas_dgemv(CblasRowMajor, CblasNoTrans, n, n, 1.0, A, n, Xv.data(), 1, -1.0, r.data(), 1);
+
+    double norm_A = cblas_dnrm2((size_t)n * n, A, 1);
+    double norm_X = cblas_dnrm2((size_t)n * n, X, 1);
+    return cblas_dnrm2(n, r.data(), 1) / (norm_A * norm_X * cblas_dnrm2(n, v.data(), 1));
+}
+
+int invert_with_config(double* A, int n, const std::string& property, const InvertConfig& config) {
+    mkl_set_num_threads(config.threads);
+    switch (config.algorithm) {
+        case Algorithm::Cholesky:    return cholesky_invert(A, n);
+        case Algorithm::LU:          return lu_invert(A, n);
+        case Algorithm::GaussJordan: return gauss_jordan_invert(A, n, config.block);
+        case Algorithm::Spectral:    return spectral_invert(A, n, property == "spd");
+    }
+    return -1;
+}
+
+// Измерения одной конфигурации по размерам матрицы
+struct TuningCurve {
+    std::string property;
+    InvertConfig config;
+    std::vector<std::pair<int, double>> points;   // (n, секунды), по возрастанию n
+
+    // Оценка времени для n: интерполяция в координатах log n – log t между
+    // соседними измеренными размерами, за пределами таблицы – масштабирование n^3.
+    double estimate(int n) const {
+        auto upper = std::lower_bound(points.begin(), points.end(), n,
+                                      [](const std::pair<int, double>& p, int value) { return p.first < value; });
+        if (upper != points.end() && upper->first == n)
+            return upper->second;
+        if (upper == points.begin() || upper == points.end()) {
+            const auto& edge = (upper == points.end()) ? points.back() : points.front();
+            return edge.second * std::pow(double(n) / edge.first, 3.0);
+        }
+        auto lower = upper - 1;
+        double slope = std::log(upper->second / lower->second) / std::log(double(upper->first) / lower->first);
+        return lower->second * std::pow(double(n) / lower->first, slope);
+    }
+};
+
+class TuningTable {
+public:
+    std::string host;
+
+    void add(const std::string& property, const InvertConfig& config, int n, double seconds) {
+        for (TuningCurve& curve : curves_[property]) {
+            if (curve.config.algorithm == config.algorithm &&
+                curve.config.threads == config.threads &&
+                curve.config.block == config.block) {
+                auto it = std::lower_bound(curve.points.begin(), curve.points.end(), std::make_pair(n, 0.0));
+                curve.points.insert(it, {n, seconds});
+                return;
+            }
+        }
+        curves_[property].push_back({property, config, {{n, seconds}}});
+    }
+
+    bool empty() const { return curves_.empty(); }
+
+    bool load(const std::string& path) {
+        std::ifstream in(path);
+        if (!in)
+            return false;
+
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.rfind("# host=", 0) == 0) {
+                host = line.substr(7);
+                continue;
+            }
+            if (line.empty() || line[0] == '#')
+                continue;
+
+            std::istringstream fields(line);
+            std::string property, name;
+            int n, threads, block;
+            double seconds;
+            Algorithm algorithm;
+            if (!(fields >> property >> n >> name >> threads >> block >> seconds) ||
+                !parse_algorithm(name, algorithm) || n <= 0 || threads <= 0 || block <= 0) {
+                std::cerr << "Skipping malformed tuning table line: " << line << std::endl;
+                continue;
+            }
+            add(property, {algorithm, threads, block}, n, seconds);
+        }
+        return !empty();
+    }
+
+    bool save(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out)
+            return false;
+
+        out << "# host=" << host << "\n";
+        out << "# property n algorithm threads block seconds\n";
+        out << std::scientific << std::setprecision(6);
+        for (const auto& entry : curves_)
+            for (const TuningCurve& curve : entry.second)
+                for (const auto& point : curve.points)
+                    out << entry.first << ' ' << point.first << ' '
+                        << algorithm_name(curve.config.algorithm) << ' '
+                        << curve.config.threads << ' ' << curve.config.block << ' '
+                        << point.second << "\n";
+        return bool(out);
+    }
+
+    // Самая быстрая конфигурация для n; false, если свойство не настраивалось.
+    // Сравниваются только кривые, измеренные на размере n (после приведения n к
+    // диапазону таблицы): отсеянная на малых размерах конфигурация иначе
+    // экстраполировалась бы n^3 и могла выиграть у реально измеренных
+    bool lookup(int n, const std::string& property, InvertConfig& best) const {
+        auto it = curves_.find(property);
+        if (it == curves_.end() || it->second.empty())
+            return false;
+
+        int smallest = std::numeric_limits<int>::max(), largest = 0;
+        for (const TuningCurve& curve : it->second) {
+            smallest = std::min(smallest, curve.points.front().first);
+            largest = std::max(largest, curve.points.back().first);
+        }
+        int covered = std::min(std::max(n, smallest), largest);
+
+        double best_seconds = std::numeric_limits<double>::infinity();
+        for (const TuningCurve& curve : it->second) {
+            if (curve.points.front().first > covered || curve.points.back().first < covered)
+                continue;
+            double seconds = curve.estimate(n);
+            if (seconds < best_seconds) {
+                best_seconds = seconds;
+                best = curve.config;
+            }
+        }
+        return true;
+    }
+
+private:
+    std::map<std::string, std::vector<TuningCurve>> curves_;
+};
+
+// Точка входа: выбирает конфигурацию по таблице и обращает A на месте
+int invert(double* A, int n, const std::string& property, const TuningTable& table, InvertConfig* used = nullptr) {
+    InvertConfig config;
+    if (!table.lookup(n, property, config)) {
+        // Без таблицы – поведение остальных программ набора
+        config = {property == "spd" ? Algorithm::Cholesky : Algorithm::LU, mkl_get_max_threads(), 0};
+    }
+    if (used)
+        *used = config;
+    return invert_with_config(A, n, property, config);
+}
+
+std::string cpu_model() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.rfind("model name", 0) == 0) {
+            size_t colon = line.find(':');
+            if (colon != std::string::npos && colon + 2 <= line.size())
+                return line.substr(colon + 2);
+        }
+    }
+    return "unknown";
+}
+
+// Необязательные параметры вида --key=value
+std::map<std::string, std::string> parse_options(int argc, char* argv[], int first) {
+    std::map<std::string, std::string> options;
+    for (int i = first; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+            throw std::invalid_argument("Unknown argument: " + arg);
+        options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+    }
+    return options;
+}
+
+std::string option(const std::map<std::string, std::string>& options,
+                   const std::string& key, const std::string& fallback) {
+    auto it = options.find(key);
+    return it == options.end() ? fallback : it->second;
+}
+
+std::vector<std::string> split(const std::string& list) {
+    std::vector<std::string> items;
+    std::istringstream iss(list);
+    std::string item;
+    while (std::getline(iss, item, ','))
+        if (!item.empty())
+            items.push_back(item);
+    return items;
+}
+
+// Списки размеров, потоков и блоков: нулевой блок зациклил бы обращение
+std::vector<int> split_ints(const std::string& list, const std::string& name) {
+    std::vector<int> values;
+    for (const std::string& item : split(list)) {
+        values.push_back(std::stoi(item));
+        if (values.back() <= 0)
+            throw std::invalid_argument("--" + name + " values must be positive: " + item);
+    }
+    return values;
+}
+
+std::string default_thread_list(int max_threads) {
+    std::ostringstream oss;
+    for (int t = 1; t < max_threads; t *= 2)
+        oss << t << ',';
+    oss << max_threads;
+    return oss.str();
+}
+
+// Офлайн-настройка: перебор конфигураций по размерам, лучшее из repeats запусков.
+// Конфигурации, которые на предыдущем размере были медленнее лучшей более чем
+// в prune раз, на больших размерах не измеряются. Результат каждой конфигурации
+// проверяется невязкой: неточная конфигурация в таблицу не попадает.
+int tune(const std::map<std::string, std::string>& options) {
+    int max_threads = mkl_get_max_threads();
+    std::string table_path = option(options, "table", "tuning_table.txt");
+    std::vector<std::string> properties = split(option(options, "properties", "spd,general"));
+    std::vector<int> sizes, thread_counts, blocks;
+    int repeats;
+    try {
+        sizes = split_ints(option(options, "sizes", "1000,2500,5000,7500,10000"), "sizes");
+        thread_counts = split_ints(option(options, "threads", default_thread_list(max_threads)), "threads");
+        blocks = split_ints(option(options, "blocks", "128,256,512"), "blocks");
+        repeats = std::stoi(option(options, "repeats", "3"));
+        if (repeats <= 0)
+            throw std::invalid_argument("--repeats must be positive");
+    } catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    double prune = std::stod(option(options, "prune", "3.0"));
+    double tolerance = std::stod(option(options, "tolerance", "1e-10"));
+    std::sort(sizes.begin(), sizes.end());
+    if (!sizes.empty() && sizeof(MKL_INT) < 8 &&
+        (long long)sizes.back() * sizes.back() > std::numeric_limits<MKL_INT>::max()) {
+        std::cerr << "Matrix size too large for 32-bit MKL_INT: " << sizes.back() << std::endl;
+        return 1;
+    }
+
+    TuningTable table;
+    table.host = cpu_model();
+
+    for (const std::string& property : properties) {
+        std::vector<InvertConfig> candidates;
+        for (Algorithm algorithm : algorithms_for(property))
+            for (int threads : thread_counts) {
+                if (algorithm != Algorithm::GaussJordan) {
+                    candidates.push_back({algorithm, threads, 0});
+                    continue;
+                }
+                for (int block : blocks)
+                    candidates.push_back({algorithm, threads, block});
+            }
+
+        for (int n : sizes) {
+            std::vector<double> matrix = create_matrix(property, n, n);
+            std::vector<double> work((size_t)n * n);
+            std::vector<InvertConfig> survivors;
+            std::vector<double> timings;
+
+            for (const InvertConfig& config : candidates) {
+                double best = std::numeric_limits<double>::infinity();
+                for (int r = 0; r < repeats; ++r) {
+                    std::copy(matrix.begin(), matrix.end(), work.begin());
+                    auto start = std::chrono::steady_clock::now();
+                    int info = invert_with_config(work.data(), n, property, config);
+                    auto end = std::chrono::steady_clock::now();
+                    called_routines.clear();
+                    if (info != 0) {
+                        best = std::numeric_limits<double>::infinity();
+                        break;
+                    }
+                    best = std::min(best, std::chrono::duration<double>(end - start).count());
+                }
+                if (!std::isfinite(best))
+                    continue;
+                double residual = probe_residual(matrix.data(), work.data(), n);
+                if (!(residual <= tolerance)) {
+                    std::cout << "TUNE " << property << " n=" << n << ' '
+                              << algorithm_name(config.algorithm) << ':' << config.threads << ':' << config.block
+                              << " rejected, residual " << residual << std::endl;
+                    continue;
+                }
+
+                table.add(property, config, n, best);
+                survivors.push_back(config);
+                timings.push_back(best);
+                std::cout << "TUNE " << property << " n=" << n << ' '
+                          << algorithm_name(config.algorithm) << ':' << config.threads << ':' << config.block
+                          << ' ' << best << std::endl;
+            }
+            if (timings.empty())
+                break;
+
+            double fastest = *std::min_element(timings.begin(), timings.end());
+            candidates.clear();
+            for (size_t i = 0; i < survivors.size(); ++i)
+                if (timings[i] <= prune * fastest)
+                    candidates.push_back(survivors[i]);
+        }
+    }
+
+    if (!table.save(table_path)) {
+        std::cerr << "Cannot write tuning table: " << table_path << std::endl;
+        return 1;
+    }
+    std::cout << "Tuning table written to " << table_path << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <matrix_size> [--table=path] [--property=spd|general]" << std::endl;
+        std::cerr << "       " << argv[0] << " tune [--table=path] [--properties=spd,general] [--sizes=...]"
+                  << " [--threads=...] [--blocks=...] [--repeats=3] [--prune=3.0] [--tolerance=1e-10]" << std::endl;
+        return 1;
+    }
+
+    std::map<std::string, std::string> options;
+    try {
+        options = parse_options(argc, argv, 2);
+    } catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    if (std::string(argv[1]) == "tune")
+        return tune(options);
+
+    int n = std::atoi(argv[1]);
+    if (n <= 0) {
+        std::cerr << "Matrix size must be positive" << std::endl;
+        return 1;
+    }
+    // С 32-битным MKL_INT n*n элементов не адресуются при n > 46340
+    if (sizeof(MKL_INT) < 8 && (long long)n * n > std::numeric_limits<MKL_INT>::max()) {
+        std::cerr << "Matrix size too large for 32-bit MKL_INT (n > 46340)" << std::endl;
+        return 1;
+    }
+
+    std::string property = option(options, "property", "spd");
+    if (property != "spd" && property != "general") {
+        std::cerr << "Unknown matrix property: " << property << std::endl;
+        return 1;
+    }
+
+    // Таблица читается один раз до таймера; выбор внутри invert() – это
+    // проход по нескольким десяткам кривых без обращения к файлу
+    std::string table_path = option(options, "table", "tuning_table.txt");
+    TuningTable table;
+    if (!table.load(table_path))
+        std::cerr << "Tuning table " << table_path << " not found, using default configuration" << std::endl;
+    else if (table.host != cpu_model())
+        std::cerr << "Warning: tuning table was measured on '" << table.host << "'" << std::endl;
+
+    std::vector<double> matrix = create_matrix(property, n, n);
+    std::vector<double> inverse_matrix = matrix;
+
+    InvertConfig used;
+    auto start = std::chrono::steady_clock::now();
+    int info = invert(inverse_matrix.data(), n, property, table, &used);
+    auto end = std::chrono::steady_clock::now();
+    std::chrono::duration<double> diff = end - start;
+
+    if (info != 0) {
+        std::cerr << "Matrix inversion (" << algorithm_name(used.algorithm) << ") failed with code: " << info << std::endl;
+        return 1;
+    }
+
+    double residual = probe_residual(matrix.data(), inverse_matrix.data(), n);
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    long rss_kb = usage.ru_maxrss;
+
+    double checksum = 0.0;
+    for (double v : matrix)
+        checksum += v;
+
+    std::ostringstream routines_oss;
+    for (size_t i = 0; i < called_routines.size(); ++i) {
+        if (i) routines_oss << ',';
+        routines_oss << called_routines[i];
+    }
+
+    std::cout << std::fixed << std::setprecision(9);
+    std::cout << "RESULT_SECONDS=" << diff.count() << std::endl;
+    std::cout << "DIAG_THREADS=mkl/libmkl_rt:" << used.threads << std::endl;
+    std::cout << "DIAG_PEAK_RSS_KB=" << rss_kb << std::endl;
+    std::cout << "DIAG_ROUTINES=" << routines_oss.str() << std::endl;
+    std::cout << "DIAG_CONFIG=" << algorithm_name(used.algorithm) << ':' << used.threads << ':' << used.block << std::endl;
+    std::cout << "DIAG_INDEX=" << (sizeof(MKL_INT) == 8 ? "ilp64" : "lp64") << std::endl;
+    std::cout << std::setprecision(6);
+    std::cout << "DIAG_CHECKSUM=" << checksum << std::endl;
+    std::cout << std::scientific;
+    std::cout << "DIAG_RESIDUAL=" << residual << std::endl;
+
+    return 0;
+}
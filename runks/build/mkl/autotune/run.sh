@@ -0,0 +1,47 @@
+#!/bin/bash
+
+# Список контейнеров
+containers=(
+	"mkl_autotune"
+)
+
+# Размеры матриц
+sizes=(2500 5000 7500 10000 12500 15000 17500 20000)
+
+# Количество запусков для каждого контейнера и размера
+runs=10
+
+# Таблицы настройки хранятся на хосте: у каждой машины своя таблица
+tuning_dir="$(pwd)/tuning"
+mkdir -p "$tuning_dir"
+
+for container in "${containers[@]}"; do
+    table="tuning/${container}.txt"
+
+    # Офлайн-настройка выполняется один раз на машину
+    if [ ! -f "$tuning_dir/${container}.txt" ]; then
+        echo "Настройка $container на этой машине..."
+        docker run --rm -v "$tuning_dir:/usr/share/mkl/tuning" "$container" tune --table="$table"
+    fi
+
+    for size in "${sizes[@]}"; do
+        # Создаем файл для вывода для текущего контейнера и размера
+        output_file="${container}_size_${size}.txt"
+
+        for ((i=1; i<=runs; i++)); do
+            echo "Запуск контейнера $container с размером матрицы $size, запуск номер $i..."
+
+            container_id=$(docker run -d --rm -v "$tuning_dir:/usr/share/mkl/tuning" "$container" "$size" --table="$table")
+
+            # Ожидаем завершения контейнера и записываем его вывод в файл
+            docker logs -f "$container_id" >> "$output_file"
+
+            # Ждем завершения контейнера
+            docker wait "$container_id"
+
+            echo "Вывод контейнера $container с размером матрицы $size, запуск номер $i добавлен в $output_file"
+        done
+    done
+done
+
+cd ../
@@ -19,6 +19,8 @@ build_container() {
 
 
 build_container "mkl_chol" "Dockerfile.mklcho"
+# 64-битные индексы для n > 46340
+build_container "mkl_chol_ilp64" "Dockerfile.mklcho_ilp64"
 
 
 cd ../
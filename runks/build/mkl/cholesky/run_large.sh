@@ -0,0 +1,39 @@
+#!/bin/bash
+
+# Большие n на узлах с большой памятью: только сборка ILP64 (при LP64 n*n > 2^31 - 1
+# не адресуется). Матрица 80000 x 80000 занимает 51 ГБ, программе нужно 2-3 таких
+container="mkl_chol_ilp64"
+
+# Размеры матриц
+sizes=(50000 65000 80000)
+
+# Запуски долгие: по 3 на размер
+runs=3
+
+# Порог нормированной невязки DIAG_RESIDUAL
+threshold=1e-10
+
+failed=0
+for size in "${sizes[@]}"; do
+    output_file="${container}_size_${size}.txt"
+
+    for ((i=1; i<=runs; i++)); do
+        echo "Запуск контейнера $container с размером матрицы $size, запуск номер $i..."
+
+        run_output=$(docker run --rm "$container" "$size")
+        echo "$run_output" >> "$output_file"
+
+        # Результат проверяется в каждом запуске: индексы 64-битные и невязка мала
+        if ! echo "$run_output" | awk -F= -v limit="$threshold" '
+                $1 == "DIAG_INDEX" { index64 = ($2 == "ilp64") }
+                $1 == "DIAG_RESIDUAL" { seen = 1; ok = ($2 + 0 < limit + 0) }
+                END { exit !(index64 && seen && ok) }'; then
+            echo "Проверка не пройдена: $container, размер $size, запуск $i"
+            failed=1
+        fi
+
+        echo "Вывод контейнера $container с размером матрицы $size, запуск номер $i добавлен в $output_file"
+    done
+done
+
+exit $failed
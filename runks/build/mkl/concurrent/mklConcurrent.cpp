@@ -0,0 +1,456 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <mkl.h>
+#include <sys/resource.h>
+#include <sched.h>
+#include <pthread.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <sstream>
+#include <map>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <cmath>
+#include <fstream>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <cctype>
+// P одновременных независимых задач, каждая на своём непересекающемся наборе ядер
+std::vector<std::string> called_routines;
+
+// Слой потоков MKL (mkl_rt) задаётся до первого вызова MKL, то есть раньше
+// разбора параметров: --threading ищется прямо в /proc/self/cmdline, затем
+// берётся MKL_THREADING_LAYER; по умолчанию intel
+struct ThreadingLayer {
+    std::string requested = "intel";
+    std::string actual = "unknown";
+    std::string error;
+
+    ThreadingLayer() {
+        if (const char* env = std::getenv("MKL_THREADING_LAYER")) {
+            requested = env;
+            std::transform(requested.begin(), requested.end(), requested.begin(),
+                           [](unsigned char c) { return (char)std::tolower(c); });
+        }
+        std::ifstream cmdline("/proc/self/cmdline");
+        std::string arg;
+        while (std::getline(cmdline, arg, '\0'))
+            if (arg.rfind("--threading=", 0) == 0)
+                requested = arg.substr(12);
+
+        static const std::map<std::string, int> layers = {
+            {"intel", MKL_THREADING_INTEL}, {"gnu", MKL_THREADING_GNU},
+            {"tbb", MKL_THREADING_TBB}, {"sequential", MKL_THREADING_SEQUENTIAL}};
+        auto it = layers.find(requested);
+        if (it == layers.end()) {
+            error = "Unknown --threading: " + requested;
+            return;
+        }
+        // Возвращается слой, который действует: после инициализации MKL он уже не меняется
+        int code = mkl_set_threading_layer(it->second);
+        for (const auto& layer : layers)
+            if (layer.second == code)
+                actual = layer.first;
+    }
+
+    std::string label() const {
+        return requested + "->" + actual;
+    }
+};
+
+ThreadingLayer threading;
+
+std::vector<double> create_positive_definite_matrix(int n, int seed) {
+    std::vector<double> matrix((size_t)n * n);
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<> dis(0.0, 1.0);
+
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < n; ++j)
+            matrix[(size_t)i * n + j] = dis(gen);
+
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < i; ++j) {
+            double avg = (matrix[(size_t)i * n + j] + matrix[(size_t)j * n + i]) / 2.0;
+            matrix[(size_t)i * n + j] = matrix[(size_t)j * n + i] = avg;
+        }
+    }
+    for (int i = 0; i < n; ++i)
+        matrix[(size_t)i * n + i] += n;
+
+    return matrix;
+}
+
+// Необязательные параметры вида --key=value
+std::map<std::string, std::string> parse_options(int argc, char* argv[], int first) {
+    std::map<std::string, std::string> options;
+    for (int i = first; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+            throw std::invalid_argument("Unknown argument: " + arg);
+        options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+    }
+    return options;
+}
+
+std::string option(const std::map<std::string, std::string>& options,
+                   const std::string& key, const std::string& fallback) {
+    auto it = options.find(key);
+    return it == options.end() ? fallback : it->second;
+}
+
+// Рабочие буферы одной задачи; выделяются до замера
+struct Workspace {
+    int n;
+    std::vector<double> A, B, work, S, U, VT, result;
+    std::vector<lapack_int> ipiv;
+
+    Workspace(int n, int seed, const std::string& op)
+        : n(n), A(create_positive_definite_matrix(n, seed)), work((size_t)n * n) {
+        if (op == "lu")
+            ipiv.resize(n);
+        if (op == "gemm") {
+            B = create_positive_definite_matrix(n, seed + 1);
+            result.resize((size_t)n * n);
+        }
+        if (op == "svd") {
+            S.resize(n);
+            U.resize((size_t)n * n);
+            VT.resize((size_t)n * n);
+            result.resize((size_t)n * n);
+        }
+    }
+};
+
+// Одна операция так же, как в основных программах
+int run_op(Workspace& ws, const std::string& op) {
+    int n = ws.n;
+    if (op == "gemm") {
+        cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, n, n, n, 1.0, ws.A.data(), n,
+                    ws.B.data(), n, 0.0, ws.result.data(), n);
+        return 0;
+    }
+
+    std::copy(ws.A.begin(), ws.A.end(), ws.work.begin());
+    if (op == "cholesky") {
+        int info = LAPACKE_dpotrf(LAPACK_ROW_MAJOR, 'L', n, ws.work.data(), n);
+        if (info == 0)
+            info = LAPACKE_dpotri(LAPACK_ROW_MAJOR, 'L', n, ws.work.data(), n);
+        if (info != 0)
+            return info;
+        for (int i = 0; i < n; ++i)
+            for (int j = i + 1; j < n; ++j)
+                ws.work[(size_t)i * n + j] = ws.work[(size_t)j * n + i];
+        return 0;
+    }
+    if (op == "lu") {
+        int info = LAPACKE_dgetrf(LAPACK_ROW_MAJOR, n, n, ws.work.data(), n, ws.ipiv.data());
+        if (info == 0)
+            info = LAPACKE_dgetri(LAPACK_ROW_MAJOR, n, ws.work.data(), n, ws.ipiv.data());
+        return info;
+    }
+
+    int info = LAPACKE_dgesdd(LAPACK_ROW_MAJOR, 'A', n, n, ws.work.data(), n, ws.S.data(),
+                              ws.U.data(), n, ws.VT.data(), n);
+    if (info != 0)
+        return info;
+    double threshold = ws.S[0] * n * std::numeric_limits<double>::epsilon();
+    for (int i = 0; i < n; ++i) {
+        double s = (ws.S[i] > threshold) ? 1.0 / ws.S[i] : 0.0;
+        for (int j = 0; j < n; ++j)
+            ws.VT[(size_t)i * n + j] *= s;
+    }
+    cblas_dgemm(CblasRowMajor, CblasTrans, CblasTrans, n, n, n, 1.0, ws.VT.data(), n,
+                ws.U.data(), n, 0.0, ws.result.data(), n);
+    return 0;
+}
+
+// Номинальное число операций, ГФЛОП
+double op_gflop(const std::string& op, int n) {
+    double n3 = (double)n * n * n / 1e9;
+    if (op == "cholesky")
+        return n3;
+    if (op == "svd")
+        return 23.0 * n3;
+    return 2.0 * n3;
+}
+
+struct RunResult {
+    double wall = 0.0;
+    std::vector<double> latencies;
+    bool ok = true;
+};
+
+// В MKL число потоков задаётся для вызывающего потока (mkl_set_num_threads_local),
+// поэтому задачи – потоки одного процесса. Каждый поток привязывается к своим
+// ядрам до первого вызова MKL, и его команда OpenMP наследует эту привязку.
+// Все задачи готовят данные, затем стартуют одновременно
+RunResult run_jobs(const std::vector<std::vector<int>>& core_sets, int threads, int repeats,
+                   const std::string& op, int n) {
+    int jobs = (int)core_sets.size();
+    std::vector<std::vector<double>> latencies(jobs, std::vector<double>(repeats));
+    std::vector<int> failed(jobs, 0);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    int ready = 0;
+    bool go = false;
+
+    std::vector<std::thread> workers;
+    for (int j = 0; j < jobs; ++j) {
+        workers.emplace_back([&, j] {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int cpu : core_sets[j])
+                CPU_SET(cpu, &set);
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+            mkl_set_num_threads_local(threads);
+
+            Workspace ws(n, n + j, op);
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ++ready;
+                cv.notify_all();
+                cv.wait(lock, [&] { return go; });
+            }
+
+            for (int r = 0; r < repeats; ++r) {
+                auto start = std::chrono::steady_clock::now();
+                failed[j] += (run_op(ws, op) != 0);
+                latencies[j][r] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            }
+            mkl_set_num_threads_local(0);
+        });
+    }
+
+    std::chrono::steady_clock::time_point start;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return ready == jobs; });
+        start = std::chrono::steady_clock::now();
+        go = true;
+    }
+    cv.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+
+    RunResult result;
+    result.wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (int j = 0; j < jobs; ++j) {
+        result.ok = result.ok && failed[j] == 0;
+        result.latencies.insert(result.latencies.end(), latencies[j].begin(), latencies[j].end());
+    }
+    return result;
+}
+
+double percentile(std::vector<double> values, double q) {
+    std::sort(values.begin(), values.end());
+    size_t k = (size_t)std::lround(q * (values.size() - 1));
+    return values[k];
+}
+
+// Признаки переподписки ядер: несколько рантаймов OpenMP в одном процессе,
+// разрешённые вложенные параллельные участки и потоков больше, чем CPU.
+// Пулы потоков BLAS живут до выхода, поэтому снимок после замера их застаёт
+struct Oversubscription {
+    std::vector<std::string> runtimes;  // iomp5, gomp, omp, tbb
+    int threads = 0;
+    int cpus = 0;
+    int levels = 1;
+
+    static Oversubscription detect() {
+        Oversubscription o;
+        std::ifstream maps("/proc/self/maps");
+        std::string line;
+        static const std::pair<const char*, const char*> libraries[] = {
+            {"/libiomp5", "iomp5"}, {"/libgomp", "gomp"}, {"/libomp.", "omp"}, {"/libtbb.", "tbb"}};
+        while (std::getline(maps, line))
+            for (const auto& library : libraries)
+                if (line.find(library.first) != std::string::npos &&
+                    std::find(o.runtimes.begin(), o.runtimes.end(), library.second) == o.runtimes.end())
+                    o.runtimes.push_back(library.second);
+
+        std::ifstream status("/proc/self/status");
+        while (std::getline(status, line))
+            if (line.rfind("Threads:", 0) == 0)
+                o.threads = std::atoi(line.c_str() + 8);
+
+        cpu_set_t allowed;
+        sched_getaffinity(0, sizeof(allowed), &allowed);
+        o.cpus = CPU_COUNT(&allowed);
+
+        // Функции OpenMP ищутся в уже загруженных библиотеках: программа с OpenMP не связана
+        using LevelsFn = int (*)();
+        if (auto max_levels = (LevelsFn)dlsym(RTLD_DEFAULT, "omp_get_max_active_levels"))
+            o.levels = max_levels();
+        return o;
+    }
+
+    // Главный поток плюс один служебный допустимы сверх числа CPU
+    std::string problems() const {
+        std::vector<std::string> found;
+        int openmp = (int)runtimes.size() - (int)std::count(runtimes.begin(), runtimes.end(), "tbb");
+        if (openmp > 1) {
+            std::string list;
+            for (const std::string& r : runtimes)
+                if (r != "tbb")
+                    list += (list.empty() ? "" : "+") + r;
+            found.push_back("runtimes:" + list);
+        }
+        if (levels > 1)
+            found.push_back("nested:" + std::to_string(levels));
+        if (threads > cpus + 1)
+            found.push_back("threads:" + std::to_string(threads) + ">" + std::to_string(cpus));
+        std::string joined;
+        for (const std::string& f : found)
+            joined += (joined.empty() ? "" : ";") + f;
+        return joined.empty() ? "none" : joined;
+    }
+
+    std::string summary() const {
+        std::string list;
+        for (const std::string& r : runtimes)
+            list += (list.empty() ? "" : "+") + r;
+        return "runtimes:" + (list.empty() ? std::string("none") : list) + ",threads:" + std::to_string(threads) +
+               ",cpus:" + std::to_string(cpus) + ",levels:" + std::to_string(levels);
+    }
+};
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Использование: " << argv[0] << " <размер матрицы> [--op=cholesky|lu|svd|gemm] [--jobs=4]"
+                  << " [--threads-per-job=N] [--repeats=4] [--isolated=1|0]"
+                  << " [--threading=intel|gnu|tbb|sequential]" << std::endl;
+        return 1;
+    }
+
+    int n = std::stoi(argv[1]);
+    // С 32-битным MKL_INT n*n элементов не адресуются при n > 46340
+    if (sizeof(MKL_INT) < 8 && (long long)n * n > std::numeric_limits<MKL_INT>::max()) {
+        std::cerr << "Matrix size too large for 32-bit MKL_INT (n > 46340)" << std::endl;
+        return 1;
+    }
+
+    std::map<std::string, std::string> options;
+    try {
+        options = parse_options(argc, argv, 2);
+        if (!threading.error.empty())
+            throw std::invalid_argument(threading.error);
+    } catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::string op = option(options, "op", "cholesky");
+    if (op != "cholesky" && op != "lu" && op != "svd" && op != "gemm") {
+        std::cerr << "Unknown --op: " << op << std::endl;
+        return 1;
+    }
+
+    // Ядра, доступные процессу (с учётом --cpuset-cpus контейнера)
+    cpu_set_t allowed;
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        if (CPU_ISSET(cpu, &allowed))
+            cpus.push_back(cpu);
+
+    int jobs = std::max(1, std::stoi(option(options, "jobs", "4")));
+    int threads = std::stoi(option(options, "threads-per-job", std::to_string(std::max(1, (int)cpus.size() / jobs))));
+    int repeats = std::max(1, std::stoi(option(options, "repeats", "4")));
+    bool isolated = (option(options, "isolated", "1") != "0");
+    if (threads < 1 || jobs * threads > (int)cpus.size()) {
+        std::cerr << "Недостаточно ядер: " << jobs << "x" << threads << " > " << cpus.size() << std::endl;
+        return 1;
+    }
+
+    // Задача j получает ядра [j*threads, (j+1)*threads) из доступных
+    std::vector<std::vector<int>> core_sets(jobs);
+    for (int j = 0; j < jobs; ++j)
+        core_sets[j].assign(cpus.begin() + j * threads, cpus.begin() + (j + 1) * threads);
+
+    if (op == "cholesky") {
+        called_routines.push_back("dpotrf");
+        called_routines.push_back("dpotri");
+    } else if (op == "lu") {
+        called_routines.push_back("dgetrf");
+        called_routines.push_back("dgetri");
+    } else if (op == "svd") {
+        called_routines.push_back("dgesdd");
+        called_routines.push_back("dgemm");
+    } else {
+        called_routines.push_back("dgemm");
+    }
+
+    // Та же задача одна на своих ядрах – база для оценки конкуренции за память
+    RunResult alone;
+    if (isolated) {
+        alone = run_jobs({core_sets[0]}, threads, repeats, op, n);
+        if (!alone.ok) {
+            std::cerr << "Ошибка в одиночном запуске" << std::endl;
+            return 1;
+        }
+    }
+
+    RunResult together = run_jobs(core_sets, threads, repeats, op, n);
+    if (!together.ok) {
+        std::cerr << "Ошибка в одновременном запуске" << std::endl;
+        return 1;
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    long rss_kb = usage.ru_maxrss;
+    Oversubscription oversubscription = Oversubscription::detect();
+
+    double checksum = 0.0;
+    for (int j = 0; j < jobs; ++j)
+        for (double v : create_positive_definite_matrix(n, n + j))
+            checksum += v;
+
+    std::ostringstream routines_oss;
+    for (size_t i = 0; i < called_routines.size(); ++i) {
+        if (i) routines_oss << ',';
+        routines_oss << called_routines[i];
+    }
+
+    std::ostringstream cores_oss;
+    for (int j = 0; j < jobs; ++j)
+        for (size_t k = 0; k < core_sets[j].size(); ++k)
+            cores_oss << (k ? "," : (j ? ";" : "")) << core_sets[j][k];
+
+    double ops = (double)jobs * repeats;
+    double median = percentile(together.latencies, 0.5);
+
+    std::cout << std::fixed << std::setprecision(9);
+    std::cout << "RESULT_SECONDS=" << together.wall << std::endl;
+    std::cout << "DIAG_THREADS=mkl/libmkl_rt:" << threads << std::endl;
+    std::cout << "DIAG_THREADING=" << threading.label() << "," << oversubscription.summary() << std::endl;
+    std::cout << "DIAG_OVERSUBSCRIPTION=" << oversubscription.problems() << std::endl;
+    std::cout << "DIAG_PEAK_RSS_KB=" << rss_kb << std::endl;
+    std::cout << "DIAG_ROUTINES=" << routines_oss.str() << std::endl;
+    std::cout << "DIAG_JOBS=" << op << ":" << jobs << "x" << threads << std::endl;
+    std::cout << "DIAG_CORES=" << cores_oss.str() << std::endl;
+    std::cout << std::setprecision(6);
+    std::cout << "DIAG_THROUGHPUT=" << ops / together.wall << std::endl;
+    std::cout << "DIAG_GFLOPS=" << ops * op_gflop(op, n) / together.wall << std::endl;
+    std::cout << "DIAG_LATENCY=p50:" << median
+              << ",p90:" << percentile(together.latencies, 0.9)
+              << ",max:" << percentile(together.latencies, 1.0) << std::endl;
+    if (isolated) {
+        double alone_median = percentile(alone.latencies, 0.5);
+        std::cout << "DIAG_ISOLATED_LATENCY=p50:" << alone_median << std::endl;
+        // Во сколько раз задача медленнее, когда рядом работают остальные
+        std::cout << "DIAG_CONTENTION_SLOWDOWN=" << median / alone_median << std::endl;
+    }
+    std::cout << "DIAG_CHECKSUM=" << checksum << std::endl;
+
+    return 0;
+}
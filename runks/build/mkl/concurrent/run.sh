@@ -0,0 +1,44 @@
+#!/bin/bash
+
+# Список контейнеров
+containers=(
+	"mkl_concurrent"
+)
+
+# Операции
+ops=(cholesky lu svd gemm)
+
+# Число одновременных задач; ядра делятся между ними поровну
+jobs=(1 2 4 8 16)
+
+# Размеры матриц
+sizes=(2500 5000 7500)
+
+# Количество запусков для каждой конфигурации
+runs=5
+
+# Запуск контейнеров
+for container in "${containers[@]}"; do
+    for op in "${ops[@]}"; do
+        for p in "${jobs[@]}"; do
+            for size in "${sizes[@]}"; do
+                # Создаем файл для вывода для текущей конфигурации
+                output_file="${container}_${op}_jobs_${p}_size_${size}.txt"
+
+                for ((i=1; i<=runs; i++)); do
+                    echo "Запуск контейнера $container ($op, $p задач) с размером матрицы $size, запуск номер $i..."
+
+                    container_id=$(docker run -d --rm "$container" "$size" --op="$op" --jobs="$p")
+
+                    # Ожидаем завершения контейнера и записываем его вывод в файл
+                    docker logs -f "$container_id" >> "$output_file"
+
+                    # Ждем завершения контейнера
+                    docker wait "$container_id"
+                done
+            done
+        done
+    done
+done
+
+cd ../
@@ -19,6 +19,8 @@ build_container() {
 
 
 build_container "mkl_lu" "Dockerfile.mkllu"
+# 64-битные индексы для n > 46340
+build_container "mkl_lu_ilp64" "Dockerfile.mkllu_ilp64"
 
 
 cd ../
@@ -8,80 +8,2236 @@
 #include <mkl.h>
 #include <cstdlib>
 #include <cmath>
+#include <map>
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
 #include <sys/resource.h>
+#include <fstream>
+#include <cstring>
+#include <cerrno>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <dirent.h>
+#include <atomic>
+#include <malloc.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <charconv>
+#include <memory>
+#include <cstdint>
+#include <exception>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dlfcn.h>
+#include <deque>
+#include <omp-tools.h>
+#include <cctype>
 
 // список вызванных подпрограмм LAPACK/BLAS
 std::vector<std::string> called_routines;
 
+// Энергия через Linux powercap (Intel RAPL): домены package и dram.
+// Счётчики energy_uj растут до max_energy_range_uj и обнуляются, поэтому
+// фоновый поток опрашивает их раз в секунду, чтобы не пропустить переполнение.
+// Энергия между вызовами phase() приписывается названной подпрограмме
+class RaplMeter {
+public:
+    void start() {
+        open();
+        if (!available())
+            return;
+        sample();
+        for (Domain& d : domains)
+            d.joules = 0.0;
+        running = true;
+        poller = std::thread([this] {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!wake.wait_for(lock, std::chrono::seconds(1), [this] { return !running; }))
+                sample();
+        });
+    }
+
+    void phase(const std::string& name) {
+        if (!available())
+            return;
+        std::lock_guard<std::mutex> lock(mutex);
+        double now = sample();
+        if (!current.empty()) {
+            auto it = std::find_if(phases.begin(), phases.end(),
+                                   [this](const std::pair<std::string, double>& p) { return p.first == current; });
+            if (it == phases.end())
+                it = phases.insert(phases.end(), std::make_pair(current, 0.0));
+            it->second += now - phase_start;
+        }
+        current = name;
+        phase_start = now;
+    }
+
+    void stop() {
+        if (!available())
+            return;
+        phase("");
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+        }
+        wake.notify_all();
+        poller.join();
+    }
+
+    bool available() const { return status == "ok"; }
+
+    // gflop – номинальное число операций замеряемого участка
+    void report(double gflop) const {
+        std::cout << "DIAG_ENERGY_STATUS=" << status << std::endl;
+        if (!available())
+            return;
+        double total = 0.0;
+        std::ostringstream domains_oss, phases_oss;
+        domains_oss << std::fixed << std::setprecision(6);
+        phases_oss << std::fixed << std::setprecision(6);
+        for (size_t i = 0; i < domains.size(); ++i) {
+            total += domains[i].joules;
+            domains_oss << (i ? "," : "") << domains[i].label << ':' << domains[i].joules;
+        }
+        for (size_t i = 0; i < phases.size(); ++i)
+            phases_oss << (i ? "," : "") << phases[i].first << ':' << phases[i].second;
+        std::cout << "DIAG_ENERGY_J=" << total << std::endl;
+        std::cout << "DIAG_ENERGY_J_PER_GFLOP=" << total / gflop << std::endl;
+        std::cout << "DIAG_ENERGY_DOMAINS=" << domains_oss.str() << std::endl;
+        std::cout << "DIAG_ENERGY_ROUTINES=" << phases_oss.str() << std::endl;
+    }
+
+private:
+    struct Domain {
+        std::string label;
+        std::string path;
+        double max_uj;
+        double last_uj;
+        double joules;
+    };
+
+    // Домены верхнего уровня intel-rapl:N (package-N) и их поддомены dram
+    void open() {
+        const std::string root = "/sys/class/powercap/";
+        DIR* dir = opendir(root.c_str());
+        if (!dir) {
+            status = "unavailable:" + root + ": " + std::strerror(errno);
+            return;
+        }
+        std::vector<std::string> zones;
+        while (dirent* entry = readdir(dir)) {
+            std::string zone = entry->d_name;
+            if (zone.rfind("intel-rapl:", 0) == 0)
+                zones.push_back(zone);
+        }
+        closedir(dir);
+        std::sort(zones.begin(), zones.end());
+
+        for (const std::string& zone : zones) {
+            std::string path = root + zone + "/";
+            std::string name;
+            std::ifstream(path + "name") >> name;
+            std::string package = zone.substr(11, zone.find(':', 11) - 11);
+            if (name == "dram")
+                name += "-" + package;
+            else if (name.rfind("package", 0) != 0)
+                continue;
+
+            Domain d;
+            d.label = name;
+            d.path = path + "energy_uj";
+            d.max_uj = 0.0;
+            std::ifstream(path + "max_energy_range_uj") >> d.max_uj;
+            d.joules = 0.0;
+            errno = 0;
+            std::ifstream counter(d.path);
+            if (!(counter >> d.last_uj)) {
+                status = "unavailable:" + d.path + ": " + (errno ? std::strerror(errno) : "unreadable");
+                domains.clear();
+                return;
+            }
+            domains.push_back(d);
+        }
+        status = domains.empty() ? "unavailable:no intel-rapl package/dram domains" : "ok";
+    }
+
+    // Вызывается под mutex (или до запуска потока); возвращает джоули с начала замера
+    double sample() {
+        double total = 0.0;
+        for (Domain& d : domains) {
+            double uj = d.last_uj;
+            std::ifstream(d.path) >> uj;
+            double delta = uj - d.last_uj;
+            if (delta < 0.0)
+                delta += d.max_uj;
+            d.joules += delta * 1e-6;
+            d.last_uj = uj;
+            total += d.joules;
+        }
+        return total;
+    }
+
+    std::string status = "unavailable:not started";
+    std::vector<Domain> domains;
+    std::vector<std::pair<std::string, double>> phases;
+    std::string current;
+    double phase_start = 0.0;
+    bool running = false;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::thread poller;
+};
+
+RaplMeter rapl;
+
+// Учёт выделений памяти: malloc/free и их родственники из программы перекрывают
+// версии glibc для всего процесса, включая OpenBLAS/MKL и временные буферы
+// LAPACKE, и передают вызов в __libc_*. Размер берётся из malloc_usable_size
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void* __libc_valloc(size_t size);
+void* __libc_pvalloc(size_t size);
+void __libc_free(void* ptr);
+}
+
+namespace heap {
+std::atomic<long long> live{0};       // байт выделено сейчас
+std::atomic<long long> peak{0};       // максимум live с начала фазы
+std::atomic<long long> allocated{0};  // байт выделено с начала программы
+std::atomic<long long> calls{0};
+
+inline void on_alloc(void* ptr) {
+    if (!ptr)
+        return;
+    long long size = malloc_usable_size(ptr);
+    allocated += size;
+    ++calls;
+    long long now = live += size;
+    long long prev = peak.load(std::memory_order_relaxed);
+    while (now > prev && !peak.compare_exchange_weak(prev, now, std::memory_order_relaxed))
+        ;
+}
+
+inline void on_free(void* ptr) {
+    if (ptr)
+        live -= (long long)malloc_usable_size(ptr);
+}
+}  // namespace heap
+
+extern "C" {
+void* malloc(size_t size) noexcept {
+    void* ptr = __libc_malloc(size);
+    heap::on_alloc(ptr);
+    return ptr;
+}
+
+void* calloc(size_t count, size_t size) noexcept {
+    void* ptr = __libc_calloc(count, size);
+    heap::on_alloc(ptr);
+    return ptr;
+}
+
+void* realloc(void* ptr, size_t size) noexcept {
+    long long old_size = ptr ? (long long)malloc_usable_size(ptr) : 0;
+    void* result = __libc_realloc(ptr, size);
+    if (result || size == 0) {
+        heap::live -= old_size;
+        heap::on_alloc(result);
+    }
+    return result;
+}
+
+void free(void* ptr) noexcept {
+    heap::on_free(ptr);
+    __libc_free(ptr);
+}
+
+void* memalign(size_t alignment, size_t size) noexcept {
+    void* ptr = __libc_memalign(alignment, size);
+    heap::on_alloc(ptr);
+    return ptr;
+}
+
+// Выравнивание – степень двойки; memalign молча округлил бы остальные,
+// а aligned_alloc и posix_memalign должны вернуть EINVAL, как в glibc
+static bool power_of_two(size_t alignment) {
+    return alignment != 0 && (alignment & (alignment - 1)) == 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept {
+    if (!power_of_two(alignment)) {
+        errno = EINVAL;
+        return nullptr;
+    }
+    return memalign(alignment, size);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) noexcept {
+    if (!power_of_two(alignment) || alignment % sizeof(void*) != 0)
+        return EINVAL;
+    void* ptr = memalign(alignment, size);
+    if (!ptr)
+        return ENOMEM;
+    *out = ptr;
+    return 0;
+}
+
+void* valloc(size_t size) noexcept {
+    void* ptr = __libc_valloc(size);
+    heap::on_alloc(ptr);
+    return ptr;
+}
+
+void* pvalloc(size_t size) noexcept {
+    void* ptr = __libc_pvalloc(size);
+    heap::on_alloc(ptr);
+    return ptr;
+}
+}
+
+// Слой потоков MKL (mkl_rt) задаётся до первого вызова MKL, то есть раньше
+// разбора параметров: --threading ищется прямо в /proc/self/cmdline, затем
+// берётся MKL_THREADING_LAYER; по умолчанию intel
+struct ThreadingLayer {
+    std::string requested = "intel";
+    std::string actual = "unknown";
+    std::string error;
+
+    ThreadingLayer() {
+#ifdef MKL_ILP64
+        // mkl_rt по умолчанию LP64: 64-битные MKL_INT нужно объявить тем же ранним вызовом
+        mkl_set_interface_layer(MKL_INTERFACE_ILP64);
+#endif
+        if (const char* env = std::getenv("MKL_THREADING_LAYER")) {
+            requested = env;
+            std::transform(requested.begin(), requested.end(), requested.begin(),
+                           [](unsigned char c) { return (char)std::tolower(c); });
+        }
+        std::ifstream cmdline("/proc/self/cmdline");
+        std::string arg;
+        while (std::getline(cmdline, arg, '\0'))
+            if (arg.rfind("--threading=", 0) == 0)
+                requested = arg.substr(12);
+
+        static const std::map<std::string, int> layers = {
+            {"intel", MKL_THREADING_INTEL}, {"gnu", MKL_THREADING_GNU},
+            {"tbb", MKL_THREADING_TBB}, {"sequential", MKL_THREADING_SEQUENTIAL}};
+        auto it = layers.find(requested);
+        if (it == layers.end()) {
+            error = "Unknown --threading: " + requested;
+            return;
+        }
+        // Возвращается слой, который действует: после инициализации MKL он уже не меняется
+        int code = mkl_set_threading_layer(it->second);
+        for (const auto& layer : layers)
+            if (layer.second == code)
+                actual = layer.first;
+    }
+
+    std::string label() const {
+        return requested + "->" + actual;
+    }
+};
+
+ThreadingLayer threading;
+
+// Трасса выполнения по потокам в формате Chrome trace (chrome://tracing,
+// ui.perfetto.dev), --trace=путь. Каждый поток пишет события в свой буфер,
+// общий замок берётся только при создании буфера. Отметки подпрограмм
+// главного потока ставит MemoryMeter::phase на тех же границах, что и
+// called_routines
+namespace trace {
+struct Event {
+    const char* name;  // строковый литерал или строка из names
+    const char* cat;
+    double ts;         // мкс от начала программы
+    double dur;
+};
+
+struct Buffer {
+    std::mutex mutex;  // свободен всегда, кроме записи файла
+    int tid = 0;
+    std::string name;
+    std::vector<Event> events;
+    long dropped = 0;
+    std::vector<double> regions;  // начала вложенных параллельных областей
+    double wait_start = 0.0;
+};
+
+constexpr size_t max_events = 1 << 20;  // на поток; сверх – только счёт потерянных
+
+std::mutex mutex;
+std::atomic<int> workers{0};
+
+struct Registry {
+    std::vector<Buffer*> buffers;  // не освобождаются: потоки пула завершаются раньше записи
+    std::deque<std::string> names; // deque не переносит элементы при росте
+    std::string current;
+    double current_start = 0.0;
+    std::string source = "none";
+};
+
+// Не глобальный объект: OpenBLAS создаёт потоки в конструкторе библиотеки,
+// раньше инициализации глобальных объектов программы
+Registry& registry() {
+    static Registry* r = new Registry;
+    return *r;
+}
+
+// Параметр читается из /proc/self/cmdline, как --threading: события
+// приходят раньше разбора параметров
+const std::string& path() {
+    static const std::string value = [] {
+        std::ifstream cmdline("/proc/self/cmdline");
+        std::string arg, found;
+        while (std::getline(cmdline, arg, '\0'))
+            if (arg.rfind("--trace=", 0) == 0)
+                found = arg.substr(8);
+        return found;
+    }();
+    return value;
+}
+
+bool enabled() {
+    static const bool value = !path().empty();
+    return value;
+}
+
+double now_us() {
+    static const auto origin = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - origin).count();
+}
+
+thread_local Buffer* local_buffer = nullptr;
+
+Buffer* local(const char* name = nullptr) {
+    if (!local_buffer) {
+        Buffer* b = new Buffer;
+        b->tid = (int)gettid();
+        b->name = name ? name : (b->tid == getpid() ? "main" : "thread " + std::to_string(b->tid));
+        b->events.reserve(1 << 12);
+        std::lock_guard<std::mutex> lock(mutex);
+        registry().buffers.push_back(b);
+        local_buffer = b;
+    }
+    return local_buffer;
+}
+
+void record(Buffer* b, const char* name, const char* cat, double ts, double dur) {
+    std::lock_guard<std::mutex> lock(b->mutex);
+    if (b->events.size() < max_events)
+        b->events.push_back({name, cat, ts, dur});
+    else
+        ++b->dropped;
+}
+
+void record(const char* name, const char* cat, double ts, double dur) {
+    record(local(), name, cat, ts, dur);
+}
+
+// Граница фазы главного потока; подпрограммы из called_routines – категория routine
+void phase(const std::string& name) {
+    if (!enabled() || name == registry().current)
+        return;
+    Registry& r = registry();
+    double now = now_us();
+    if (!r.current.empty()) {
+        bool routine = std::find(called_routines.begin(), called_routines.end(), r.current) != called_routines.end();
+        r.names.push_back(r.current);
+        record(r.names.back().c_str(), routine ? "routine" : "phase", r.current_start, now - r.current_start);
+    }
+    r.current = name;
+    r.current_start = now;
+}
+
+// OMPT: рантайм OpenMP (libiomp5 у слоя intel) ищет ompt_start_tool в программе при
+// инициализации. Рабочие потоки получают имена, события – области parallel
+// (неявные задачи), ожидания синхронизации и явные задачи. У слоёв gnu, tbb и
+// sequential OMPT нет: в трассе остаются только подпрограммы главного потока
+const char* sync_name(ompt_sync_region_t kind) {
+    switch (kind) {
+    case ompt_sync_region_taskwait: return "taskwait";
+    case ompt_sync_region_taskgroup: return "taskgroup";
+    case ompt_sync_region_reduction: return "reduction";
+    default: return "barrier";
+    }
+}
+
+void on_thread_begin(ompt_thread_t type, ompt_data_t*) {
+    if (type == ompt_thread_worker)
+        local(("omp worker #" + std::to_string(++workers)).c_str());
+}
+
+void on_implicit_task(ompt_scope_endpoint_t endpoint, ompt_data_t*, ompt_data_t*, unsigned int, unsigned int, int flags) {
+    if (flags & ompt_task_initial)
+        return;
+    Buffer* b = local();
+    if (endpoint == ompt_scope_begin) {
+        b->regions.push_back(now_us());
+    } else if (!b->regions.empty()) {
+        double start = b->regions.back();
+        b->regions.pop_back();
+        record(b, "parallel", "parallel", start, now_us() - start);
+    }
+}
+
+void on_sync_region_wait(ompt_sync_region_t kind, ompt_scope_endpoint_t endpoint, ompt_data_t*, ompt_data_t*, const void*) {
+    Buffer* b = local();
+    if (endpoint == ompt_scope_begin)
+        b->wait_start = now_us();
+    else
+        record(b, sync_name(kind), "wait", b->wait_start, now_us() - b->wait_start);
+}
+
+// Явная задача: в value её данных – 1 до первого запуска, затем момент запуска в нс + 2
+void on_task_create(ompt_data_t*, const ompt_frame_t*, ompt_data_t* task, int flags, int, const void*) {
+    if (flags & ompt_task_explicit)
+        task->value = 1;
+}
+
+void on_task_schedule(ompt_data_t* prior, ompt_task_status_t, ompt_data_t* next) {
+    double now = now_us();
+    if (prior && prior->value > 1) {
+        double start = (prior->value - 2) / 1000.0;
+        record("task", "task", start, now - start);
+        prior->value = 1;
+    }
+    if (next && next->value >= 1)
+        next->value = (uint64_t)(now * 1000.0) + 2;
+}
+
+int initialize(ompt_function_lookup_t lookup, int, ompt_data_t*) {
+    auto set_callback = (ompt_set_callback_t)lookup("ompt_set_callback");
+    set_callback(ompt_callback_thread_begin, (ompt_callback_t)&on_thread_begin);
+    set_callback(ompt_callback_implicit_task, (ompt_callback_t)&on_implicit_task);
+    set_callback(ompt_callback_sync_region_wait, (ompt_callback_t)&on_sync_region_wait);
+    set_callback(ompt_callback_task_create, (ompt_callback_t)&on_task_create);
+    set_callback(ompt_callback_task_schedule, (ompt_callback_t)&on_task_schedule);
+    registry().source = "ompt";
+    return 1;
+}
+
+void finalize(ompt_data_t*) {}
+
+// Запись JSON; возвращает строку для DIAG_TRACE или пустую при ошибке записи
+std::string write() {
+    phase("");
+    std::ofstream out(path());
+    if (!out)
+        return "";
+    std::lock_guard<std::mutex> lock(mutex);
+    const Registry& r = registry();
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << getpid() << ",\"args\":{\"name\":\"" << program_invocation_short_name << "\"}}";
+    long events = 0, dropped = 0;
+    for (Buffer* b : r.buffers) {
+        std::lock_guard<std::mutex> buffer_lock(b->mutex);
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << getpid() << ",\"tid\":" << b->tid
+            << ",\"args\":{\"name\":\"" << b->name << "\"}}";
+        for (const Event& e : b->events)
+            out << ",\n{\"name\":\"" << e.name << "\",\"cat\":\"" << e.cat << "\",\"ph\":\"X\",\"pid\":" << getpid()
+                << ",\"tid\":" << b->tid << ",\"ts\":" << e.ts << ",\"dur\":" << e.dur << "}";
+        events += b->events.size();
+        dropped += b->dropped;
+    }
+    out << "\n]}\n";
+    if (!out)
+        return "";
+    return path() + ",source:" + r.source + ",threads:" + std::to_string(r.buffers.size()) +
+           ",events:" + std::to_string(events) + ",dropped:" + std::to_string(dropped);
+}
+}  // namespace trace
+
+extern "C" ompt_start_tool_result_t* ompt_start_tool(unsigned int, const char*) {
+    static ompt_start_tool_result_t result = {&trace::initialize, &trace::finalize, {0}};
+    return trace::enabled() ? &result : nullptr;
+}
+
+// Память по фазам: на каждой границе phase() снимаются малые/большие отказы
+// страниц (getrusage), резидентный размер (/proc/self/statm) и счётчики выделений.
+// Фаза до первой отметки – startup (загрузка библиотек и разбор аргументов)
+class MemoryMeter {
+public:
+    MemoryMeter() {
+        // Учёт внутренних буферов MKL включается до первого вызова MKL
+        mkl_peak_mem_usage(MKL_PEAK_MEM_ENABLE);
+        mark = snapshot();
+    }
+
+    void phase(const std::string& name) {
+        trace::phase(name);
+        Snapshot now = snapshot();
+        auto it = std::find_if(phases.begin(), phases.end(),
+                               [this](const Phase& p) { return p.name == current; });
+        if (it == phases.end()) {
+            it = phases.insert(phases.end(), Phase());
+            it->name = current;
+        }
+        it->alloc_bytes += now.allocated - mark.allocated;
+        it->heap_peak = std::max(it->heap_peak, heap::peak.load());
+        it->rss_delta += now.rss - mark.rss;
+        it->minflt += now.minflt - mark.minflt;
+        it->majflt += now.majflt - mark.majflt;
+        it->mkl_peak = std::max(it->mkl_peak, (long long)mkl_peak_mem_usage(MKL_PEAK_MEM_RESET));
+        heap_peak_total = std::max(heap_peak_total, heap::peak.load());
+        heap::peak = heap::live.load();
+        current = name;
+        mark = now;
+    }
+
+    // Закрывает текущую фазу; поля фазы: выделено, пик кучи и прирост RSS в КБ, отказы страниц,
+    // пик буферов MKL
+    void report() {
+        phase(current);
+        std::ostringstream oss;
+        for (size_t i = 0; i < phases.size(); ++i) {
+            const Phase& p = phases[i];
+            oss << (i ? "," : "") << p.name
+                << ":alloc_kb=" << p.alloc_bytes / 1024
+                << ":heap_peak_kb=" << p.heap_peak / 1024
+                << ":rss_delta_kb=" << p.rss_delta / 1024
+                << ":minflt=" << p.minflt
+                << ":majflt=" << p.majflt
+                << ":mkl_peak_kb=" << p.mkl_peak / 1024;
+        }
+        std::cout << "DIAG_MEM_PHASES=" << oss.str() << std::endl;
+        std::cout << "DIAG_MEM_HEAP_PEAK_KB=" << heap_peak_total / 1024 << std::endl;
+        std::cout << "DIAG_MEM_ALLOCS=" << heap::calls.load() << std::endl;
+    }
+
+private:
+    struct Snapshot {
+        long long allocated;
+        long long rss;
+        long minflt;
+        long majflt;
+    };
+
+    struct Phase {
+        std::string name;
+        long long alloc_bytes = 0;
+        long long heap_peak = 0;
+        long long rss_delta = 0;
+        long minflt = 0;
+        long majflt = 0;
+        long long mkl_peak = 0;  // пик буферов менеджера памяти MKL
+    };
+
+    static Snapshot snapshot() {
+        Snapshot s;
+        s.allocated = heap::allocated.load();
+        long pages = 0, resident = 0;
+        std::ifstream("/proc/self/statm") >> pages >> resident;
+        s.rss = (long long)resident * sysconf(_SC_PAGESIZE);
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        s.minflt = usage.ru_minflt;
+        s.majflt = usage.ru_majflt;
+        return s;
+    }
+
+    std::vector<Phase> phases;
+    std::string current = "startup";
+    Snapshot mark;
+    long long heap_peak_total = 0;
+};
+
+MemoryMeter memory;
+
+// Топология из /sys/devices/system/cpu: пакет, ядро, SMT-соседи и общий L2.
+// Тип ядра на гибридных Intel (P/E) берётся из /sys/devices/cpu_atom/cpus,
+// на ARM big.LITTLE – по меньшему cpu_capacity
+struct CpuInfo {
+    int id;
+    int package;
+    int l2_group;      // первый CPU с общим L2 (кластер E-ядер)
+    bool efficient;    // E-ядро
+    bool smt_sibling;  // второй и следующие потоки физического ядра
+};
+
+// Список вида "0-3,8,10-11"
+std::vector<int> parse_cpu_list(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty() || !isdigit((unsigned char)range[0]))
+            continue;
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+        for (int c = first; c <= last; ++c)
+            cpus.push_back(c);
+    }
+    return cpus;
+}
+
+std::string read_line(const std::string& path) {
+    std::string line;
+    std::ifstream file(path);
+    std::getline(file, line);
+    return line;
+}
+
+std::string format_cpu_list(const std::vector<int>& cpus) {
+    std::ostringstream oss;
+    for (size_t i = 0; i < cpus.size(); ++i)
+        oss << (i ? "," : "") << cpus[i];
+    return oss.str();
+}
+
+std::vector<CpuInfo> detect_topology() {
+    const std::string root = "/sys/devices/system/cpu/";
+    std::vector<int> online = parse_cpu_list(read_line(root + "online"));
+    std::vector<int> atom = parse_cpu_list(read_line("/sys/devices/cpu_atom/cpus"));
+    std::vector<CpuInfo> cpus;
+    std::vector<int> capacity;
+    for (int id : online) {
+        std::string dir = root + "cpu" + std::to_string(id) + "/";
+        CpuInfo cpu;
+        cpu.id = id;
+        std::string package = read_line(dir + "topology/physical_package_id");
+        cpu.package = package.empty() ? 0 : std::stoi(package);
+        std::vector<int> siblings = parse_cpu_list(read_line(dir + "topology/thread_siblings_list"));
+        cpu.smt_sibling = !siblings.empty() && siblings.front() != id;
+        cpu.l2_group = id;
+        for (int index = 0; index < 8; ++index) {
+            std::string cache = dir + "cache/index" + std::to_string(index) + "/";
+            if (read_line(cache + "level") == "2" && read_line(cache + "type") != "Instruction") {
+                std::vector<int> shared = parse_cpu_list(read_line(cache + "shared_cpu_list"));
+                if (!shared.empty())
+                    cpu.l2_group = shared.front();
+                break;
+            }
+        }
+        cpu.efficient = std::find(atom.begin(), atom.end(), id) != atom.end();
+        std::string cap = read_line(dir + "cpu_capacity");
+        capacity.push_back(cap.empty() ? 0 : std::stoi(cap));
+        cpus.push_back(cpu);
+    }
+    if (atom.empty() && !capacity.empty()) {
+        int top = *std::max_element(capacity.begin(), capacity.end());
+        for (size_t i = 0; i < cpus.size(); ++i)
+            cpus[i].efficient = capacity[i] > 0 && capacity[i] < top;
+    }
+    return cpus;
+}
+
+// Размещение потоков: compute – CPU для BLAS, aux – для генерации и проверки.
+// Политики: all, cores (без SMT-соседей), socket, socket-cores (пакет 0) и для
+// гибридных процессоров pcores, pcores-nosmt, ecores. На однородной машине
+// гибридные политики сводятся к all/cores
+class Placement {
+public:
+    Placement(const std::string& requested) : requested(requested) {
+        if (requested == "none")
+            return;
+        cpus = detect_topology();
+        bool hybrid = std::any_of(cpus.begin(), cpus.end(), [](const CpuInfo& c) { return c.efficient; });
+
+        policy = requested;
+        if (!hybrid && (policy == "pcores" || policy == "ecores"))
+            policy = (policy == "pcores") ? "all" : "cores";
+        else if (!hybrid && policy == "pcores-nosmt")
+            policy = "cores";
+
+        for (const CpuInfo& c : cpus) {
+            bool take;
+            if (policy == "all")
+                take = true;
+            else if (policy == "cores")
+                take = !c.smt_sibling;
+            else if (policy == "socket")
+                take = c.package == cpus.front().package;
+            else if (policy == "socket-cores")
+                take = c.package == cpus.front().package && !c.smt_sibling;
+            else if (policy == "pcores")
+                take = !c.efficient;
+            else if (policy == "pcores-nosmt")
+                take = !c.efficient && !c.smt_sibling;
+            else if (policy == "ecores")
+                take = c.efficient;
+            else
+                throw std::invalid_argument("Unknown --placement: " + requested);
+            if (take)
+                compute.push_back(c.id);
+        }
+        if (compute.empty())
+            throw std::invalid_argument("Placement " + policy + " selects no CPUs");
+
+        // Вспомогательные стадии: на гибридном процессоре – свободные E-ядра,
+        // иначе любые CPU вне compute; если таких нет – те же CPU
+        for (const CpuInfo& c : cpus) {
+            bool free = std::find(compute.begin(), compute.end(), c.id) == compute.end();
+            if (free && (!hybrid || c.efficient))
+                aux.push_back(c.id);
+        }
+        if (aux.empty())
+            aux = compute;
+        active = true;
+    }
+
+    // Вспомогательная стадия в отдельном потоке на CPU aux; потоки BLAS и
+    // основной поток при этом не перепривязываются
+    template<class F>
+    void run_aux(F&& fn) const {
+        if (!active) {
+            fn();
+            return;
+        }
+        std::thread worker([&] {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int c : aux)
+                CPU_SET(c, &set);
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+            mkl_set_num_threads_local(1);  // MKL в этом потоке последовательно
+            fn();
+        });
+        worker.join();
+    }
+
+    void pin_blas_threads() const;
+
+    // Суффикс для DIAG_THREADS: backend@policy:N
+    std::string label() const { return active ? "@" + policy : ""; }
+
+    void report() const {
+        if (!active)
+            return;
+        int packages = 0, logical = (int)cpus.size(), cores = 0, efficient = 0;
+        std::vector<int> groups;
+        for (const CpuInfo& c : cpus) {
+            packages = std::max(packages, c.package + 1);
+            cores += !c.smt_sibling;
+            efficient += c.efficient && !c.smt_sibling;
+            if (std::find(groups.begin(), groups.end(), c.l2_group) == groups.end())
+                groups.push_back(c.l2_group);
+        }
+        std::cout << "DIAG_TOPOLOGY=packages:" << packages << ",logical:" << logical << ",cores:" << cores
+                  << ",pcores:" << cores - efficient << ",ecores:" << efficient
+                  << ",l2_groups:" << groups.size() << std::endl;
+        std::cout << "DIAG_PLACEMENT=" << requested << "->" << policy << ":compute=" << format_cpu_list(compute)
+                  << ":aux=" << format_cpu_list(aux) << std::endl;
+    }
+
+private:
+    std::string requested;
+    std::string policy = "none";
+    bool active = false;
+    std::vector<CpuInfo> cpus;
+    std::vector<int> compute, aux;
+};
+
+// Потоки OpenMP в MKL создаются при первом параллельном участке: до него
+// задаются места OMP_PLACES по одному CPU из compute и привязка close
+void Placement::pin_blas_threads() const {
+    if (!active)
+        return;
+    std::string places;
+    for (size_t i = 0; i < compute.size(); ++i)
+        places += (i ? ",{" : "{") + std::to_string(compute[i]) + "}";
+    setenv("OMP_PLACES", places.c_str(), 1);
+    setenv("OMP_PROC_BIND", "close", 1);
+    mkl_set_num_threads((int)compute.size());
+}
+
 // Генерация положительно определённой матрицы
 void generate_positive_definite_matrix(double* A, int n, int seed) {
     std::mt19937 gen(seed);
     std::uniform_real_distribution<> dis(0.0, 1.0);
 
-    for (int i = 0; i < n * n; ++i) {
+    for (size_t i = 0; i < (size_t)n * n; ++i) {
         A[i] = dis(gen);
     }
 
     for (int i = 0; i < n; ++i) {
         for (int j = 0; j < i; ++j) {
-            A[i*n + j] = A[j*n + i] = (A[i*n + j] + A[j*n + i]) / 2.0;
+            A[(size_t)i*n + j] = A[(size_t)j*n + i] = (A[(size_t)i*n + j] + A[(size_t)j*n + i]) / 2.0;
         }
     }
 
     for (int i = 0; i < n; ++i) {
-        A[i*n + i] += n;
+        A[(size_t)i*n + i] += n;
+    }
+}
+
+// Симметричная неопределённая матрица KKT [[H, B^T], [B, 0]]: H – SPD порядка
+// n - k, B – k x (n - k) полного ранга. По закону инерции Сильвестра у неё ровно
+// n - k положительных и k отрицательных собственных значений
+void generate_kkt_matrix(double* A, int n, int k, int seed) {
+    int m = n - k;
+    std::vector<double> H((size_t)m * m);
+    generate_positive_definite_matrix(H.data(), m, seed);
+    std::fill(A, A + (size_t)n * n, 0.0);
+    std::mt19937 gen(seed + 1);
+    std::uniform_real_distribution<> dis(0.0, 1.0);
+
+    for (int i = 0; i < m; ++i)
+        std::copy(H.begin() + (size_t)i * m, H.begin() + (size_t)(i + 1) * m, A + (size_t)i * n);
+    for (int i = m; i < n; ++i)
+        for (int j = 0; j < m; ++j)
+            A[(size_t)i * n + j] = A[(size_t)j * n + i] = dis(gen);
+}
+
+// Необязательные параметры вида --key=value
+std::map<std::string, std::string> parse_options(int argc, char* argv[], int first) {
+    std::map<std::string, std::string> options;
+    for (int i = first; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+            throw std::invalid_argument("Unknown argument: " + arg);
+        options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
     }
+    return options;
+}
+
+std::string option(const std::map<std::string, std::string>& options,
+                   const std::string& key, const std::string& fallback) {
+    auto it = options.find(key);
+    return it == options.end() ? fallback : it->second;
 }
 
+// Матрица из файла --input=путь вместо синтетической. Форматы:
+// - .npy: float64/float32/int64/int32, C- или Fortran-порядок;
+// - Matrix Market: array и coordinate, real/integer/pattern,
+//   general/symmetric/skew-symmetric;
+// - сырой двоичный: double в строчном порядке, квадратная матрица или --input-shape=RxC.
+// Файл отображается mmap. float64 в C-порядке и сырой формат используются на месте
+// без копирования, остальное за один проход приводится к плотному строчному
+// формату, с которым работают программы. Текст Matrix Market разбирается
+// параллельно по кускам файла
+class InputMatrix {
+public:
+    int rows = 0, cols = 0;
+    std::string format = "synthetic";
+    bool mapped = false;        // данные лежат в отображении файла
+    double load_seconds = 0.0;
+
+    InputMatrix() = default;
+    InputMatrix(std::vector<double>&& values, int r, int c)
+        : rows(r), cols(c), storage(std::move(values)), view(storage.data()) {}
+    InputMatrix(std::shared_ptr<void> file, const double* data, int r, int c)
+        : rows(r), cols(c), mapped(true), mapping(std::move(file)), view(data) {}
+    InputMatrix(InputMatrix&&) = default;
+    InputMatrix& operator=(InputMatrix&&) = default;
+
+    const double* data() const { return view; }
+    const double* begin() const { return view; }
+    const double* end() const { return view + size(); }
+    size_t size() const { return (size_t)rows * cols; }
+
+    void report() const {
+        std::cout << "DIAG_INPUT=" << format << ":" << rows << "x" << cols << ":"
+                  << (mapped ? "mapped" : "converted") << ":" << load_seconds << std::endl;
+    }
+
+private:
+    std::vector<double> storage;
+    std::shared_ptr<void> mapping;  // munmap при уничтожении
+    const double* view = nullptr;
+};
+
+struct MappedFile {
+    const char* bytes = nullptr;
+    size_t length = 0;
+    std::shared_ptr<void> owner;
+};
+
+MappedFile map_file(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::invalid_argument("Cannot open " + path + ": " + std::strerror(errno));
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        throw std::invalid_argument("Empty or unreadable input: " + path);
+    }
+    size_t length = st.st_size;
+    void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        throw std::invalid_argument("Cannot mmap " + path + ": " + std::strerror(errno));
+    madvise(p, length, MADV_SEQUENTIAL);
+    MappedFile file;
+    file.bytes = static_cast<const char*>(p);
+    file.length = length;
+    file.owner = std::shared_ptr<void>(p, [length](void* q) { munmap(q, length); });
+    return file;
+}
+
+// fn(part, begin, end) для parts частей диапазона [0, count) в отдельных потоках;
+// исключение из любого потока пробрасывается вызывающему
+template<class F>
+void parallel_parts(size_t count, int parts, F&& fn) {
+    parts = (int)std::max<size_t>(1, std::min<size_t>(parts, count));
+    std::vector<std::exception_ptr> errors(parts);
+    std::vector<std::thread> pool;
+    for (int p = 0; p < parts; ++p)
+        pool.emplace_back([&, p] {
+            try {
+                fn(p, count * p / parts, count * (p + 1) / parts);
+            } catch (...) {
+                errors[p] = std::current_exception();
+            }
+        });
+    for (std::thread& t : pool)
+        t.join();
+    for (std::exception_ptr& e : errors)
+        if (e)
+            std::rethrow_exception(e);
+}
+
+int loader_threads(size_t bytes) {
+    // Не меньше 4 МБ на поток: на маленьких файлах потоки дороже разбора
+    size_t by_size = std::max<size_t>(1, bytes >> 22);
+    return (int)std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), by_size);
+}
+
+// Элементы файла типа T (в строчном или столбцовом порядке) -> строчный double
+template<class T>
+std::vector<double> convert_dense(const char* src, int rows, int cols, bool column_major) {
+    std::vector<double> out((size_t)rows * cols);
+    parallel_parts(rows, loader_threads(out.size() * sizeof(T)), [&](int, size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i)
+            for (int j = 0; j < cols; ++j) {
+                size_t k = column_major ? (size_t)j * rows + i : i * cols + j;
+                T value;
+                std::memcpy(&value, src + k * sizeof(T), sizeof(T));
+                out[i * cols + j] = (double)value;
+            }
+    });
+    return out;
+}
+
+InputMatrix load_npy(const MappedFile& file) {
+    if (file.length < 10 || std::memcmp(file.bytes, "\x93NUMPY", 6) != 0)
+        throw std::invalid_argument("Not a .npy file");
+    int major = (unsigned char)file.bytes[6];
+    size_t header_len, header_start;
+    if (major == 1) {
+        header_len = (unsigned char)file.bytes[8] | ((unsigned char)file.bytes[9] << 8);
+        header_start = 10;
+    } else {
+        uint32_t len;
+        std::memcpy(&len, file.bytes + 8, 4);
+        header_len = len;
+        header_start = 12;
+    }
+    if (header_start + header_len > file.length)
+        throw std::invalid_argument(".npy header is truncated");
+    std::string header(file.bytes + header_start, header_len);
+
+    auto value_of = [&](const std::string& key) {
+        size_t pos = header.find("'" + key + "'");
+        if (pos == std::string::npos)
+            throw std::invalid_argument(".npy header has no " + key);
+        pos = header.find(':', pos) + 1;
+        while (pos < header.size() && header[pos] == ' ')
+            ++pos;
+        return pos;
+    };
+    size_t pos = value_of("descr");
+    std::string descr = header.substr(pos + 1, header.find('\'', pos + 1) - pos - 1);
+    bool column_major = header.compare(value_of("fortran_order"), 4, "True") == 0;
+    pos = value_of("shape");
+    std::vector<long> shape;
+    for (size_t end = header.find(')', pos); pos < end;) {
+        if (isdigit((unsigned char)header[pos])) {
+            size_t used;
+            shape.push_back(std::stol(header.substr(pos), &used));
+            pos += used;
+        } else {
+            ++pos;
+        }
+    }
+    if (shape.size() != 2)
+        throw std::invalid_argument(".npy array must be 2-dimensional");
+    int rows = (int)shape[0], cols = (int)shape[1];
+
+    if (descr.size() != 3 || descr[0] == '>')
+        throw std::invalid_argument("Unsupported .npy dtype " + descr);
+    std::string type = descr.substr(1);
+    size_t item = (size_t)(type[1] - '0');
+    size_t offset = header_start + header_len;
+    if (offset + (size_t)rows * cols * item > file.length)
+        throw std::invalid_argument(".npy data is truncated");
+    const char* data = file.bytes + offset;
+
+    InputMatrix matrix;
+    if (type == "f8" && !column_major && offset % sizeof(double) == 0)
+        matrix = InputMatrix(file.owner, reinterpret_cast<const double*>(data), rows, cols);
+    else if (type == "f8")
+        matrix = InputMatrix(convert_dense<double>(data, rows, cols, column_major), rows, cols);
+    else if (type == "f4")
+        matrix = InputMatrix(convert_dense<float>(data, rows, cols, column_major), rows, cols);
+    else if (type == "i8")
+        matrix = InputMatrix(convert_dense<int64_t>(data, rows, cols, column_major), rows, cols);
+    else if (type == "i4")
+        matrix = InputMatrix(convert_dense<int32_t>(data, rows, cols, column_major), rows, cols);
+    else
+        throw std::invalid_argument("Unsupported .npy dtype " + descr);
+    matrix.format = "npy-" + type;
+    return matrix;
+}
+
+InputMatrix load_raw(const MappedFile& file, const std::string& shape) {
+    size_t count = file.length / sizeof(double);
+    int rows, cols;
+    if (!shape.empty()) {
+        size_t x = shape.find('x');
+        rows = std::stoi(shape.substr(0, x));
+        cols = (x == std::string::npos) ? rows : std::stoi(shape.substr(x + 1));
+    } else {
+        rows = cols = (int)std::llround(std::sqrt((double)count));
+    }
+    if (file.length % sizeof(double) != 0 || (size_t)rows * cols != count)
+        throw std::invalid_argument("Raw input of " + std::to_string(file.length) +
+                                    " bytes does not match the matrix shape; use --input-shape=RxC");
+    InputMatrix matrix(file.owner, reinterpret_cast<const double*>(file.bytes), rows, cols);
+    matrix.format = "raw";
+    return matrix;
+}
+
+// Пробелы и строки-комментарии '%' перед следующим числом
+const char* skip_blank(const char* p, const char* end) {
+    while (p < end) {
+        if (*p == '%')
+            while (p < end && *p != '\n')
+                ++p;
+        else if (isspace((unsigned char)*p))
+            ++p;
+        else
+            break;
+    }
+    return p;
+}
+
+template<class T>
+const char* parse_number(const char* p, const char* end, T& value) {
+    if (p < end && *p == '+')
+        ++p;
+    std::from_chars_result r = std::from_chars(p, end, value);
+    if (r.ec != std::errc())
+        throw std::invalid_argument("Matrix Market: bad number '" + std::string(p, std::min<size_t>(end - p, 16)) + "'");
+    return r.ptr;
+}
+
+// Границы кусков текста [begin, end) по началам строк
+std::vector<const char*> split_lines(const char* begin, const char* end, int parts) {
+    std::vector<const char*> cuts{begin};
+    for (int p = 1; p < parts; ++p) {
+        const char* cut = std::max(begin + (end - begin) * p / parts, cuts.back());
+        while (cut < end && *cut != '\n')
+            ++cut;
+        cuts.push_back(cut < end ? cut + 1 : end);
+    }
+    cuts.push_back(end);
+    return cuts;
+}
+
+InputMatrix load_matrix_market(const MappedFile& file) {
+    const char* end = file.bytes + file.length;
+    const char* line_end = std::find(file.bytes, end, '\n');
+    std::istringstream banner(std::string(file.bytes, line_end));
+    std::string tag, object, layout, field, symmetry;
+    banner >> tag >> object >> layout >> field >> symmetry;
+    for (std::string* s : {&object, &layout, &field, &symmetry})
+        std::transform(s->begin(), s->end(), s->begin(), ::tolower);
+    if (object != "matrix" || (layout != "array" && layout != "coordinate") ||
+        (field != "real" && field != "integer" && field != "double" && field != "pattern") ||
+        (symmetry != "general" && symmetry != "symmetric" && symmetry != "skew-symmetric"))
+        throw std::invalid_argument("Unsupported Matrix Market header: " + std::string(file.bytes, line_end));
+    bool coordinate = (layout == "coordinate"), pattern = (field == "pattern");
+    bool general = (symmetry == "general"), skew = (symmetry == "skew-symmetric");
+
+    // Строка размеров: rows cols [nnz]
+    long rows, cols, entries;
+    const char* p = parse_number(skip_blank(line_end, end), end, rows);
+    p = parse_number(skip_blank(p, end), end, cols);
+    if (coordinate)
+        p = parse_number(skip_blank(p, end), end, entries);
+    else
+        entries = general ? rows * cols : skew ? rows * (rows - 1) / 2 : rows * (rows + 1) / 2;
+    if (!general && rows != cols)
+        throw std::invalid_argument("Symmetric Matrix Market matrix must be square");
+
+    std::vector<double> dense((size_t)rows * cols, 0.0);
+    double mirror = skew ? -1.0 : 1.0;
+    std::vector<const char*> cuts = split_lines(p, end, loader_threads(end - p));
+    int parts = (int)cuts.size() - 1;
+
+    // array: значения по столбцам (у симметричных – нижний треугольник), и
+    // позиция зависит от номера значения, поэтому сначала считаются числа в кусках
+    std::vector<size_t> first(parts + 1, 0);
+    if (!coordinate) {
+        parallel_parts(parts, parts, [&](int, size_t k, size_t) {
+            size_t count = 0;
+            for (const char* q = skip_blank(cuts[k], cuts[k + 1]); q < cuts[k + 1]; q = skip_blank(q, cuts[k + 1])) {
+                ++count;
+                while (q < cuts[k + 1] && !isspace((unsigned char)*q))
+                    ++q;
+            }
+            first[k + 1] = count;
+        });
+        for (int k = 0; k < parts; ++k)
+            first[k + 1] += first[k];
+    }
+
+    std::vector<size_t> found(parts, 0);
+    parallel_parts(parts, parts, [&](int, size_t k, size_t) {
+        const char* q = skip_blank(cuts[k], cuts[k + 1]);
+        const char* stop = cuts[k + 1];
+        if (coordinate) {
+            for (; q < stop; q = skip_blank(q, stop)) {
+                long i, j;
+                double v = 1.0;
+                q = parse_number(q, stop, i);
+                q = parse_number(skip_blank(q, stop), stop, j);
+                if (!pattern)
+                    q = parse_number(skip_blank(q, stop), stop, v);
+                if (i < 1 || i > rows || j < 1 || j > cols)
+                    throw std::invalid_argument("Matrix Market entry out of range");
+                dense[(i - 1) * cols + (j - 1)] = v;
+                if (!general && i != j)
+                    dense[(j - 1) * cols + (i - 1)] = mirror * v;
+                ++found[k];
+            }
+            return;
+        }
+        // Индекс первого значения куска -> (i, j) и дальше по порядку столбцов
+        size_t index = first[k];
+        long i = 0, j = 0;
+        if (general) {
+            j = index / rows;
+            i = index % rows;
+        } else {
+            long start = skew ? 1 : 0;
+            for (j = 0; j < cols; ++j) {
+                size_t column = rows - j - start;
+                if (index < column)
+                    break;
+                index -= column;
+            }
+            i = j + start + index;
+        }
+        for (; q < stop; q = skip_blank(q, stop)) {
+            double v;
+            q = parse_number(q, stop, v);
+            if (j >= cols)
+                throw std::invalid_argument("Matrix Market array has too many values");
+            dense[i * cols + j] = v;
+            if (!general)
+                dense[j * cols + i] = mirror * v;
+            ++found[k];
+            if (++i == rows) {
+                ++j;
+                i = general ? 0 : j + (skew ? 1 : 0);
+            }
+        }
+    });
+    size_t total = 0;
+    for (size_t f : found)
+        total += f;
+    if (total != (size_t)entries)
+        throw std::invalid_argument("Matrix Market: expected " + std::to_string(entries) +
+                                    " values, found " + std::to_string(total));
+
+    InputMatrix matrix(std::move(dense), (int)rows, (int)cols);
+    matrix.format = "mtx-" + layout + "-" + symmetry;
+    return matrix;
+}
+
+// --<key>=путь: формат по сигнатуре файла; размер квадратной матрицы
+// записывается в n (если n уже задан аргументом, он должен совпасть).
+// Без --<key> возвращается пустая матрица
+InputMatrix load_input(const std::map<std::string, std::string>& options, const std::string& key, int& n) {
+    auto it = options.find(key);
+    if (it == options.end())
+        return InputMatrix();
+    memory.phase("load-" + key);
+    auto start = std::chrono::steady_clock::now();
+    MappedFile file = map_file(it->second);
+    InputMatrix matrix;
+    if (file.length >= 6 && std::memcmp(file.bytes, "\x93NUMPY", 6) == 0)
+        matrix = load_npy(file);
+    else if (file.length >= 14 && std::memcmp(file.bytes, "%%MatrixMarket", 14) == 0)
+        matrix = load_matrix_market(file);
+    else
+        matrix = load_raw(file, option(options, key + "-shape", ""));
+    matrix.load_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (matrix.rows != matrix.cols)
+        throw std::invalid_argument("Input matrix must be square, got " + std::to_string(matrix.rows) +
+                                    "x" + std::to_string(matrix.cols));
+    if (n > 0 && n != matrix.rows)
+        throw std::invalid_argument("Matrix size " + std::to_string(n) + " does not match input " +
+                                    std::to_string(matrix.rows));
+    n = matrix.rows;
+    return matrix;
+}
+
+// Первый аргумент – размер матрицы; с --input=путь его можно опустить.
+// Возвращает индекс первой опции
+int size_argument(int argc, char* argv[], int& n) {
+    if (argc >= 2 && std::string(argv[1]).rfind("--", 0) != 0) {
+        n = std::atoi(argv[1]);
+        return 2;
+    }
+    n = 0;
+    return 1;
+}
+
+// Псевдообращение через SVD для плохо обусловленных матриц
+int svd_pseudo_inverse(const double* A, int n, double* A_inv) {
+    std::vector<double> work(A, A + (size_t)n * n);
+    std::vector<double> S(n);
+    std::vector<double> U((size_t)n * n);
+    std::vector<double> VT((size_t)n * n);
+
+    called_routines.push_back("dgesdd");
+    rapl.phase("dgesdd");
+    memory.phase("dgesdd");
+    int info = LAPACKE_dgesdd(LAPACK_ROW_MAJOR, 'A', n, n,
+                              work.data(), n, S.data(), U.data(), n, VT.data(), n);
+    if (info != 0)
+        return info;
+
+    double max_sv = *std::max_element(S.begin(), S.end());
+    double threshold = max_sv * n * std::numeric_limits<double>::epsilon();
+    for (int i = 0; i < n; ++i) {
+        double s_inv = (S[i] > threshold) ? 1.0 / S[i] : 0.0;
+        for (int j = 0; j < n; ++j)
+            VT[(size_t)i * n + j] *= s_inv;
+    }
+
+    called_routines.push_back("dgemm");
+    rapl.phase("dgemm");
+    memory.phase("dgemm");
+    cblas_dgemm(CblasRowMajor, CblasTrans, CblasTrans,
+                n, n, n,
+                1.0, VT.data(), n,
+                U.data(), n,
+                0.0, A_inv, n);
+    return 0;
+}
+
+// Параметры рекурсивного обращения блоками 2x2
+struct RecursiveOptions {
+    int base;           // размер блока, который обращается через LAPACK
+    int base_threads;   // потоки BLAS в листьях рекурсии
+    int threads;        // потоки BLAS для dgemm на уровнях рекурсии
+};
+
+// Рекурсивное обращение матрицы общего вида (n x n, ведущая размерность ld) на месте:
+//   X11 = A11^{-1},  W = X11 A12,  V = A21 X11,  S = A22 - A21 W,  X22 = S^{-1},
+//   X12 = -W X22,  X21 = -X22 V,  X11 += W X22 V.
+// Выбор ведущего элемента есть только внутри листьев, поэтому метод рассчитан
+// на матрицы с невырожденными ведущими блоками (как у генератора набора);
+// качество результата показывает DIAG_RESIDUAL.
+int recursive_invert_block(double* A, int n, int ld, const RecursiveOptions& opt) {
+    if (n <= opt.base) {
+        std::vector<lapack_int> ipiv(n);
+        mkl_set_num_threads(opt.base_threads);
+        int info = LAPACKE_dgetrf(LAPACK_ROW_MAJOR, n, n, A, ld, ipiv.data());
+        if (info == 0)
+            info = LAPACKE_dgetri(LAPACK_ROW_MAJOR, n, A, ld, ipiv.data());
+        mkl_set_num_threads(opt.threads);
+        return info;
+    }
+
+    int n1 = n / 2;
+    int n2 = n - n1;
+    double* A11 = A;
+    double* A12 = A + n1;
+    double* A21 = A + (size_t)n1 * ld;
+    double* A22 = A + (size_t)n1 * ld + n1;
+
+    int info = recursive_invert_block(A11, n1, ld, opt);
+    if (info != 0)
+        return info;
+
+    std::vector<double> W((size_t)n1 * n2);
+    std::vector<double> V((size_t)n2 * n1);
+    cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+                n1, n2, n1,
+                1.0, A11, ld,
+                A12, ld,
+                0.0, W.data(), n2);
+    cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+                n2, n1, n1,
+                1.0, A21, ld,
+                A11, ld,
+                0.0, V.data(), n1);
+    cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+                n2, n2, n1,
+                -1.0, A21, ld,
+                W.data(), n2,
+                1.0, A22, ld);
+
+    info = recursive_invert_block(A22, n2, ld, opt);
+    if (info != 0)
+        return n1 + info;
+
+    cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+                n1, n2, n2,
+                -1.0, W.data(), n2,
+                A22, ld,
+                0.0, A12, ld);
+    cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+                n2, n1, n2,
+                -1.0, A22, ld,
+                V.data(), n1,
+                0.0, A21, ld);
+    cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans,
+                n1, n1, n2,
+                -1.0, A12, ld,
+                V.data(), n1,
+                1.0, A11, ld);
+    return 0;
+}
+
+int recursive_invert(double* A, int n, const RecursiveOptions& opt) {
+    called_routines.push_back("dgetrf");
+    called_routines.push_back("dgetri");
+    called_routines.push_back("dgemm");
+    rapl.phase("recursive");
+    memory.phase("recursive");
+    mkl_set_num_threads(opt.threads);
+    return recursive_invert_block(A, n, n, opt);
+}
+
+// Невязка ||A (X v) - v|| / (||A||_F ||X||_F ||v||) на случайном векторе v за O(n^2)
+// вместо полного произведения A X
+double probe_residual(const double* A, const double* X, int n) {
+    std::mt19937 gen(n + 2);
+    std::uniform_real_distribution<> dis(-1.0, 1.0);
+    std::vector<double> v(n), Xv(n), r(n);
+    for (double& x : v)
+        x = dis(gen);
+
+    cblas_dgemv(CblasRowMajor, CblasNoTrans, n, n, 1.0, X, n, v.data(), 1, 0.0, Xv.data(), 1);
+    r = v;
+    cblas_dgemv(CblasRowMajor, CblasNoTrans, n, n, 1.0, A, n, Xv.data(), 1, -1.0, r.data(), 1);
+
+    double norm_A = cblas_dnrm2((size_t)n * n, A, 1);
+    double norm_X = cblas_dnrm2((size_t)n * n, X, 1);
+    return cblas_dnrm2(n, r.data(), 1) / (norm_A * norm_X * cblas_dnrm2(n, v.data(), 1));
+}
+
+// Рост элементов и инерция по множителям (строчный формат, нижний треугольник)
+struct FactorStats {
+    double growth = 0.0;  // max|U| для LU, max|D| для Банча–Кауфмана, max|T| для Аасена; делённое на max|A|
+    double max_l = 0.0;   // max|L| вне диагонали
+    int positive = 0, negative = 0, zero = 0;
+};
+
+double max_abs(const double* A, size_t count) {
+    double m = 0.0;
+    for (size_t k = 0; k < count; ++k)
+        m = std::max(m, std::abs(A[k]));
+    return m;
+}
+
+// dgetrf: U – верхний треугольник с диагональю, L – строго нижний
+FactorStats lu_stats(const double* F, int n, double amax) {
+    FactorStats s;
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < n; ++j) {
+            double v = std::abs(F[(size_t)i * n + j]);
+            if (j >= i)
+                s.growth = std::max(s.growth, v);
+            else
+                s.max_l = std::max(s.max_l, v);
+        }
+    s.growth /= amax;
+    return s;
+}
+
+// dsytrf ('L'): ipiv[k] > 0 – блок D 1x1, ipiv[k] = ipiv[k+1] < 0 – блок 2x2
+// с внедиагональным элементом в (k+1, k). Инерция A равна инерции D
+FactorStats bunch_kaufman_stats(const double* F, const lapack_int* ipiv, int n, double amax) {
+    FactorStats s;
+    for (int k = 0; k < n;) {
+        int block = (ipiv[k] < 0 && k + 1 < n) ? 2 : 1;
+        double a = F[(size_t)k * n + k];
+        if (block == 1) {
+            s.growth = std::max(s.growth, std::abs(a));
+            (a > 0 ? s.positive : a < 0 ? s.negative : s.zero) += 1;
+        } else {
+            double b = F[(size_t)(k + 1) * n + k], c = F[(size_t)(k + 1) * n + k + 1];
+            s.growth = std::max({s.growth, std::abs(a), std::abs(b), std::abs(c)});
+            double det = a * c - b * b;
+            if (det < 0) {
+                ++s.positive;
+                ++s.negative;
+            } else if (det > 0) {
+                (a > 0 ? s.positive : s.negative) += 2;
+            } else {
+                s.zero += (a == 0 && b == 0 && c == 0) ? 2 : 1;
+                if (a + c != 0)
+                    (a + c > 0 ? s.positive : s.negative) += 1;
+            }
+        }
+        for (int j = k; j < k + block; ++j)
+            for (int i = k + block; i < n; ++i)
+                s.max_l = std::max(s.max_l, std::abs(F[(size_t)i * n + j]));
+        k += block;
+    }
+    s.growth /= amax;
+    return s;
+}
+
+// dsytrf_aa ('L'): трёхдиагональная T на диагонали и первой поддиагонали,
+// L(i, k+1) хранится в (i, k) при i >= k + 2. Инерция T – по знакам ведущих
+// элементов её разложения без выбора (закон инерции Сильвестра)
+FactorStats aasen_stats(const double* F, int n, double amax) {
+    FactorStats s;
+    double d = 0.0, tiny = std::numeric_limits<double>::min();
+    for (int k = 0; k < n; ++k) {
+        double diag = F[(size_t)k * n + k];
+        double sub = (k > 0) ? F[(size_t)k * n + k - 1] : 0.0;
+        s.growth = std::max({s.growth, std::abs(diag), std::abs(sub)});
+        d = (k == 0) ? diag : diag - sub * sub / (d != 0.0 ? d : tiny);
+        (d > 0 ? s.positive : d < 0 ? s.negative : s.zero) += 1;
+        for (int i = k + 2; i < n; ++i)
+            s.max_l = std::max(s.max_l, std::abs(F[(size_t)i * n + k]));
+    }
+    s.growth /= amax;
+    return s;
+}
+
+std::string format_stats(const std::string& name, const FactorStats& s) {
+    std::ostringstream oss;
+    oss << std::scientific << std::setprecision(3) << name << ":growth=" << s.growth << ":max_l=" << s.max_l;
+    return oss.str();
+}
+
+// Профиль холодного старта (--cold=K): из чего складывается первый вызов в процессе.
+// startup – от exec до main: загрузка библиотек и их конструкторы (OpenBLAS здесь
+// создаёт потоки), точность – такт /proc, обычно 10 мс; init – первый вызов на
+// матрице 8 x 8: выбор ядер по CPU, связывание символов, рабочие буферы;
+// threads – первый dgemm 512 x 512 минус повторный: запуск или пробуждение пула
+// потоков; touch – первое касание нового буфера n x n, по записи на страницу;
+// first и warm – первое и K следующих обращений матрицы n x n
+struct ColdProfile {
+    double startup = 0.0;
+    double init = 0.0;
+    double threads = 0.0;
+    double touch = 0.0;
+    long touch_faults = 0;
+    double first = 0.0;
+    long first_faults = 0;
+    std::vector<double> warm;
+    long warm_faults = 0;  // максимум за тёплый вызов
+
+    void report() const {
+        std::streamsize precision = std::cout.precision(9);
+        std::vector<double> sorted = warm;
+        std::sort(sorted.begin(), sorted.end());
+        double median = sorted.empty() ? first : sorted[sorted.size() / 2];
+        // Цена страничного отказа – по касанию нового буфера
+        double fault_seconds = touch_faults ? touch / touch_faults : 0.0;
+        std::cout << "DIAG_COLD_STARTUP=" << startup << std::endl;
+        std::cout << "DIAG_COLD_INIT=" << init << std::endl;
+        std::cout << "DIAG_COLD_THREADS=" << threads << std::endl;
+        std::cout << "DIAG_COLD_TOUCH=" << touch << ":" << touch_faults << std::endl;
+        std::cout << "DIAG_COLD_CALLS=first:" << first << ",warm_best:" << (sorted.empty() ? first : sorted[0])
+                  << ",warm_median:" << median << ",warm_calls:" << warm.size() << std::endl;
+        std::cout << "DIAG_COLD_FAULTS=first:" << first_faults << ",warm:" << warm_faults
+                  << ",first_seconds:" << (first_faults - warm_faults) * fault_seconds << std::endl;
+        std::cout << "DIAG_COLD_OVERHEAD=first_call:" << first - median
+                  << ",total:" << startup + init + threads + first - median << std::endl;
+        std::cout.precision(precision);
+    }
+};
+
+// Возраст процесса: starttime (22-е поле /proc/self/stat) в тактах с загрузки системы
+double process_age() {
+    std::ifstream stat("/proc/self/stat");
+    std::string line;
+    std::getline(stat, line);
+    size_t paren = line.rfind(')');
+    if (paren == std::string::npos)
+        return 0.0;
+    // Поля после имени процесса нумеруются с 3-го
+    std::istringstream fields(line.substr(paren + 1));
+    std::string field;
+    for (int i = 3; i <= 22; ++i)
+        if (!(fields >> field))
+            return 0.0;
+    struct timespec now;
+    clock_gettime(CLOCK_BOOTTIME, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9 - std::stod(field) / sysconf(_SC_CLK_TCK);
+}
+
+long minor_faults() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt;
+}
+
+// invert(X, m) обращает X на месте и возвращает info. Вызывается до остальных
+// вызовов библиотеки, иначе init и threads окажутся тёплыми
+template<class Invert>
+int cold_profile(ColdProfile& p, const double* A, int n, int warm_calls, Invert&& invert) {
+    using clock = std::chrono::steady_clock;
+    auto seconds = [](clock::time_point start) {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    };
+
+    // 8 x 8 с диагональным преобладанием: SPD и невырожденная
+    const int small = 8;
+    std::vector<double> tiny((size_t)small * small);
+    for (int i = 0; i < small; ++i)
+        for (int j = 0; j < small; ++j)
+            tiny[i * small + j] = (i == j) ? small : 1.0 / (1 + i + j);
+    auto start = clock::now();
+    int info = invert(tiny.data(), small);
+    p.init = seconds(start);
+    if (info != 0)
+        return info;
+
+    const int g = 512;
+    std::vector<double> a(g * g, 1.0 / g), b(g * g, 1.0 / g), c(g * g);
+    for (int r = 0; r < 2; ++r) {
+        start = clock::now();
+        cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, g, g, g, 1.0, a.data(), g, b.data(), g, 0.0, c.data(), g);
+        p.threads = (r == 0) ? seconds(start) : p.threads - seconds(start);
+    }
+    p.threads = std::max(0.0, p.threads);
+
+    // Новые страницы берутся прямо у mmap: куча могла бы вернуть уже тронутые
+    size_t bytes = (size_t)n * n * sizeof(double);
+    void* fresh = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (fresh != MAP_FAILED) {
+        long page = sysconf(_SC_PAGESIZE);
+        long faults = minor_faults();
+        start = clock::now();
+        for (size_t offset = 0; offset < bytes; offset += page)
+            static_cast<volatile char*>(fresh)[offset] = 1;
+        p.touch = seconds(start);
+        p.touch_faults = minor_faults() - faults;
+        munmap(fresh, bytes);
+    }
+
+    // Копия в уже тронутый буфер не входит во время вызова
+    std::vector<double> work(A, A + (size_t)n * n);
+    for (int r = 0; r <= warm_calls; ++r) {
+        if (r)
+            std::copy(A, A + (size_t)n * n, work.begin());
+        long faults = minor_faults();
+        start = clock::now();
+        info = invert(work.data(), n);
+        double t = seconds(start);
+        faults = minor_faults() - faults;
+        if (info != 0)
+            return info;
+        if (r == 0) {
+            p.first = t;
+            p.first_faults = faults;
+        } else {
+            p.warm.push_back(t);
+            p.warm_faults = std::max(p.warm_faults, faults);
+        }
+    }
+    return 0;
+}
+
+// Обращение итерацией Ньютона–Шульца X_{k+1} = X_k (2I - A X_k) = X_k + X_k R_k,
+// R_k = I - A X_k. На шаг два dgemm без последовательной работы с панелями,
+// поэтому по потокам метод масштабируется как умножение. R_{k+1} = R_k^2, и при
+// ||R_0|| < 1 сходимость квадратичная. Начальное приближение:
+//   identity  – X_0 = I / ||A||_inf: для SPD спектр R_0 лежит в [0, 1);
+//   transpose – X_0 = A^T / (||A||_1 ||A||_inf): годится для любой невырожденной A;
+//   auto      – identity для симметричной A с положительной диагональю, иначе
+//               transpose (по умолчанию во всех программах).
+// Тёплый старт берёт X_0 из прежней обратной медленно меняющейся матрицы.
+// Если невязка растёт, итерация начинается заново с transpose. Застой ниже
+// уровня округления n eps ||A||_1 ||X||_1 принимается со статусом floor
+struct NewtonOptions {
+    std::string start = "auto";
+    double tolerance = 1e-12;  // по ||R||_F / sqrt(n)
+    int max_iterations = 100;
+};
+
+struct NewtonResult {
+    int iterations = 0;
+    int products = 0;       // вызовов dgemm n x n x n
+    double residual = 0.0;  // ||I - A X||_F / sqrt(n) на последнем шаге
+    std::string start;      // приближение, от которого сошлась итерация
+    // converged – невязка не выше допуска; floor – застой на уровне округления;
+    // stalled – застой выше него; max_iter – исчерпан лимит итераций
+    std::string status;
+    bool converged = false;  // converged или floor
+};
+
+// X: на входе – тёплое приближение (при warm), на выходе – обратная
+NewtonResult newton_schulz_invert(const double* A, int n, double* X, bool warm, const NewtonOptions& opt) {
+    size_t nn = (size_t)n * n;
+    std::vector<double> R(nn), next(nn);
+    NewtonResult result;
+    auto initial = [&](std::string start) {
+        if (start == "auto") {
+            bool spd_like = true;
+            for (int i = 0; i < n && spd_like; ++i) {
+                spd_like = (A[(size_t)i * n + i] > 0.0);
+                for (int j = 0; j < i && spd_like; ++j)
+                    spd_like = (A[(size_t)i * n + j] == A[(size_t)j * n + i]);
+            }
+            start = spd_like ? "identity" : "transpose";
+        }
+        result.start = start;
+        std::fill(X, X + nn, 0.0);
+        if (start == "identity") {
+            double scale = 1.0 / LAPACKE_dlange(LAPACK_ROW_MAJOR, 'I', n, n, A, n);
+            for (int i = 0; i < n; ++i)
+                X[(size_t)i * n + i] = scale;
+        } else {
+            double scale = 1.0 / (LAPACKE_dlange(LAPACK_ROW_MAJOR, '1', n, n, A, n) *
+                                  LAPACKE_dlange(LAPACK_ROW_MAJOR, 'I', n, n, A, n));
+            for (int i = 0; i < n; ++i)
+                for (int j = 0; j < n; ++j)
+                    X[(size_t)j * n + i] = scale * A[(size_t)i * n + j];
+        }
+    };
+    if (warm)
+        result.start = "warm";
+    else
+        initial(opt.start);
+
+    double previous = std::numeric_limits<double>::infinity();
+    for (;;) {
+        cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, n, n, n,
+                    -1.0, A, n, X, n, 0.0, R.data(), n);
+        ++result.products;
+        for (int i = 0; i < n; ++i)
+            R[(size_t)i * n + i] += 1.0;
+        double r = cblas_dnrm2(nn, R.data(), 1) / std::sqrt((double)n);
+        result.residual = r;
+        if (r <= opt.tolerance) {
+            result.status = "converged";
+            result.converged = true;
+            break;
+        }
+        if (r >= previous) {
+            // Застой: ошибки округления в A X порядка n eps ||A|| ||X||, ниже
+            // невязка не опустится. Такой результат годится, но это не допуск
+            double floor = n * std::numeric_limits<double>::epsilon() *
+                           LAPACKE_dlange(LAPACK_ROW_MAJOR, '1', n, n, A, n) *
+                           LAPACKE_dlange(LAPACK_ROW_MAJOR, '1', n, n, X, n);
+            if (r <= floor) {
+                result.status = "floor";
+                result.converged = true;
+                break;
+            }
+            if (result.start == "transpose") {
+                result.status = "stalled";
+                break;
+            }
+            initial("transpose");
+            previous = std::numeric_limits<double>::infinity();
+            continue;
+        }
+        if (result.iterations == opt.max_iterations) {
+            result.status = "max_iter";
+            break;
+        }
+        previous = r;
+
+        // X <- X + X R
+        std::copy(X, X + nn, next.begin());
+        cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, n, n, n,
+                    1.0, X, n, R.data(), n, 1.0, next.data(), n);
+        ++result.products;
+        std::copy(next.begin(), next.end(), X);
+        ++result.iterations;
+    }
+    return result;
+}
+
+// Медленно меняющаяся матрица: A + drift * max|A| * E, E – симметричная со
+// случайными элементами из [-1, 1]; при малом drift симметрия и определённость
+// сохраняются
+std::vector<double> drifted_matrix(const double* A, int n, double drift) {
+    std::mt19937 gen(n + 3);
+    std::uniform_real_distribution<> dis(-1.0, 1.0);
+    double amax = 0.0;
+    for (size_t k = 0; k < (size_t)n * n; ++k)
+        amax = std::max(amax, std::abs(A[k]));
+    std::vector<double> B(A, A + (size_t)n * n);
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j <= i; ++j) {
+            double delta = drift * amax * dis(gen);
+            B[(size_t)i * n + j] += delta;
+            if (j != i)
+                B[(size_t)j * n + i] += delta;
+        }
+    return B;
+}
+
+// Ньютон–Шульц и факторизация при каждом числе потоков BLAS из списка "1,2,4":
+// строки {потоки, секунды Ньютона–Шульца, секунды факторизации}
+template<class SetThreads, class Factor>
+std::vector<std::array<double, 3>> newton_scaling(const std::string& list, const double* A, int n,
+                                                  const NewtonOptions& opt, SetThreads&& set_threads,
+                                                  Factor&& factor) {
+    std::vector<std::array<double, 3>> rows;
+    std::vector<double> X((size_t)n * n);
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        int threads = std::stoi(item);
+        set_threads(threads);
+        auto start = std::chrono::steady_clock::now();
+        newton_schulz_invert(A, n, X.data(), false, opt);
+        double newton = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::copy(A, A + (size_t)n * n, X.begin());
+        start = std::chrono::steady_clock::now();
+        factor(X.data(), n);
+        double factorization = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        rows.push_back({(double)threads, newton, factorization});
+    }
+    return rows;
+}
+
+// Признаки переподписки ядер: несколько рантаймов OpenMP в одном процессе,
+// разрешённые вложенные параллельные участки и потоков больше, чем CPU.
+// Пулы потоков BLAS живут до выхода, поэтому снимок после замера их застаёт
+struct Oversubscription {
+    std::vector<std::string> runtimes;  // iomp5, gomp, omp, tbb
+    int threads = 0;
+    int cpus = 0;
+    int levels = 1;
+
+    static Oversubscription detect() {
+        Oversubscription o;
+        std::ifstream maps("/proc/self/maps");
+        std::string line;
+        static const std::pair<const char*, const char*> libraries[] = {
+            {"/libiomp5", "iomp5"}, {"/libgomp", "gomp"}, {"/libomp.", "omp"}, {"/libtbb.", "tbb"}};
+        while (std::getline(maps, line))
+            for (const auto& library : libraries)
+                if (line.find(library.first) != std::string::npos &&
+                    std::find(o.runtimes.begin(), o.runtimes.end(), library.second) == o.runtimes.end())
+                    o.runtimes.push_back(library.second);
+
+        std::ifstream status("/proc/self/status");
+        while (std::getline(status, line))
+            if (line.rfind("Threads:", 0) == 0)
+                o.threads = std::atoi(line.c_str() + 8);
+
+        cpu_set_t allowed;
+        sched_getaffinity(0, sizeof(allowed), &allowed);
+        o.cpus = CPU_COUNT(&allowed);
+
+        // Функции OpenMP ищутся в уже загруженных библиотеках: программа с OpenMP не связана
+        using LevelsFn = int (*)();
+        if (auto max_levels = (LevelsFn)dlsym(RTLD_DEFAULT, "omp_get_max_active_levels"))
+            o.levels = max_levels();
+        return o;
+    }
+
+    // Главный поток плюс один служебный допустимы сверх числа CPU
+    std::string problems() const {
+        std::vector<std::string> found;
+        int openmp = (int)runtimes.size() - (int)std::count(runtimes.begin(), runtimes.end(), "tbb");
+        if (openmp > 1) {
+            std::string list;
+            for (const std::string& r : runtimes)
+                if (r != "tbb")
+                    list += (list.empty() ? "" : "+") + r;
+            found.push_back("runtimes:" + list);
+        }
+        if (levels > 1)
+            found.push_back("nested:" + std::to_string(levels));
+        if (threads > cpus + 1)
+            found.push_back("threads:" + std::to_string(threads) + ">" + std::to_string(cpus));
+        std::string joined;
+        for (const std::string& f : found)
+            joined += (joined.empty() ? "" : ";") + f;
+        return joined.empty() ? "none" : joined;
+    }
+
+    std::string summary() const {
+        std::string list;
+        for (const std::string& r : runtimes)
+            list += (list.empty() ? "" : "+") + r;
+        return "runtimes:" + (list.empty() ? std::string("none") : list) + ",threads:" + std::to_string(threads) +
+               ",cpus:" + std::to_string(cpus) + ",levels:" + std::to_string(levels);
+    }
+};
+
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <matrix_size>" << std::endl;
+    // Возраст процесса – до разбора параметров и чтения --input
+    double age = process_age();
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <matrix_size>|--input=path [--input-shape=RxC] [--rcond-threshold=value] [--on-ill=abort|svd]"
+                  << " [--method=lapack|recursive|sytrf|aasen|newton] [--rec-base=256] [--rec-base-threads=N]"
+                  << " [--matrix=spd|kkt] [--negative=K] [--compare=1|0]"
+                  << " [--ns-start=auto|identity|transpose] [--ns-tol=1e-12] [--ns-max-iter=100] [--warm-start=path] [--drift=eps] [--ns-threads=1,2,4]"
+                  << " [--placement=none|all|cores|socket|socket-cores|pcores|pcores-nosmt|ecores] [--cold=K]"
+                  << " [--threading=intel|gnu|tbb|sequential] [--trace=trace.json]" << std::endl;
         return 1;
     }
 
-    int n = std::atoi(argv[1]);
+    int n;
+    int first = size_argument(argc, argv, n);
+
+    std::map<std::string, std::string> options;
+    Placement placement("none");
+    InputMatrix A;
+    try {
+        options = parse_options(argc, argv, first);
+        if (!threading.error.empty())
+            throw std::invalid_argument(threading.error);
+        A = load_input(options, "input", n);
+        placement = Placement(option(options, "placement", "none"));
+    } catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
     if (n <= 0) {
         std::cerr << "Matrix size must be positive" << std::endl;
         return 1;
     }
+    // С 32-битным MKL_INT n*n элементов не адресуются при n > 46340: нужна сборка ILP64
+    if (sizeof(MKL_INT) < 8 && (long long)n * n > std::numeric_limits<MKL_INT>::max()) {
+        std::cerr << "Matrix size too large for 32-bit MKL_INT: use the ILP64 build" << std::endl;
+        return 1;
+    }
+
+    // Потоки BLAS закрепляются до первого вызова библиотеки
+    placement.pin_blas_threads();
+
+    // Порог оценки обратного числа обусловленности; 0 – только отчёт
+    double rcond_threshold = std::stod(option(options, "rcond-threshold", "0"));
+    std::string on_ill = option(options, "on-ill", "abort");
+    if (on_ill != "abort" && on_ill != "svd") {
+        std::cerr << "Unknown --on-ill action: " << on_ill << std::endl;
+        return 1;
+    }
+    std::string method = option(options, "method", "lapack");
+    if (method != "lapack" && method != "recursive" && method != "sytrf" && method != "aasen" && method != "newton") {
+        std::cerr << "Unknown --method: " << method << std::endl;
+        return 1;
+    }
+    // sytrf (Банч–Кауфман) и aasen – симметричное неопределённое LDL^T;
+    // с ними и с Ньютоном–Шульцем для сравнения выполняется и LU
+    bool symmetric = (method == "sytrf" || method == "aasen");
+    bool compare = (symmetric || method == "newton") && option(options, "compare", "1") != "0";
+
+    // Ньютон–Шульц: начальное приближение, допуск и тёплый старт
+    NewtonOptions newton;
+    newton.start = option(options, "ns-start", "auto");
+    newton.tolerance = std::stod(option(options, "ns-tol", "1e-12"));
+    newton.max_iterations = std::max(1, std::stoi(option(options, "ns-max-iter", "100")));
+    if (newton.start != "auto" && newton.start != "identity" && newton.start != "transpose") {
+        std::cerr << "Unknown --ns-start: " << newton.start << std::endl;
+        return 1;
+    }
+    double drift = std::stod(option(options, "drift", "0"));
+    bool warm = (method == "newton" && (drift > 0.0 || options.count("warm-start")));
+    NewtonResult ns;
+    // Генератор: spd – как раньше, kkt – неопределённая с negative отрицательными
+    // собственными значениями
+    std::string kind = option(options, "matrix", "spd");
+    int negative = std::atoi(option(options, "negative", std::to_string(n / 4)).c_str());
+    if (kind != "spd" && kind != "kkt") {
+        std::cerr << "Unknown --matrix: " << kind << std::endl;
+        return 1;
+    }
+    if (kind == "kkt" && (negative < 0 || 2 * negative > n)) {
+        std::cerr << "--negative must be between 0 and n/2" << std::endl;
+        return 1;
+    }
 
     // Получаем текущее число потоков MKL 
     int num_threads = mkl_get_max_threads();
 
-    // Выделяем память и генерируем матрицу
-    std::vector<double> A(n * n);
-    std::vector<double> A_inv(n * n);
-    generate_positive_definite_matrix(A.data(), n, n);
-    A_inv = A;   // копия для обращения
+    RecursiveOptions recursion;
+    recursion.base = std::max(1, std::atoi(option(options, "rec-base", "256").c_str()));
+    recursion.base_threads = std::atoi(option(options, "rec-base-threads", std::to_string(num_threads)).c_str());
+    recursion.threads = num_threads;
+
+    std::vector<double> A_inv((size_t)n * n);
+    // Генерация, копия и проверка – вспомогательные стадии (на E-ядрах при --placement)
+    placement.run_aux([&] {
+        if (A.size() == 0) {
+            memory.phase("generate");
+            std::vector<double> generated((size_t)n * n);
+            if (kind == "kkt")
+                generate_kkt_matrix(generated.data(), n, negative, n);
+            else
+                generate_positive_definite_matrix(generated.data(), n, n);
+            A = InputMatrix(std::move(generated), n, n);
+        }
+        memory.phase("copy");
+        std::copy(A.begin(), A.end(), A_inv.begin());   // копия для обращения
+    });
 
     std::vector<lapack_int> ipiv(n);
+    // У Аасена обратная получается решением A X = I, и множители переезжают сюда
+    std::vector<double> factors(method == "aasen" ? (size_t)n * n : 0);
+    double amax = max_abs(A.data(), A.size());
+    FactorStats stats;
 
     // Засекаем время
+
+    // Тёплый старт Ньютона–Шульца: обратная из файла или обратная матрицы до
+    // сдвига на --drift (считается здесь, вне замера)
+    if (warm) {
+        try {
+            if (drift > 0.0) {
+                memory.phase("drift");
+                newton_schulz_invert(A.data(), n, A_inv.data(), false, newton);
+                A = InputMatrix(drifted_matrix(A.data(), n, drift), n, n);
+            } else {
+                InputMatrix guess = load_input(options, "warm-start", n);
+                std::copy(guess.begin(), guess.end(), A_inv.begin());
+            }
+        } catch (const std::invalid_argument& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    // Профиль холодного старта; основной замер после него уже тёплый
+    int cold_calls = std::max(0, std::stoi(option(options, "cold", "0")));
+    ColdProfile cold;
+    if (cold_calls > 0) {
+        memory.phase("cold-profile");
+        cold.startup = age;
+        int cold_info = cold_profile(cold, A.data(), n, cold_calls, [](double* X, int m) {
+            std::vector<lapack_int> pivots(m);
+            int info = LAPACKE_dgetrf(LAPACK_ROW_MAJOR, m, m, X, m, pivots.data());
+            return info != 0 ? info : LAPACKE_dgetri(LAPACK_ROW_MAJOR, m, X, m, pivots.data());
+        });
+        if (cold_info != 0) {
+            std::cerr << "Error in cold-start profile" << std::endl;
+            return 1;
+        }
+    }
+
+    rapl.start();
     auto start = std::chrono::steady_clock::now();
 
-    // LU-разложение
-    called_routines.push_back("dgetrf");
-    int info = LAPACKE_dgetrf(LAPACK_ROW_MAJOR, n, n, A_inv.data(), n, ipiv.data());
-    if (info != 0) {
-        std::cerr << "LU decomposition failed with code: " << info << std::endl;
-        return 1;
+    // 1-норма для dgecon/dsycon считается до факторизации за O(n^2)
+    const char* norm_routine = symmetric ? "dlansy" : "dlange";
+    called_routines.push_back(norm_routine);
+    rapl.phase(norm_routine);
+    memory.phase(norm_routine);
+    double anorm = symmetric ? LAPACKE_dlansy(LAPACK_ROW_MAJOR, '1', 'L', n, A.data(), n)
+                             : LAPACKE_dlange(LAPACK_ROW_MAJOR, '1', n, n, A.data(), n);
+
+    int info;
+    double rcond = 0.0;
+    bool ill_conditioned;
+    if (method == "recursive") {
+        // Рекурсия обращает матрицу целиком, поэтому rcond здесь точный
+        // (по нормам A и A^{-1}), но проверяется уже после обращения
+        info = recursive_invert(A_inv.data(), n, recursion);
+        if (info != 0 && on_ill != "svd") {
+            std::cerr << "Recursive inversion failed with code: " << info << std::endl;
+            return 1;
+        }
+        ill_conditioned = (info != 0);
+        if (!ill_conditioned) {
+            called_routines.push_back("dlange");
+            rapl.phase("dlange");
+            memory.phase("dlange");
+            rcond = 1.0 / (anorm * LAPACKE_dlange(LAPACK_ROW_MAJOR, '1', n, n, A_inv.data(), n));
+            ill_conditioned = (rcond < rcond_threshold);
+        }
+    } else if (method == "aasen") {
+        called_routines.push_back("dsytrf_aa");
+        rapl.phase("dsytrf_aa");
+        memory.phase("dsytrf_aa");
+        info = LAPACKE_dsytrf_aa(LAPACK_ROW_MAJOR, 'L', n, A_inv.data(), n, ipiv.data());
+        if (info != 0 && on_ill != "svd") {
+            std::cerr << "Aasen factorization failed with code: " << info << std::endl;
+            return 1;
+        }
+        ill_conditioned = (info != 0);
+        if (!ill_conditioned) {
+            stats = aasen_stats(A_inv.data(), n, amax);
+
+            // dsytri для множителей Аасена в LAPACK нет: обратная – решение A X = I
+            std::swap(A_inv, factors);
+            std::fill(A_inv.begin(), A_inv.end(), 0.0);
+            for (int i = 0; i < n; ++i)
+                A_inv[(size_t)i * n + i] = 1.0;
+            called_routines.push_back("dsytrs_aa");
+            rapl.phase("dsytrs_aa");
+            memory.phase("dsytrs_aa");
+            info = LAPACKE_dsytrs_aa(LAPACK_ROW_MAJOR, 'L', n, n, factors.data(), n, ipiv.data(), A_inv.data(), n);
+            if (info != 0) {
+                std::cerr << "Aasen solve failed with code: " << info << std::endl;
+                return 1;
+            }
+
+            // Оценки dsycon для Аасена тоже нет: rcond по нормам A и A^{-1}
+            called_routines.push_back("dlansy");
+            rapl.phase("dlansy");
+            memory.phase("dlansy");
+            rcond = 1.0 / (anorm * LAPACKE_dlansy(LAPACK_ROW_MAJOR, '1', 'L', n, A_inv.data(), n));
+            ill_conditioned = (rcond < rcond_threshold);
+        }
+    } else if (method == "sytrf") {
+        called_routines.push_back("dsytrf");
+        rapl.phase("dsytrf");
+        memory.phase("dsytrf");
+        info = LAPACKE_dsytrf(LAPACK_ROW_MAJOR, 'L', n, A_inv.data(), n, ipiv.data());
+        if (info != 0 && on_ill != "svd") {
+            std::cerr << "Bunch-Kaufman factorization failed with code: " << info << std::endl;
+            return 1;
+        }
+        ill_conditioned = (info != 0);
+        if (!ill_conditioned) {
+            stats = bunch_kaufman_stats(A_inv.data(), ipiv.data(), n, amax);
+            called_routines.push_back("dsycon");
+            rapl.phase("dsycon");
+            memory.phase("dsycon");
+            info = LAPACKE_dsycon(LAPACK_ROW_MAJOR, 'L', n, A_inv.data(), n, ipiv.data(), anorm, &rcond);
+            if (info != 0) {
+                std::cerr << "Condition number estimation failed with code: " << info << std::endl;
+                return 1;
+            }
+            ill_conditioned = (rcond < rcond_threshold);
+        }
+    } else if (method == "newton") {
+        // Обратная получается целиком, поэтому rcond – по нормам A и A^{-1}
+        called_routines.push_back("dgemm");
+        rapl.phase("dgemm");
+        memory.phase("dgemm");
+        ns = newton_schulz_invert(A.data(), n, A_inv.data(), warm, newton);
+        if (!ns.converged && on_ill != "svd") {
+            std::cerr << "Newton-Schulz iteration did not converge: residual=" << std::scientific << ns.residual << std::endl;
+            return 1;
+        }
+        ill_conditioned = !ns.converged;
+        if (!ill_conditioned) {
+            called_routines.push_back("dlange");
+            rapl.phase("dlange");
+            memory.phase("dlange");
+            rcond = 1.0 / (anorm * LAPACKE_dlange(LAPACK_ROW_MAJOR, '1', n, n, A_inv.data(), n));
+            ill_conditioned = (rcond < rcond_threshold);
+        }
+    } else {
+        // LU-разложение
+        called_routines.push_back("dgetrf");
+        rapl.phase("dgetrf");
+        memory.phase("dgetrf");
+        info = LAPACKE_dgetrf(LAPACK_ROW_MAJOR, n, n, A_inv.data(), n, ipiv.data());
+        if (info != 0 && on_ill != "svd") {
+            std::cerr << "LU decomposition failed with code: " << info << std::endl;
+            return 1;
+        }
+
+        // Оценка обусловленности по готовым множителям, до дорогого dgetri
+        ill_conditioned = (info != 0);
+        if (!ill_conditioned) {
+            called_routines.push_back("dgecon");
+            rapl.phase("dgecon");
+            memory.phase("dgecon");
+            info = LAPACKE_dgecon(LAPACK_ROW_MAJOR, '1', n, A_inv.data(), n, anorm, &rcond);
+            if (info != 0) {
+                std::cerr << "Condition number estimation failed with code: " << info << std::endl;
+                return 1;
+            }
+            ill_conditioned = (rcond < rcond_threshold);
+        }
     }
 
-    // Обращение через LU
-    called_routines.push_back("dgetri");
-    info = LAPACKE_dgetri(LAPACK_ROW_MAJOR, n, A_inv.data(), n, ipiv.data());
-    if (info != 0) {
-        std::cerr << "Matrix inversion failed with code: " << info << std::endl;
-        return 1;
+    if (ill_conditioned) {
+        if (on_ill == "abort") {
+            std::cerr << "Matrix is ill-conditioned: rcond=" << std::scientific << rcond << std::endl;
+            return 1;
+        }
+        info = svd_pseudo_inverse(A.data(), n, A_inv.data());
+        if (info != 0) {
+            std::cerr << "SVD pseudo-inverse failed with code: " << info << std::endl;
+            return 1;
+        }
+    } else if (method == "lapack") {
+        // Обращение через LU
+        called_routines.push_back("dgetri");
+        rapl.phase("dgetri");
+        memory.phase("dgetri");
+        info = LAPACKE_dgetri(LAPACK_ROW_MAJOR, n, A_inv.data(), n, ipiv.data());
+        if (info != 0) {
+            std::cerr << "Matrix inversion failed with code: " << info << std::endl;
+            return 1;
+        }
+    } else if (method == "sytrf") {
+        called_routines.push_back("dsytri2");
+        rapl.phase("dsytri2");
+        memory.phase("dsytri2");
+        info = LAPACKE_dsytri2(LAPACK_ROW_MAJOR, 'L', n, A_inv.data(), n, ipiv.data());
+        if (info != 0) {
+            std::cerr << "Matrix inversion failed with code: " << info << std::endl;
+            return 1;
+        }
+        for (int i = 0; i < n; ++i)
+            for (int j = i + 1; j < n; ++j)
+                A_inv[(size_t)i * n + j] = A_inv[(size_t)j * n + i];
     }
 
     auto end = std::chrono::steady_clock::now();
+    rapl.stop();
+    memory.phase("verify");
     std::chrono::duration<double> elapsed = end - start;
 
     // Пиковое потребление памяти
     struct rusage usage;
     getrusage(RUSAGE_SELF, &usage);
     long rss_kb = usage.ru_maxrss;   
+    Oversubscription oversubscription = Oversubscription::detect();
+
+    // Ньютон–Шульц и dgetrf + dgetri при разном числе потоков (после замера RSS)
+    std::vector<std::array<double, 3>> scaling;
+    if (method == "newton" && options.count("ns-threads")) {
+        scaling = newton_scaling(options["ns-threads"], A.data(), n, newton, [](int threads) { mkl_set_num_threads(threads); },
+                                 [](double* X, int m) {
+                                     std::vector<lapack_int> pivots(m);
+                                     int status = LAPACKE_dgetrf(LAPACK_ROW_MAJOR, m, m, X, m, pivots.data());
+                                     return status != 0 ? status : LAPACKE_dgetri(LAPACK_ROW_MAJOR, m, X, m, pivots.data());
+                                 });
+        mkl_set_num_threads(num_threads);
+    }
+
+    // Для сравнения – LU той же матрицы (после замера RSS): время dgetrf + dgetri,
+    // рост элементов и невязка
+    double lu_seconds = 0.0, lu_residual = 0.0;
+    FactorStats lu;
+    if (compare) {
+        std::vector<double> lu_inv(A.begin(), A.end());
+        std::vector<lapack_int> lu_ipiv(n);
+        auto lu_start = std::chrono::steady_clock::now();
+        info = LAPACKE_dgetrf(LAPACK_ROW_MAJOR, n, n, lu_inv.data(), n, lu_ipiv.data());
+        if (info == 0) {
+            lu = lu_stats(lu_inv.data(), n, amax);
+            info = LAPACKE_dgetri(LAPACK_ROW_MAJOR, n, lu_inv.data(), n, lu_ipiv.data());
+        }
+        lu_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - lu_start).count();
+        if (info != 0) {
+            std::cerr << "LU comparison failed with code: " << info << std::endl;
+            compare = false;
+        } else {
+            placement.run_aux([&] { lu_residual = probe_residual(A.data(), lu_inv.data(), n); });
+        }
+    }
 
     // Контрольная сумма обратной матрицы
     double checksum = 0.0;
@@ -89,6 +2245,10 @@ int main(int argc, char* argv[]) {
         checksum += v;
     }
 
+    // Невязка на случайном векторе
+    double residual = 0.0;
+    placement.run_aux([&] { residual = probe_residual(A.data(), A_inv.data(), n); });
+
     // Формируем строку DIAG_ROUTINES
     std::ostringstream routines_oss;
     for (size_t i = 0; i < called_routines.size(); ++i) {
@@ -99,11 +2259,66 @@ int main(int argc, char* argv[]) {
     std::cout << std::fixed << std::setprecision(9);
     std::cout << "RESULT_SECONDS=" << elapsed.count() << std::endl;
 
-    std::cout << "DIAG_THREADS=mkl/libmkl_rt:" << num_threads << std::endl;
+    std::cout << "DIAG_THREADS=mkl/libmkl_rt" << placement.label() << ":" << num_threads << std::endl;
+    std::cout << "DIAG_THREADING=" << threading.label() << "," << oversubscription.summary() << std::endl;
+    std::cout << "DIAG_OVERSUBSCRIPTION=" << oversubscription.problems() << std::endl;
+    std::cout << "DIAG_INDEX=" << (sizeof(MKL_INT) == 8 ? "ilp64" : "lp64") << std::endl;
+    placement.report();
     std::cout << "DIAG_PEAK_RSS_KB=" << rss_kb << std::endl;
     std::cout << "DIAG_ROUTINES=" << routines_oss.str() << std::endl;
+    if (A.format != "synthetic")
+        A.report();
 
-    std::cout << std::setprecision(6);
+    std::cout << std::scientific << std::setprecision(6);
+    std::cout << "DIAG_RCOND=" << rcond << std::endl;
+    if (method == "newton") {
+        std::cout << "DIAG_NS=iterations:" << ns.iterations << ",products:" << ns.products
+                  << ",residual:" << ns.residual << ",start:" << ns.start << ",status:" << ns.status << std::endl;
+    }
+    std::cout << "DIAG_RESIDUAL=" << residual << std::endl;
+    if (A.format == "synthetic" && kind == "kkt")
+        std::cout << "DIAG_MATRIX=kkt:negative=" << negative << std::endl;
+    if (symmetric) {
+        std::cout << "DIAG_INERTIA=positive:" << stats.positive << ",negative:" << stats.negative
+                  << ",zero:" << stats.zero << std::endl;
+        std::cout << "DIAG_PIVOT_GROWTH=" << format_stats(method, stats);
+        if (compare)
+            std::cout << "," << format_stats("lu", lu);
+        std::cout << std::endl;
+    }
+    if (compare) {
+        std::cout << "DIAG_LU_RESIDUAL=" << lu_residual << std::endl;
+        std::cout << std::fixed << std::setprecision(9);
+        std::cout << "DIAG_LU_SECONDS=" << lu_seconds << std::endl;
+        std::cout << std::setprecision(3);
+        std::cout << "DIAG_SPEEDUP_VS_LU=" << lu_seconds / elapsed.count() << std::endl;
+    }
+    if (!scaling.empty()) {
+        std::streamsize precision = std::cout.precision(9);
+        std::cout << std::fixed;
+        for (const std::array<double, 3>& row : scaling)
+            std::cout << "DIAG_NS_SCALING=threads:" << (int)row[0] << ",newton:" << row[1]
+                      << ",factor:" << row[2] << std::endl;
+        std::cout.precision(precision);
+    }
+    std::cout << std::fixed;
+    // Номинальное число операций обращения: LU (dgetrf + dgetri) 2n^3,
+    // Банч–Кауфман (dsytrf + dsytri2) n^3, Аасен (dsytrf_aa + dsytrs_aa с n правыми частями) 7n^3/3,
+    // Ньютон–Шульц 2n^3 на каждый dgemm
+    double flops = (method == "newton") ? 2.0 * ns.products * n * n * n
+                 : (method == "sytrf") ? 1.0 * n * n * n : (method == "aasen") ? 7.0 / 3.0 * n * n * n : 2.0 * n * n * n;
+    rapl.report(flops / 1e9);
+    if (cold_calls > 0)
+        cold.report();
+    memory.report();
+    if (trace::enabled()) {
+        std::string summary = trace::write();
+        if (summary.empty()) {
+            std::cerr << "Cannot write trace: " << trace::path() << std::endl;
+            return 1;
+        }
+        std::cout << "DIAG_TRACE=" << summary << std::endl;
+    }
     std::cout << "DIAG_CHECKSUM=" << checksum << std::endl;
 
     return 0;
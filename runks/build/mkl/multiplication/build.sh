@@ -19,6 +19,8 @@ build_container() {
 
 
 build_container "mkl_mul" "Dockerfile.mklmul"
+# 64-битные индексы для n > 46340
+build_container "mkl_mul_ilp64" "Dockerfile.mklmul_ilp64"
 
 
 cd ../
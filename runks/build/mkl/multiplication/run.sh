@@ -11,32 +11,41 @@ sizes=(2500 5000 7500 10000 12500 15000 17500 20000)
 # Количество запусков для каждого контейнера и размера
 runs=10
 
-# Запуск контейнеров
-for container in "${containers[@]}"; do
-    for size in "${sizes[@]}"; do
-        # Создаем файл для вывода для текущего контейнера и размера
-        output_file="${container}_size_${size}.txt"
-
-        for ((i=1; i<=runs; i++)); do
-            echo "Запуск контейнера $container с размером матрицы $size, запуск номер $i..."
+# Слои потоков MKL; у слоя по умолчанию (intel) имя файла прежнее
+variants=(intel gnu tbb sequential)
+default_variant=intel
+flag=--threading
 
-            # Запускаем контейнер в фоновом режиме и получаем его ID
-            container_id=$(docker run -d --rm "$container" "$size")
-            #echo docker run -d --rm "$container" "$size"
+# Запуск контейнеров
+for variant in "${variants[@]}"; do
+    for container in "${containers[@]}"; do
+        for size in "${sizes[@]}"; do
+            # Создаем файл для вывода для текущего контейнера и размера
+            suffix=""
+            [ "$variant" != "$default_variant" ] && suffix="_${variant}"
+            output_file="${container}${suffix}_size_${size}.txt"
+
+            for ((i=1; i<=runs; i++)); do
+                echo "Запуск контейнера $container (слой потоков MKL $variant) с размером матрицы $size, запуск номер $i..."
+
+                # Запускаем контейнер в фоновом режиме и получаем его ID
+                container_id=$(docker run -d --rm "$container" "$size" "${flag}=${variant}")
+                #echo docker run -d --rm "$container" "$size"
 	    
 
-            # # Запускаем мониторинг в фоновом режиме
+                # # Запускаем мониторинг в фоновом режиме
  
-            # # Ожидаем завершения контейнера и записываем его вывод в файл
-            docker logs -f "$container_id" >> "$output_file"
+                # # Ожидаем завершения контейнера и записываем его вывод в файл
+                docker logs -f "$container_id" >> "$output_file"
 
-            # # Ждем завершения контейнера
-            docker wait "$container_id"
+                # # Ждем завершения контейнера
+                docker wait "$container_id"
 
-            # # Останавливаем мониторинг
-            kill $monitor_pid
+                # # Останавливаем мониторинг
+                kill $monitor_pid
 
-            echo "Вывод контейнера $container с размером матрицы $size, запуск номер $i добавлен в $output_file"
+                echo "Вывод контейнера $container с размером матрицы $size, запуск номер $i добавлен в $output_file"
+            done
         done
     done
 done
@@ -0,0 +1,268 @@
+#pragma once
+// Обращение маленьких SPD-матриц фиксированного размера N <= 32 без LAPACK.
+// Размер известен при компиляции, поэтому циклы разворачиваются полностью, а
+// множитель Холецкого живёт в регистрах. Пакетная версия хранит W матриц в
+// формате «структура массивов»: элемент (i, j) всех матриц блока лежит подряд,
+// и одна AVX2/AVX-512 инструкция обрабатывает W матриц сразу.
+// Алгоритм: A = L L^T, W = L^{-1}, A^{-1} = W^T W
+#include <cmath>
+#include <algorithm>
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#if defined(__clang__)
+#define SPD_UNROLL _Pragma("unroll")
+#else
+#define SPD_UNROLL _Pragma("GCC unroll 32")
+#endif
+
+namespace spd {
+
+// Операции над регистром из width чисел double
+struct Scalar {
+    using reg = double;
+    static constexpr int width = 1;
+    static reg load(const double* p) { return *p; }
+    static void store(double* p, reg x) { *p = x; }
+    static reg set1(double x) { return x; }
+    static reg fmadd(reg a, reg b, reg c) { return a * b + c; }   // c + a*b
+    static reg fnmadd(reg a, reg b, reg c) { return c - a * b; }  // c - a*b
+    static reg mul(reg a, reg b) { return a * b; }
+    static reg div(reg a, reg b) { return a / b; }
+    static reg sqrt(reg a) { return std::sqrt(a); }
+    static reg min(reg a, reg b) { return std::min(a, b); }
+};
+
+#if defined(__AVX512F__)
+struct Simd {
+    using reg = __m512d;
+    static constexpr int width = 8;
+    static reg load(const double* p) { return _mm512_loadu_pd(p); }
+    static void store(double* p, reg x) { _mm512_storeu_pd(p, x); }
+    static reg set1(double x) { return _mm512_set1_pd(x); }
+    static reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_pd(a, b, c); }
+    static reg fnmadd(reg a, reg b, reg c) { return _mm512_fnmadd_pd(a, b, c); }
+    static reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+    static reg div(reg a, reg b) { return _mm512_div_pd(a, b); }
+    static reg sqrt(reg a) { return _mm512_sqrt_pd(a); }
+    static reg min(reg a, reg b) { return _mm512_min_pd(a, b); }
+};
+#define SPD_ISA "avx512"
+#elif defined(__AVX2__) && defined(__FMA__)
+struct Simd {
+    using reg = __m256d;
+    static constexpr int width = 4;
+    static reg load(const double* p) { return _mm256_loadu_pd(p); }
+    static void store(double* p, reg x) { _mm256_storeu_pd(p, x); }
+    static reg set1(double x) { return _mm256_set1_pd(x); }
+    static reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_pd(a, b, c); }
+    static reg fnmadd(reg a, reg b, reg c) { return _mm256_fnmadd_pd(a, b, c); }
+    static reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+    static reg div(reg a, reg b) { return _mm256_div_pd(a, b); }
+    static reg sqrt(reg a) { return _mm256_sqrt_pd(a); }
+    static reg min(reg a, reg b) { return _mm256_min_pd(a, b); }
+};
+#define SPD_ISA "avx2"
+#else
+using Simd = Scalar;
+#define SPD_ISA "scalar"
+#endif
+
+// Число матриц в одном блоке пакетного формата
+constexpr int batch_width = Simd::width;
+
+// Ядро для V::width матриц. Элемент (i, j) матрицы l лежит в a[(i*N + j)*V::width + l].
+// Возвращает минимальный ведущий элемент: не больше нуля – матрица не SPD
+template<int N, class V>
+inline typename V::reg invert_kernel(const double* a, double* x) {
+    using reg = typename V::reg;
+    constexpr int S = V::width;
+    // Нижние треугольники построчно: (i, j) -> i*(i+1)/2 + j
+    reg L[N * (N + 1) / 2];
+    reg W[N * (N + 1) / 2];
+    reg inv_diag[N];
+    reg pivot = V::set1(1.0);
+
+    // Холецкий по строкам: L(i,j) = (A(i,j) - sum_k L(i,k) L(j,k)) / L(j,j)
+    SPD_UNROLL
+    for (int i = 0; i < N; ++i) {
+        SPD_UNROLL
+        for (int j = 0; j <= i; ++j) {
+            reg s = V::load(a + (i * N + j) * S);
+            SPD_UNROLL
+            for (int k = 0; k < j; ++k)
+                s = V::fnmadd(L[i * (i + 1) / 2 + k], L[j * (j + 1) / 2 + k], s);
+            if (j < i) {
+                L[i * (i + 1) / 2 + j] = V::mul(s, inv_diag[j]);
+            } else {
+                pivot = (i == 0) ? s : V::min(pivot, s);
+                reg d = V::sqrt(s);
+                L[i * (i + 1) / 2 + i] = d;
+                inv_diag[i] = V::div(V::set1(1.0), d);
+            }
+        }
+    }
+
+    // W = L^{-1} по столбцам: W(i,j) = -(sum_{k=j}^{i-1} L(i,k) W(k,j)) / L(i,i)
+    SPD_UNROLL
+    for (int j = 0; j < N; ++j) {
+        W[j * (j + 1) / 2 + j] = inv_diag[j];
+        SPD_UNROLL
+        for (int i = j + 1; i < N; ++i) {
+            reg s = V::set1(0.0);
+            SPD_UNROLL
+            for (int k = j; k < i; ++k)
+                s = V::fnmadd(L[i * (i + 1) / 2 + k], W[k * (k + 1) / 2 + j], s);
+            W[i * (i + 1) / 2 + j] = V::mul(s, inv_diag[i]);
+        }
+    }
+
+    // A^{-1}(i,j) = sum_{k>=i} W(k,i) W(k,j), j <= i, и отражение в верхний треугольник
+    SPD_UNROLL
+    for (int i = 0; i < N; ++i) {
+        SPD_UNROLL
+        for (int j = 0; j <= i; ++j) {
+            reg s = V::set1(0.0);
+            SPD_UNROLL
+            for (int k = i; k < N; ++k)
+                s = V::fmadd(W[k * (k + 1) / 2 + i], W[k * (k + 1) / 2 + j], s);
+            V::store(x + (i * N + j) * S, s);
+            if (j != i)
+                V::store(x + (j * N + i) * S, s);
+        }
+    }
+    return pivot;
+}
+
+// Одна матрица в строчном порядке; false – матрица не SPD
+template<int N>
+inline bool invert_spd(const double* a, double* x) {
+    return invert_kernel<N, Scalar>(a, x) > 0.0;
+}
+
+// Один блок формата «структура массивов»: full матриц из src подряд, хвост до
+// batch_width добивается единичными матрицами, чтобы блок обрабатывался тем же
+// ядром. Внешний цикл – по элементам: блок пишется подряд, а full матриц
+// читаются последовательными потоками
+inline void pack_block(int n, const double* src, int full, double* block) {
+    constexpr int S = batch_width;
+    const size_t nn = (size_t)n * n;
+    for (size_t e = 0; e < nn; ++e) {
+        double* dst = block + e * S;
+        for (int l = 0; l < full; ++l)
+            dst[l] = src[(size_t)l * nn + e];
+        for (int l = full; l < S; ++l)
+            dst[l] = (e % (n + 1) == 0) ? 1.0 : 0.0;
+    }
+}
+
+inline void unpack_block(int n, const double* block, int full, double* dst) {
+    constexpr int S = batch_width;
+    const size_t nn = (size_t)n * n;
+    for (size_t e = 0; e < nn; ++e) {
+        const double* src = block + e * S;
+        for (int l = 0; l < full; ++l)
+            dst[(size_t)l * nn + e] = src[l];
+    }
+}
+
+// Перестановка count матриц n x n в блоки по batch_width
+inline void pack(int n, const double* matrices, int count, double* packed) {
+    constexpr int S = batch_width;
+    for (int first = 0; first < count; first += S)
+        pack_block(n, matrices + (size_t)first * n * n, std::min(S, count - first), packed + (size_t)first * n * n);
+}
+
+inline void unpack(int n, const double* packed, int count, double* matrices) {
+    constexpr int S = batch_width;
+    for (int first = 0; first < count; first += S)
+        unpack_block(n, packed + (size_t)first * n * n, std::min(S, count - first), matrices + (size_t)first * n * n);
+}
+
+// blocks блоков по batch_width матриц; возвращает число матриц, оказавшихся не SPD
+template<int N>
+inline int invert_spd_batch(const double* a, double* x, int blocks) {
+    constexpr int S = Simd::width;
+    int failed = 0;
+    for (int b = 0; b < blocks; ++b) {
+        double pivots[S];
+        Simd::store(pivots, invert_kernel<N, Simd>(a + (size_t)b * N * N * S, x + (size_t)b * N * N * S));
+        for (int l = 0; l < S; ++l)
+            failed += !(pivots[l] > 0.0);
+    }
+    return failed;
+}
+
+// count матриц в обычном строчном формате: каждый блок упаковывается в буфер,
+// который остаётся в кэше, обращается и сразу распаковывается. В память идут
+// только вход и результат, без промежуточных упакованных массивов
+template<int N>
+inline int invert_spd_packed(const double* a, double* x, int count) {
+    constexpr int S = Simd::width;
+    alignas(64) double in[N * N * S], out[N * N * S];
+    int failed = 0;
+    for (int first = 0; first < count; first += S) {
+        int full = std::min(S, count - first);
+        pack_block(N, a + (size_t)first * N * N, full, in);
+        double pivots[S];
+        Simd::store(pivots, invert_kernel<N, Simd>(in, out));
+        for (int l = 0; l < full; ++l)
+            failed += !(pivots[l] > 0.0);
+        unpack_block(N, out, full, x + (size_t)first * N * N);
+    }
+    return failed;
+}
+
+// Размеры, для которых собраны ядра; для остальных вызывающий код идёт в LAPACK
+#define SPD_SIZES(X) X(2) X(3) X(4) X(5) X(6) X(7) X(8) X(10) X(12) X(16) X(20) X(24) X(32)
+
+inline bool supported(int n) {
+    switch (n) {
+#define SPD_CASE(N) case N:
+        SPD_SIZES(SPD_CASE)
+#undef SPD_CASE
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Выбор ядра по размеру во время выполнения; -1 – размер не поддержан
+inline int invert_batch(int n, const double* a, double* x, int blocks) {
+    switch (n) {
+#define SPD_CASE(N) case N: return invert_spd_batch<N>(a, x, blocks);
+        SPD_SIZES(SPD_CASE)
+#undef SPD_CASE
+    default:
+        return -1;
+    }
+}
+
+inline int invert_packed(int n, const double* a, double* x, int count) {
+    switch (n) {
+#define SPD_CASE(N) case N: return invert_spd_packed<N>(a, x, count);
+        SPD_SIZES(SPD_CASE)
+#undef SPD_CASE
+    default:
+        return -1;
+    }
+}
+
+inline int invert_each(int n, const double* a, double* x, int count) {
+    switch (n) {
+#define SPD_CASE(N) \
+    case N: { \
+        int failed = 0; \
+        for (int m = 0; m < count; ++m) \
+            failed += !invert_spd<N>(a + (size_t)m * N * N, x + (size_t)m * N * N); \
+        return failed; \
+    }
+        SPD_SIZES(SPD_CASE)
+#undef SPD_CASE
+    default:
+        return -1;
+    }
+}
+
+}  // namespace spd
@@ -0,0 +1,413 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <map>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <limits>
+#include <cmath>
+#include <cstdlib>
+#include <mkl.h>
+#include <sys/resource.h>
+
+// Ленточные и разреженные SPD-системы: dpbtrf/dpbtrs и MKL PARDISO
+// (суперузловой Холецкий с упорядочением METIS)
+std::vector<std::string> called_routines;
+
+// Ленточная SPD-матрица в ленточном формате LAPACK: нижний треугольник,
+// хранение по столбцам, ab[(i - j) + j * (kd + 1)] = A(i, j)
+struct BandMatrix {
+    int n;
+    int kd;
+    std::vector<double> ab;
+};
+
+// Симметричная разреженная матрица в формате CSR, хранятся оба треугольника
+struct CsrMatrix {
+    int n;
+    std::vector<int> row_ptr;
+    std::vector<int> col;
+    std::vector<double> val;
+};
+
+// Случайная лента ширины kd, к диагонали добавляется число элементов строки ленты
+BandMatrix create_banded_spd_matrix(int n, int kd, int seed) {
+    BandMatrix A{n, kd, std::vector<double>((size_t)(kd + 1) * n, 0.0)};
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<> dis(0.0, 1.0);
+
+    for (int j = 0; j < n; ++j)
+        for (int i = j; i <= std::min(n - 1, j + kd); ++i)
+            A.ab[(i - j) + (size_t)j * (kd + 1)] = dis(gen);
+
+    for (int j = 0; j < n; ++j)
+        A.ab[(size_t)j * (kd + 1)] += 2 * kd + 1;
+
+    return A;
+}
+
+// Лапласиан случайного геометрического графа плюс единичная диагональ.
+// Вершины – случайные точки единичного квадрата, рёбра соединяют точки на
+// расстоянии меньше r, где r подобран под среднюю степень degree. Нумерация
+// вершин случайная, так что без упорядочения заполнение почти полное.
+CsrMatrix create_sparse_spd_matrix(int n, int degree, int seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<> dis(0.0, 1.0);
+
+    std::vector<double> x(n), y(n);
+    for (int i = 0; i < n; ++i) {
+        x[i] = dis(gen);
+        y[i] = dis(gen);
+    }
+
+    double radius = std::sqrt(degree / (M_PI * n));
+    int cells = std::max(1, int(1.0 / radius));
+    std::vector<std::vector<int>> grid(cells * cells);
+    auto cell_of = [cells](double c) { return std::min(cells - 1, int(c * cells)); };
+    for (int i = 0; i < n; ++i)
+        grid[cell_of(y[i]) * cells + cell_of(x[i])].push_back(i);
+
+    std::vector<std::vector<std::pair<int, double>>> adjacency(n);
+    for (int i = 0; i < n; ++i) {
+        int cx = cell_of(x[i]), cy = cell_of(y[i]);
+        for (int gy = std::max(0, cy - 1); gy <= std::min(cells - 1, cy + 1); ++gy)
+            for (int gx = std::max(0, cx - 1); gx <= std::min(cells - 1, cx + 1); ++gx)
+                for (int j : grid[gy * cells + gx]) {
+                    if (j <= i)
+                        continue;
+                    double dx = x[i] - x[j], dy = y[i] - y[j];
+                    if (dx * dx + dy * dy < radius * radius) {
+                        double w = dis(gen);
+                        adjacency[i].push_back({j, -w});
+                        adjacency[j].push_back({i, -w});
+                    }
+                }
+    }
+
+    CsrMatrix A{n, std::vector<int>(n + 1, 0), {}, {}};
+    for (int i = 0; i < n; ++i) {
+        double diagonal = 1.0;
+        for (const auto& entry : adjacency[i])
+            diagonal -= entry.second;
+        adjacency[i].push_back({i, diagonal});
+        std::sort(adjacency[i].begin(), adjacency[i].end());
+
+        for (const auto& entry : adjacency[i]) {
+            A.col.push_back(entry.first);
+            A.val.push_back(entry.second);
+        }
+        A.row_ptr[i + 1] = int(A.col.size());
+    }
+    return A;
+}
+
+void band_multiply(const BandMatrix& A, const double* x, double* y) {
+    int ld = A.kd + 1;
+    std::fill(y, y + A.n, 0.0);
+    for (int j = 0; j < A.n; ++j) {
+        y[j] += A.ab[(size_t)j * ld] * x[j];
+        for (int i = j + 1; i <= std::min(A.n - 1, j + A.kd); ++i) {
+            double a = A.ab[(i - j) + (size_t)j * ld];
+            y[i] += a * x[j];
+            y[j] += a * x[i];
+        }
+    }
+}
+
+void csr_multiply(const CsrMatrix& A, const double* x, double* y) {
+    for (int i = 0; i < A.n; ++i) {
+        double sum = 0.0;
+        for (int k = A.row_ptr[i]; k < A.row_ptr[i + 1]; ++k)
+            sum += A.val[k] * x[A.col[k]];
+        y[i] = sum;
+    }
+}
+
+// Плотная копия (по столбцам, нижний треугольник) для сравнения с dpotrf
+std::vector<double> band_to_dense(const BandMatrix& A) {
+    std::vector<double> dense((size_t)A.n * A.n, 0.0);
+    for (int j = 0; j < A.n; ++j)
+        for (int i = j; i <= std::min(A.n - 1, j + A.kd); ++i)
+            dense[i + (size_t)j * A.n] = A.ab[(i - j) + (size_t)j * (A.kd + 1)];
+    return dense;
+}
+
+std::vector<double> csr_to_dense(const CsrMatrix& A) {
+    std::vector<double> dense((size_t)A.n * A.n, 0.0);
+    for (int i = 0; i < A.n; ++i)
+        for (int k = A.row_ptr[i]; k < A.row_ptr[i + 1]; ++k)
+            if (A.col[k] >= i)
+                dense[A.col[k] + (size_t)i * A.n] = A.val[k];
+    return dense;
+}
+
+// Решение через PARDISO: анализ с упорядочением вложенными сечениями METIS,
+// численная факторизация и решение. PARDISO ожидает верхний треугольник в CSR.
+struct PardisoStats {
+    double analyze_seconds = 0.0;
+    size_t factor_nnz = 0;
+    size_t peak_kb = 0;
+};
+
+int pardiso_solve(const CsrMatrix& A, const double* b, double* x, PardisoStats& stats) {
+    std::vector<MKL_INT> ia(A.n + 1, 0), ja;
+    std::vector<double> a;
+    for (int i = 0; i < A.n; ++i) {
+        for (int k = A.row_ptr[i]; k < A.row_ptr[i + 1]; ++k)
+            if (A.col[k] >= i) {
+                ja.push_back(A.col[k]);
+                a.push_back(A.val[k]);
+            }
+        ia[i + 1] = MKL_INT(ja.size());
+    }
+
+    void* pt[64] = {};
+    MKL_INT iparm[64] = {};
+    iparm[0] = 1;     // параметры заданы явно
+    iparm[1] = 2;     // упорядочение METIS
+    iparm[9] = 8;     // возмущение ведущих элементов 1e-8
+    iparm[17] = -1;   // вернуть число ненулевых в множителе
+    iparm[34] = 1;    // индексация с нуля
+
+    MKL_INT maxfct = 1, mnum = 1, mtype = 2, nrhs = 1, msglvl = 0, error = 0;
+    MKL_INT n = A.n, phase;
+    double ddum = 0.0;
+    MKL_INT idum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    called_routines.push_back("pardiso_analyze");
+    phase = 11;
+    pardiso(pt, &maxfct, &mnum, &mtype, &phase, &n, a.data(), ia.data(), ja.data(),
+            &idum, &nrhs, iparm, &msglvl, &ddum, &ddum, &error);
+    stats.analyze_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (error == 0) {
+        called_routines.push_back("pardiso_factor");
+        phase = 22;
+        pardiso(pt, &maxfct, &mnum, &mtype, &phase, &n, a.data(), ia.data(), ja.data(),
+                &idum, &nrhs, iparm, &msglvl, &ddum, &ddum, &error);
+    }
+    if (error == 0) {
+        called_routines.push_back("pardiso_solve");
+        phase = 33;
+        pardiso(pt, &maxfct, &mnum, &mtype, &phase, &n, a.data(), ia.data(), ja.data(),
+                &idum, &nrhs, iparm, &msglvl, const_cast<double*>(b), x, &error);
+    }
+
+    stats.factor_nnz = size_t(iparm[17]);
+    stats.peak_kb = size_t(std::max(iparm[14], iparm[15] + iparm[16]));
+
+    phase = -1;
+    MKL_INT release_error = 0;
+    pardiso(pt, &maxfct, &mnum, &mtype, &phase, &n, &ddum, ia.data(), ja.data(),
+            &idum, &nrhs, iparm, &msglvl, &ddum, &ddum, &release_error);
+    return int(error);
+}
+
+// Тот же размер n через плотные dpotrf/dpotrs; возвращает время или -1 при ошибке
+double dense_solve(std::vector<double> dense, int n, const std::vector<double>& b, std::vector<double>& x) {
+    x = b;
+    auto start = std::chrono::steady_clock::now();
+    int info = LAPACKE_dpotrf(LAPACK_COL_MAJOR, 'L', n, dense.data(), n);
+    if (info == 0)
+        info = LAPACKE_dpotrs(LAPACK_COL_MAJOR, 'L', n, 1, dense.data(), n, x.data(), n);
+    auto end = std::chrono::steady_clock::now();
+    if (info != 0)
+        return -1.0;
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// Необязательные параметры вида --key=value
+std::map<std::string, std::string> parse_options(int argc, char* argv[], int first) {
+    std::map<std::string, std::string> options;
+    for (int i = first; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+            throw std::invalid_argument("Unknown argument: " + arg);
+        options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+    }
+    return options;
+}
+
+std::string option(const std::map<std::string, std::string>& options,
+                   const std::string& key, const std::string& fallback) {
+    auto it = options.find(key);
+    return it == options.end() ? fallback : it->second;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <matrix_size> [--format=sparse|banded] [--degree=8]"
+                  << " [--bandwidth=16] [--dense=1|0] [--dense-max-mb=4096]" << std::endl;
+        return 1;
+    }
+
+    int n = std::atoi(argv[1]);
+    if (n <= 0) {
+        std::cerr << "Matrix size must be positive" << std::endl;
+        return 1;
+    }
+
+    std::map<std::string, std::string> options;
+    try {
+        options = parse_options(argc, argv, 2);
+    } catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::string format = option(options, "format", "sparse");
+    if (format != "sparse" && format != "banded") {
+        std::cerr << "Unknown --format: " << format << std::endl;
+        return 1;
+    }
+    int degree = std::atoi(option(options, "degree", "8").c_str());
+    int kd = std::min(n - 1, std::atoi(option(options, "bandwidth", "16").c_str()));
+    bool compare_dense = option(options, "dense", "1") != "0";
+    // Плотная копия занимает n^2 double: сверх --dense-max-mb (и сверх 32-битных
+    // индексов LAPACK) сравнение пропускается с отметкой DIAG_DENSE=skipped
+    double dense_mb = double(n) * n * sizeof(double) / (1024.0 * 1024.0);
+    bool dense_skipped = compare_dense &&
+        (dense_mb > std::stod(option(options, "dense-max-mb", "4096")) ||
+         (sizeof(MKL_INT) < 8 && (long long)n * n > std::numeric_limits<MKL_INT>::max()));
+    if (dense_skipped)
+        compare_dense = false;
+
+    int num_threads = mkl_get_max_threads();
+
+    BandMatrix band;
+    CsrMatrix sparse;
+    size_t matrix_nnz;   // нижний треугольник с диагональю
+    if (format == "banded") {
+        band = create_banded_spd_matrix(n, kd, n);
+        matrix_nnz = size_t(kd + 1) * n - size_t(kd) * (kd + 1) / 2;
+    } else {
+        sparse = create_sparse_spd_matrix(n, degree, n);
+        matrix_nnz = (sparse.col.size() + n) / 2;
+    }
+
+    // Правая часть b = A * 1, точное решение – вектор из единиц
+    std::vector<double> ones(n, 1.0), b(n), x(n), Ax(n);
+    if (format == "banded")
+        band_multiply(band, ones.data(), b.data());
+    else
+        csr_multiply(sparse, ones.data(), b.data());
+
+    size_t factor_nnz;
+    size_t factor_bytes;
+    size_t work_bytes = 0;
+    double analyze_seconds = 0.0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    if (format == "banded") {
+        std::vector<double> factor = band.ab;
+        called_routines.push_back("dpbtrf");
+        int info = LAPACKE_dpbtrf(LAPACK_COL_MAJOR, 'L', n, kd, factor.data(), kd + 1);
+        if (info != 0) {
+            std::cerr << "Banded Cholesky factorization failed with code: " << info << std::endl;
+            return 1;
+        }
+
+        x = b;
+        called_routines.push_back("dpbtrs");
+        info = LAPACKE_dpbtrs(LAPACK_COL_MAJOR, 'L', n, kd, 1, factor.data(), kd + 1, x.data(), n);
+        if (info != 0) {
+            std::cerr << "Banded Cholesky solve failed with code: " << info << std::endl;
+            return 1;
+        }
+        factor_nnz = matrix_nnz;
+        factor_bytes = factor.size() * sizeof(double);
+    } else {
+        PardisoStats stats;
+        int error = pardiso_solve(sparse, b.data(), x.data(), stats);
+        if (error != 0) {
+            std::cerr << "PARDISO failed with error: " << error << std::endl;
+            return 1;
+        }
+
+        // PARDISO сообщает только суммарную память, множитель оцениваем по nnz
+        analyze_seconds = stats.analyze_seconds;
+        factor_nnz = stats.factor_nnz;
+        factor_bytes = factor_nnz * sizeof(double);
+        work_bytes = stats.peak_kb * 1024;
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = end - start;
+
+    // Относительная невязка ||b - A x|| / ||b||
+    if (format == "banded")
+        band_multiply(band, x.data(), Ax.data());
+    else
+        csr_multiply(sparse, x.data(), Ax.data());
+    double residual_sq = 0.0, b_sq = 0.0;
+    for (int i = 0; i < n; ++i) {
+        residual_sq += (b[i] - Ax[i]) * (b[i] - Ax[i]);
+        b_sq += b[i] * b[i];
+    }
+    double residual = std::sqrt(residual_sq / b_sq);
+
+    double dense_seconds = 0.0;
+    if (compare_dense) {
+        std::vector<double> x_dense;
+        dense_seconds = dense_solve(format == "banded" ? band_to_dense(band) : csr_to_dense(sparse), n, b, x_dense);
+        if (dense_seconds < 0.0) {
+            std::cerr << "Dense Cholesky factorization failed" << std::endl;
+            return 1;
+        }
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    long rss_kb = usage.ru_maxrss;
+
+    // Сумма значений разреженной матрицы всегда равна n (лапласиан плюс единичная
+    // диагональ), поэтому берётся квадратичная форма w^T A w с w_i = (i + 1) / n:
+    // она зависит от рёбер графа, а значит, и от seed
+    double checksum = 0.0;
+    if (format == "banded")
+        for (double v : band.ab) checksum += v;
+    else
+        for (int i = 0; i < n; ++i)
+            for (int k = sparse.row_ptr[i]; k < sparse.row_ptr[i + 1]; ++k)
+                checksum += sparse.val[k] * (i + 1.0) / n * (sparse.col[k] + 1.0) / n;
+
+    std::ostringstream routines_oss;
+    for (size_t i = 0; i < called_routines.size(); ++i) {
+        if (i) routines_oss << ',';
+        routines_oss << called_routines[i];
+    }
+
+    const double mb = 1024.0 * 1024.0;
+    std::cout << std::fixed << std::setprecision(9);
+    std::cout << "RESULT_SECONDS=" << elapsed.count() << std::endl;
+    std::cout << "DIAG_THREADS=mkl/libmkl_rt:" << num_threads << std::endl;
+    std::cout << "DIAG_PEAK_RSS_KB=" << rss_kb << std::endl;
+    std::cout << "DIAG_ROUTINES=" << routines_oss.str() << std::endl;
+    std::cout << "DIAG_FORMAT=" << format << std::endl;
+    std::cout << "DIAG_ANALYZE_SECONDS=" << analyze_seconds << std::endl;
+    if (compare_dense)
+        std::cout << "DIAG_DENSE_SECONDS=" << dense_seconds << std::endl;
+    else if (dense_skipped)
+        std::cout << "DIAG_DENSE=skipped" << std::endl;
+    std::cout << "DIAG_MATRIX_NNZ=" << matrix_nnz << std::endl;
+    std::cout << "DIAG_FACTOR_NNZ=" << factor_nnz << std::endl;
+    std::cout << "DIAG_DENSE_FACTOR_NNZ=" << size_t(n) * (n + 1) / 2 << std::endl;
+    std::cout << std::setprecision(3);
+    std::cout << "DIAG_FILL_RATIO=" << double(factor_nnz) / matrix_nnz << std::endl;
+    std::cout << "DIAG_FACTOR_MB=" << factor_bytes / mb << std::endl;
+    std::cout << "DIAG_WORK_MB=" << work_bytes / mb << std::endl;
+    std::cout << "DIAG_DENSE_MB=" << dense_mb << std::endl;
+    std::cout << std::scientific << std::setprecision(6);
+    std::cout << "DIAG_RESIDUAL=" << residual << std::endl;
+    std::cout << std::fixed;
+    std::cout << "DIAG_CHECKSUM=" << checksum << std::endl;
+
+    return 0;
+}
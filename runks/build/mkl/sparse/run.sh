@@ -0,0 +1,41 @@
+#!/bin/bash
+
+# Список контейнеров
+containers=(
+	"mkl_sparse"
+)
+
+# Форматы матриц: разреженный лапласиан и лента
+formats=(sparse banded)
+
+# Размеры матриц
+sizes=(2500 5000 7500 10000 12500 15000 17500 20000)
+
+# Количество запусков для каждого контейнера и размера
+runs=10
+
+# Запуск контейнеров
+for container in "${containers[@]}"; do
+    for format in "${formats[@]}"; do
+        for size in "${sizes[@]}"; do
+            # Создаем файл для вывода для текущего контейнера, формата и размера
+            output_file="${container}_${format}_size_${size}.txt"
+
+            for ((i=1; i<=runs; i++)); do
+                echo "Запуск контейнера $container ($format) с размером матрицы $size, запуск номер $i..."
+
+                container_id=$(docker run -d --rm "$container" "$size" --format="$format")
+
+                # Ожидаем завершения контейнера и записываем его вывод в файл
+                docker logs -f "$container_id" >> "$output_file"
+
+                # Ждем завершения контейнера
+                docker wait "$container_id"
+
+                echo "Вывод контейнера $container ($format) с размером матрицы $size, запуск номер $i добавлен в $output_file"
+            done
+        done
+    done
+done
+
+cd ../
@@ -0,0 +1,339 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <mkl.h>
+#include <sys/resource.h>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <map>
+#include <deque>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <cmath>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+// Потоковое обращение серии матриц: генерация, обращение и проверка перекрываются
+std::vector<std::string> called_routines;
+
+void fill_positive_definite_matrix(double* matrix, int n, int seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<> dis(0.0, 1.0);
+
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < n; ++j)
+            matrix[(size_t)i * n + j] = dis(gen);
+
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < i; ++j) {
+            double avg = (matrix[(size_t)i * n + j] + matrix[(size_t)j * n + i]) / 2.0;
+            matrix[(size_t)i * n + j] = matrix[(size_t)j * n + i] = avg;
+        }
+    }
+    for (int i = 0; i < n; ++i)
+        matrix[(size_t)i * n + i] += n;
+}
+
+// Необязательные параметры вида --key=value
+std::map<std::string, std::string> parse_options(int argc, char* argv[], int first) {
+    std::map<std::string, std::string> options;
+    for (int i = first; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+            throw std::invalid_argument("Unknown argument: " + arg);
+        options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+    }
+    return options;
+}
+
+std::string option(const std::map<std::string, std::string>& options,
+                   const std::string& key, const std::string& fallback) {
+    auto it = options.find(key);
+    return it == options.end() ? fallback : it->second;
+}
+
+// Невязка ||A (X v) - v|| / (||A||_F ||X||_F ||v||) на случайном векторе v
+double probe_residual(const double* A, const double* X, int n) {
+    std::mt19937 gen(n + 2);
+    std::uniform_real_distribution<> dis(-1.0, 1.0);
+    std::vector<double> v(n), Xv(n), r(n);
+    for (double& x : v)
+        x = dis(gen);
+
+    cblas_dgemv(CblasRowMajor, CblasNoTrans, n, n, 1.0, X, n, v.data(), 1, 0.0, Xv.data(), 1);
+    r = v;
+    cblas_dgemv(CblasRowMajor, CblasNoTrans, n, n, 1.0, A, n, Xv.data(), 1, -1.0, r.data(), 1);
+
+    double norm_A = cblas_dnrm2((size_t)n * n, A, 1);
+    double norm_X = cblas_dnrm2((size_t)n * n, X, 1);
+    return cblas_dnrm2(n, r.data(), 1) / (norm_A * norm_X * cblas_dnrm2(n, v.data(), 1));
+}
+
+// Буфер кольца: исходная матрица, её обращаемая копия и результат проверки
+struct Slot {
+    int index = -1;
+    std::vector<double> matrix;
+    std::vector<double> inverse;
+    std::vector<lapack_int> ipiv;
+    int info = 0;
+};
+
+// Блокирующая очередь номеров буферов; close() будит ожидающих
+class SlotQueue {
+public:
+    void push(int slot) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            slots.push_back(slot);
+        }
+        ready.notify_one();
+    }
+
+    // -1 – очередь закрыта и пуста
+    int pop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [this] { return !slots.empty() || closed; });
+        if (slots.empty())
+            return -1;
+        int slot = slots.front();
+        slots.pop_front();
+        return slot;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        ready.notify_all();
+    }
+
+private:
+    std::deque<int> slots;
+    bool closed = false;
+    std::mutex mutex;
+    std::condition_variable ready;
+};
+
+// Время работы стадии без ожидания очередей
+struct StageTimer {
+    double busy = 0.0;
+    std::chrono::steady_clock::time_point started;
+
+    void begin() { started = std::chrono::steady_clock::now(); }
+    void end() { busy += std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count(); }
+};
+
+int invert(Slot& slot, int n, const std::string& op) {
+    if (op == "cholesky") {
+        int info = LAPACKE_dpotrf(LAPACK_ROW_MAJOR, 'L', n, slot.inverse.data(), n);
+        if (info == 0)
+            info = LAPACKE_dpotri(LAPACK_ROW_MAJOR, 'L', n, slot.inverse.data(), n);
+        if (info != 0)
+            return info;
+        for (int i = 0; i < n; ++i)
+            for (int j = i + 1; j < n; ++j)
+                slot.inverse[(size_t)i * n + j] = slot.inverse[(size_t)j * n + i];
+        return 0;
+    }
+    int info = LAPACKE_dgetrf(LAPACK_ROW_MAJOR, n, n, slot.inverse.data(), n, slot.ipiv.data());
+    if (info == 0)
+        info = LAPACKE_dgetri(LAPACK_ROW_MAJOR, n, slot.inverse.data(), n, slot.ipiv.data());
+    return info;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Использование: " << argv[0] << " <размер матрицы> [--matrices=16] [--ring=3] [--op=cholesky|lu]"
+                  << " [--mode=pipeline|serial] [--consumer=verify|write] [--output=path]" << std::endl;
+        return 1;
+    }
+
+    int n = std::stoi(argv[1]);
+    // С 32-битным MKL_INT n*n элементов не адресуются при n > 46340
+    if (sizeof(MKL_INT) < 8 && (long long)n * n > std::numeric_limits<MKL_INT>::max()) {
+        std::cerr << "Matrix size too large for 32-bit MKL_INT (n > 46340)" << std::endl;
+        return 1;
+    }
+
+    std::map<std::string, std::string> options;
+    try {
+        options = parse_options(argc, argv, 2);
+    } catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    int matrices = std::max(1, std::stoi(option(options, "matrices", "16")));
+    // Три буфера: один генерируется, один обращается, один проверяется
+    int ring = std::max(1, std::stoi(option(options, "ring", "3")));
+    std::string op = option(options, "op", "cholesky");
+    std::string mode = option(options, "mode", "pipeline");
+    std::string consumer = option(options, "consumer", "verify");
+    std::string output_path = option(options, "output", "stream_inverses.bin");
+    if (op != "cholesky" && op != "lu") {
+        std::cerr << "Unknown --op: " << op << std::endl;
+        return 1;
+    }
+    if (mode != "pipeline" && mode != "serial") {
+        std::cerr << "Unknown --mode: " << mode << std::endl;
+        return 1;
+    }
+    if (consumer != "verify" && consumer != "write") {
+        std::cerr << "Unknown --consumer: " << consumer << std::endl;
+        return 1;
+    }
+    if (mode == "serial")
+        ring = 1;
+
+    // Получаем текущее число потоков MKL
+    int num_threads = mkl_get_max_threads();
+
+    if (op == "cholesky") {
+        called_routines.push_back("dpotrf");
+        called_routines.push_back("dpotri");
+    } else {
+        called_routines.push_back("dgetrf");
+        called_routines.push_back("dgetri");
+    }
+    if (consumer == "verify")
+        called_routines.push_back("dgemv");
+
+    // Буферы выделяются один раз до таймера
+    std::vector<Slot> slots(ring);
+    for (Slot& slot : slots) {
+        slot.matrix.resize((size_t)n * n);
+        slot.inverse.resize((size_t)n * n);
+        if (op == "lu")
+            slot.ipiv.resize(n);
+    }
+
+    std::ofstream output;
+    if (consumer == "write") {
+        output.open(output_path, std::ios::binary);
+        if (!output) {
+            std::cerr << "Не удалось открыть файл: " << output_path << std::endl;
+            return 1;
+        }
+    }
+
+    StageTimer generate_timer, invert_timer, verify_timer;
+    double checksum = 0.0;
+    double max_residual = 0.0;
+    int failed = 0;
+
+    auto produce = [&](Slot& slot, int index) {
+        generate_timer.begin();
+        slot.index = index;
+        fill_positive_definite_matrix(slot.matrix.data(), n, n + index);
+        std::copy(slot.matrix.begin(), slot.matrix.end(), slot.inverse.begin());
+        generate_timer.end();
+    };
+
+    auto consume = [&](Slot& slot) {
+        verify_timer.begin();
+        if (slot.info != 0) {
+            ++failed;
+        } else if (consumer == "verify") {
+            max_residual = std::max(max_residual, probe_residual(slot.matrix.data(), slot.inverse.data(), n));
+        } else {
+            output.write(reinterpret_cast<const char*>(slot.inverse.data()), slot.inverse.size() * sizeof(double));
+        }
+        for (double v : slot.matrix)
+            checksum += v;
+        verify_timer.end();
+    };
+
+    auto start = std::chrono::steady_clock::now();
+
+    if (mode == "serial") {
+        for (int index = 0; index < matrices; ++index) {
+            produce(slots[0], index);
+            invert_timer.begin();
+            slots[0].info = invert(slots[0], n, op);
+            invert_timer.end();
+            consume(slots[0]);
+        }
+    } else {
+        // Буфер проходит free -> generated -> inverted -> free; обращение
+        // матрицы i идёт в основном потоке (с потоками BLAS), генерация i+1
+        // и проверка i-1 – в двух отдельных потоках
+        SlotQueue free_slots, generated, inverted;
+        for (int s = 0; s < ring; ++s)
+            free_slots.push(s);
+
+        std::thread producer([&] {
+            for (int index = 0; index < matrices; ++index) {
+                int s = free_slots.pop();
+                produce(slots[s], index);
+                generated.push(s);
+            }
+            generated.close();
+        });
+        std::thread verifier([&] {
+            for (int s = inverted.pop(); s != -1; s = inverted.pop()) {
+                consume(slots[s]);
+                free_slots.push(s);
+            }
+        });
+
+        for (int s = generated.pop(); s != -1; s = generated.pop()) {
+            invert_timer.begin();
+            slots[s].info = invert(slots[s], n, op);
+            invert_timer.end();
+            inverted.push(s);
+        }
+        inverted.close();
+        producer.join();
+        verifier.join();
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    std::chrono::duration<double> diff = end - start;
+
+    if (failed != 0) {
+        std::cerr << "Ошибка обращения для " << failed << " матриц" << std::endl;
+        return 1;
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    long rss_kb = usage.ru_maxrss;
+
+    std::ostringstream routines_oss;
+    for (size_t i = 0; i < called_routines.size(); ++i) {
+        if (i) routines_oss << ',';
+        routines_oss << called_routines[i];
+    }
+
+    double wall = diff.count();
+    std::cout << std::fixed << std::setprecision(9);
+    std::cout << "RESULT_SECONDS=" << wall << std::endl;
+    std::cout << "DIAG_THREADS=mkl/libmkl_rt:" << num_threads << std::endl;
+    std::cout << "DIAG_PEAK_RSS_KB=" << rss_kb << std::endl;
+    std::cout << "DIAG_ROUTINES=" << routines_oss.str() << std::endl;
+    std::cout << "DIAG_MODE=" << mode << ":" << op << ":" << ring << std::endl;
+    std::cout << "DIAG_MATRICES=" << matrices << std::endl;
+    std::cout << std::setprecision(6);
+    std::cout << "DIAG_MATRICES_PER_SEC=" << matrices / wall << std::endl;
+    // Доля времени стадии от общего времени; у обращения близко к 1 – конвейер не простаивает
+    std::cout << "DIAG_STAGE_BUSY=generate:" << generate_timer.busy / wall
+              << ",invert:" << invert_timer.busy / wall
+              << "," << consumer << ":" << verify_timer.busy / wall << std::endl;
+    std::cout << "DIAG_STAGE_SECONDS=generate:" << generate_timer.busy
+              << ",invert:" << invert_timer.busy
+              << "," << consumer << ":" << verify_timer.busy << std::endl;
+    if (consumer == "verify") {
+        std::cout << std::scientific;
+        std::cout << "DIAG_RESIDUAL=" << max_residual << std::endl;
+        std::cout << std::fixed;
+    }
+    std::cout << "DIAG_CHECKSUM=" << checksum << std::endl;
+
+    return 0;
+}
@@ -19,6 +19,8 @@ build_container() {
 
 
 build_container "mkl_svd" "Dockerfile.mklsvd"
+# 64-битные индексы для n > 46340
+build_container "mkl_svd_ilp64" "Dockerfile.mklsvd_ilp64"
 
 
 cd ../
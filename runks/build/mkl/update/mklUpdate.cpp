@@ -0,0 +1,379 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <mkl.h>
+#include <sys/resource.h>
+#include <string>
+#include <sstream>
+#include <map>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <cmath>
+// Обновление и понижение ранга k готового разложения Холецкого и обратной матрицы
+std::vector<std::string> called_routines;
+
+std::vector<double> create_positive_definite_matrix(int n, int seed) {
+    std::vector<double> matrix((size_t)n * n);
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<> dis(0.0, 1.0);
+
+    for (int i = 0; i < n; ++i)
+        for (int j = 0; j < n; ++j)
+            matrix[(size_t)i * n + j] = dis(gen);
+
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < i; ++j) {
+            double avg = (matrix[(size_t)i * n + j] + matrix[(size_t)j * n + i]) / 2.0;
+            matrix[(size_t)i * n + j] = matrix[(size_t)j * n + i] = avg;
+        }
+    }
+    for (int i = 0; i < n; ++i)
+        matrix[(size_t)i * n + i] += n;
+
+    return matrix;
+}
+
+// Необязательные параметры вида --key=value
+std::map<std::string, std::string> parse_options(int argc, char* argv[], int first) {
+    std::map<std::string, std::string> options;
+    for (int i = first; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+            throw std::invalid_argument("Unknown argument: " + arg);
+        options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+    }
+    return options;
+}
+
+std::string option(const std::map<std::string, std::string>& options,
+                   const std::string& key, const std::string& fallback) {
+    auto it = options.find(key);
+    return it == options.end() ? fallback : it->second;
+}
+
+// Разложение A = R^T R (R – верхний треугольник, построчно), которое
+// переживает изменения A + sign * V V^T ранга k за O(k n^2).
+// Множитель обновляется вращениями, обратная X = A^{-1} (если нужна) –
+// по формуле Шермана-Моррисона-Вудбери. Сама A тоже хранится: по ней
+// каждые check_every изменений проверяется дрейф и при потере точности
+// выполняется полная рефакторизация
+class IncrementalCholesky {
+public:
+    IncrementalCholesky(int n, bool track_inverse, int check_every, double drift_tol)
+        : n(n), track_inverse(track_inverse), check_every(check_every), drift_tol(drift_tol) {}
+
+    int factorize(const std::vector<double>& matrix) {
+        A = matrix;
+        return refactorize();
+    }
+
+    // A += sign * V V^T, V – n x k построчно; sign = 1 – добавление, -1 – удаление
+    int update(const double* V, int k, int sign) {
+        cblas_dsyrk(CblasRowMajor, CblasUpper, CblasNoTrans, n, k, sign, V, k, 1.0, A.data(), n);
+
+        bool ok = true;
+        std::vector<double> x(n);
+        for (int j = 0; j < k && ok; ++j) {
+            for (int i = 0; i < n; ++i)
+                x[i] = V[(size_t)i * k + j];
+            ok = rank_one(x.data(), sign);
+        }
+        // Понижение ранга могло потерять положительную определённость
+        // из-за накопленной ошибки – тогда множитель строится заново
+        if (!ok)
+            return refactorize();
+
+        // Вырожденная или плохо обусловленная ёмкостная матрица испортила бы X
+        // до следующей проверки дрейфа – обратная строится заново сразу
+        if (track_inverse && woodbury(V, k, sign) != 0)
+            return refactorize();
+
+        if (check_every > 0 && ++since_check >= check_every) {
+            since_check = 0;
+            if (factor_drift() > drift_tol || (track_inverse && inverse_drift() > drift_tol))
+                return refactorize();
+        }
+        return 0;
+    }
+
+    // ||R^T R v - A v|| / (||A||_F ||v||) на случайном векторе
+    double factor_drift() {
+        std::vector<double> v = probe(), Rv = v, Av(n);
+        cblas_dtrmv(CblasRowMajor, CblasUpper, CblasNoTrans, CblasNonUnit, n, R.data(), n, Rv.data(), 1);
+        cblas_dtrmv(CblasRowMajor, CblasUpper, CblasTrans, CblasNonUnit, n, R.data(), n, Rv.data(), 1);
+        cblas_dsymv(CblasRowMajor, CblasUpper, n, 1.0, A.data(), n, v.data(), 1, 0.0, Av.data(), 1);
+        cblas_daxpy(n, -1.0, Av.data(), 1, Rv.data(), 1);
+        return cblas_dnrm2(n, Rv.data(), 1) / (frobenius_upper(A) * cblas_dnrm2(n, v.data(), 1));
+    }
+
+    // ||A (X v) - v|| / (||A||_F ||X||_F ||v||) на случайном векторе
+    double inverse_drift() {
+        std::vector<double> v = probe(), Xv(n), r = v;
+        cblas_dgemv(CblasRowMajor, CblasNoTrans, n, n, 1.0, X.data(), n, v.data(), 1, 0.0, Xv.data(), 1);
+        cblas_dsymv(CblasRowMajor, CblasUpper, n, 1.0, A.data(), n, Xv.data(), 1, -1.0, r.data(), 1);
+        double norm_X = cblas_dnrm2((size_t)n * n, X.data(), 1);
+        return cblas_dnrm2(n, r.data(), 1) / (frobenius_upper(A) * norm_X * cblas_dnrm2(n, v.data(), 1));
+    }
+
+    int refactorizations() const { return refactor_count; }
+
+private:
+    int refactorize() {
+        ++refactor_count;
+        since_check = 0;
+        R = A;
+        int info = LAPACKE_dpotrf(LAPACK_ROW_MAJOR, 'U', n, R.data(), n);
+        if (info != 0)
+            return info;
+        for (int i = 1; i < n; ++i)
+            std::fill(R.begin() + (size_t)i * n, R.begin() + (size_t)i * n + i, 0.0);
+
+        if (track_inverse) {
+            X = R;
+            info = LAPACKE_dpotri(LAPACK_ROW_MAJOR, 'U', n, X.data(), n);
+            if (info != 0)
+                return info;
+            for (int i = 0; i < n; ++i)
+                for (int j = i + 1; j < n; ++j)
+                    X[(size_t)j * n + i] = X[(size_t)i * n + j];
+        }
+        return 0;
+    }
+
+    // Обновление (sign = 1) или понижение (sign = -1) ранга 1: R^T R + sign x x^T.
+    // Строка k множителя – это столбец k нижнего треугольника, поэтому
+    // внутренний цикл идёт по непрерывной памяти
+    bool rank_one(double* x, int sign) {
+        for (int k = 0; k < n; ++k) {
+            double* row = R.data() + (size_t)k * n;
+            double d = row[k] * row[k] + sign * x[k] * x[k];
+            if (d <= 0.0)
+                return false;
+            double r = std::sqrt(d);
+            double c = r / row[k];
+            double s = x[k] / row[k];
+            row[k] = r;
+            for (int i = k + 1; i < n; ++i) {
+                row[i] = (row[i] + sign * s * x[i]) / c;
+                x[i] = c * x[i] - s * row[i];
+            }
+        }
+        return true;
+    }
+
+    // (A + sign V V^T)^{-1} = X - X V (sign I + V^T X V)^{-1} V^T X.
+    // Не 0, если ёмкостная матрица вырождена (info dgesv) или её rcond
+    // меньше машинного эпсилон; X тогда не меняется
+    int woodbury(const double* V, int k, int sign) {
+        W.resize((size_t)n * k);
+        T.resize((size_t)k * n);
+        S.resize((size_t)k * k);
+        ipiv.resize(k);
+
+        cblas_dsymm(CblasRowMajor, CblasLeft, CblasUpper, n, k, 1.0, X.data(), n, V, k, 0.0, W.data(), k);
+        cblas_dgemm(CblasRowMajor, CblasTrans, CblasNoTrans, k, k, n, 1.0, V, k, W.data(), k, 0.0, S.data(), k);
+        for (int i = 0; i < k; ++i)
+            S[(size_t)i * k + i] += sign;
+
+        for (int i = 0; i < n; ++i)
+            for (int j = 0; j < k; ++j)
+                T[(size_t)j * n + i] = W[(size_t)i * k + j];
+        double norm_S = LAPACKE_dlange(LAPACK_ROW_MAJOR, '1', k, k, S.data(), k);
+        int info = LAPACKE_dgesv(LAPACK_ROW_MAJOR, k, n, S.data(), k, ipiv.data(), T.data(), n);
+        if (info != 0)
+            return info;
+        double rcond = 0.0;
+        LAPACKE_dgecon(LAPACK_ROW_MAJOR, '1', k, S.data(), k, norm_S, &rcond);
+        if (rcond < std::numeric_limits<double>::epsilon())
+            return -1;
+
+        cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasNoTrans, n, n, k, -1.0, W.data(), k, T.data(), n,
+                    1.0, X.data(), n);
+        return 0;
+    }
+
+    std::vector<double> probe() {
+        std::uniform_real_distribution<> dis(-1.0, 1.0);
+        std::vector<double> v(n);
+        for (double& x : v)
+            x = dis(probe_gen);
+        return v;
+    }
+
+    // В A достоверен только верхний треугольник
+    double frobenius_upper(const std::vector<double>& M) const {
+        double sum = 0.0;
+        for (int i = 0; i < n; ++i) {
+            sum += M[(size_t)i * n + i] * M[(size_t)i * n + i];
+            for (int j = i + 1; j < n; ++j)
+                sum += 2.0 * M[(size_t)i * n + j] * M[(size_t)i * n + j];
+        }
+        return std::sqrt(sum);
+    }
+
+    int n;
+    bool track_inverse;
+    int check_every;
+    double drift_tol;
+    int since_check = 0;
+    int refactor_count = 0;
+    std::mt19937 probe_gen{7};
+    std::vector<double> A, R, X;
+    std::vector<double> W, T, S;
+    std::vector<lapack_int> ipiv;
+};
+
+// Поток изменений: на чётных шагах добавляется новый член V V^T ранга k,
+// на нечётных удаляется добавленный на предыдущем шаге
+struct UpdateStream {
+    int n, rank;
+    std::mt19937 gen;
+    std::vector<double> last;
+
+    UpdateStream(int n, int rank, int seed) : n(n), rank(rank), gen(seed) {}
+
+    int next(int step, std::vector<double>& V) {
+        if (step % 2 == 1) {
+            V = last;
+            return -1;
+        }
+        std::uniform_real_distribution<> dis(-1.0, 1.0);
+        V.resize((size_t)n * rank);
+        for (double& x : V)
+            x = dis(gen);
+        last = V;
+        return 1;
+    }
+};
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Использование: " << argv[0] << " <размер матрицы> [--rank=1] [--updates=200] [--inverse=1|0]"
+                  << " [--check-every=16] [--drift-tol=1e-10] [--baseline=10]" << std::endl;
+        return 1;
+    }
+
+    int n = std::stoi(argv[1]);
+    // С 32-битным MKL_INT n*n элементов не адресуются при n > 46340
+    if (sizeof(MKL_INT) < 8 && (long long)n * n > std::numeric_limits<MKL_INT>::max()) {
+        std::cerr << "Matrix size too large for 32-bit MKL_INT (n > 46340)" << std::endl;
+        return 1;
+    }
+
+    std::map<std::string, std::string> options;
+    try {
+        options = parse_options(argc, argv, 2);
+    } catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    int rank = std::max(1, std::stoi(option(options, "rank", "1")));
+    int updates = std::max(1, std::stoi(option(options, "updates", "200")));
+    bool track_inverse = (option(options, "inverse", "1") != "0");
+    int check_every = std::stoi(option(options, "check-every", "16"));
+    double drift_tol = std::stod(option(options, "drift-tol", "1e-10"));
+    // Для сравнения полная рефакторизация на каждом изменении – только
+    // на первых baseline изменениях потока, иначе она занимает часы
+    int baseline = std::min(updates, std::max(1, std::stoi(option(options, "baseline", "10"))));
+
+    std::vector<double> matrix = create_positive_definite_matrix(n, n);
+
+    // Получаем текущее число потоков MKL
+    int num_threads = mkl_get_max_threads();
+
+    IncrementalCholesky factor(n, track_inverse, check_every, drift_tol);
+    called_routines.push_back("dpotrf");
+    if (track_inverse)
+        called_routines.push_back("dpotri");
+    if (factor.factorize(matrix) != 0) {
+        std::cerr << "Ошибка при выполнении dpotrf" << std::endl;
+        return 1;
+    }
+
+    called_routines.push_back("dsyrk");
+    if (track_inverse) {
+        called_routines.push_back("dsymm");
+        called_routines.push_back("dgemm");
+        called_routines.push_back("dgesv");
+        called_routines.push_back("dgecon");
+    }
+
+    UpdateStream stream(n, rank, n + 1);
+    std::vector<double> V;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int step = 0; step < updates; ++step) {
+        int sign = stream.next(step, V);
+        if (factor.update(V.data(), rank, sign) != 0) {
+            std::cerr << "Ошибка при обновлении разложения на шаге " << step << std::endl;
+            return 1;
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    std::chrono::duration<double> diff = end - start;
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    long rss_kb = usage.ru_maxrss;
+
+    double factor_drift = factor.factor_drift();
+    double inverse_drift = track_inverse ? factor.inverse_drift() : 0.0;
+
+    // Тот же поток с полной рефакторизацией на каждом изменении
+    UpdateStream replay(n, rank, n + 1);
+    std::vector<double> A = matrix, work(matrix.size());
+    auto baseline_start = std::chrono::steady_clock::now();
+    for (int step = 0; step < baseline; ++step) {
+        int sign = replay.next(step, V);
+        cblas_dsyrk(CblasRowMajor, CblasUpper, CblasNoTrans, n, rank, sign, V.data(), rank, 1.0, A.data(), n);
+        work = A;
+        int info = LAPACKE_dpotrf(LAPACK_ROW_MAJOR, 'U', n, work.data(), n);
+        if (info == 0 && track_inverse)
+            info = LAPACKE_dpotri(LAPACK_ROW_MAJOR, 'U', n, work.data(), n);
+        if (info != 0) {
+            std::cerr << "Ошибка при полной рефакторизации" << std::endl;
+            return 1;
+        }
+    }
+    std::chrono::duration<double> baseline_diff = std::chrono::steady_clock::now() - baseline_start;
+
+    double updates_per_sec = updates / diff.count();
+    double refactor_per_sec = baseline / baseline_diff.count();
+
+    double checksum = 0.0;
+    for (double v : matrix)
+        checksum += v;
+
+    std::ostringstream routines_oss;
+    for (size_t i = 0; i < called_routines.size(); ++i) {
+        if (i) routines_oss << ',';
+        routines_oss << called_routines[i];
+    }
+
+    std::cout << std::fixed << std::setprecision(9);
+    std::cout << "RESULT_SECONDS=" << diff.count() << std::endl;
+    std::cout << "DIAG_THREADS=mkl/libmkl_rt:" << num_threads << std::endl;
+    std::cout << "DIAG_PEAK_RSS_KB=" << rss_kb << std::endl;
+    std::cout << "DIAG_ROUTINES=" << routines_oss.str() << std::endl;
+    std::cout << "DIAG_UPDATES=" << updates << "x" << rank << std::endl;
+    std::cout << "DIAG_UPDATES_PER_SEC=" << updates_per_sec << std::endl;
+    std::cout << "DIAG_REFACTOR_PER_SEC=" << refactor_per_sec << std::endl;
+    std::cout << "DIAG_SPEEDUP=" << updates_per_sec / refactor_per_sec << std::endl;
+    // Первая факторизация тоже считается
+    std::cout << "DIAG_REFACTORIZATIONS=" << factor.refactorizations() - 1 << std::endl;
+    std::cout << std::scientific << std::setprecision(6);
+    std::cout << "DIAG_FACTOR_DRIFT=" << factor_drift << std::endl;
+    if (track_inverse)
+        std::cout << "DIAG_RESIDUAL=" << inverse_drift << std::endl;
+    std::cout << std::fixed;
+    std::cout << "DIAG_CHECKSUM=" << checksum << std::endl;
+
+    return 0;
+}